@@ -0,0 +1,275 @@
+/* chirurgien-benchmark.c
+ *
+ * Copyright (C) 2021 - Daniel Léonard Schardijn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#ifdef G_OS_UNIX
+#include <sys/resource.h>
+#endif
+
+#include <gio/gio.h>
+
+#include <chirurgien-formats.h>
+
+#include "corpus-generator.h"
+
+/* Identifications timed to measure the identification latency */
+#define IDENTIFY_ITERATIONS 1000
+
+
+/* The peak resident set size is reset (Linux only) before each format */
+static void
+benchmark_reset_peak_rss (void)
+{
+    FILE *clear_refs;
+
+    clear_refs = fopen ("/proc/self/clear_refs", "w");
+
+    if (clear_refs)
+    {
+        fputs ("5", clear_refs);
+        fclose (clear_refs);
+    }
+}
+
+/* Peak resident set size, in KiB */
+static guint64
+benchmark_peak_rss (void)
+{
+    g_autofree gchar *status = NULL;
+    const gchar *peak;
+
+    if (g_file_get_contents ("/proc/self/status", &status, NULL, NULL) &&
+        (peak = strstr (status, "VmHWM:")))
+        return g_ascii_strtoull (peak + strlen ("VmHWM:"), NULL, 10);
+
+#ifdef G_OS_UNIX
+    struct rusage usage;
+
+    if (!getrusage (RUSAGE_SELF, &usage))
+        return usage.ru_maxrss;
+#endif
+
+    return 0;
+}
+
+/*
+ * Benchmarks a generator's input, writing a JSON line to output
+ * Returns FALSE if the input was not identified as its format
+ */
+static gboolean
+benchmark_run (const CorpusGenerator *generator,
+               gdouble                scale,
+               gint                   iterations,
+               FILE                  *output)
+{
+    ProcessorFile *processor_file;
+    const FormatDefinition *format_definition;
+    GBytes *input;
+
+    gconstpointer contents;
+    gsize contents_size;
+
+    gint64 start, elapsed, best_elapsed;
+    gdouble identify_ns, seconds;
+    guint steps_executed, n_fields;
+    gboolean identified;
+
+    benchmark_reset_peak_rss ();
+
+    input = corpus_generate (generator, scale);
+    contents = g_bytes_get_data (input, &contents_size);
+
+    processor_file = processor_file_create (contents, contents_size, NULL);
+
+    /* Identification latency */
+    start = g_get_monotonic_time ();
+    for (guint i = 0; i < IDENTIFY_ITERATIONS; i++)
+    {
+        processor_file_reset (processor_file, contents, contents_size);
+        format_definition = chirurgien_formats_identify (processor_file);
+    }
+    identify_ns = (g_get_monotonic_time () - start) * 1000.0 / IDENTIFY_ITERATIONS;
+
+    identified = !g_strcmp0 (chirurgien_formats_get_name (format_definition),
+                             generator->format_name);
+
+    /* The first analysis completes the format definition, it is not timed */
+    processor_file_reset (processor_file, contents, contents_size);
+    chirurgien_formats_process (format_definition, processor_file);
+
+    best_elapsed = G_MAXINT64;
+    for (gint i = 0; i < iterations; i++)
+    {
+        processor_file_reset (processor_file, contents, contents_size);
+
+        start = g_get_monotonic_time ();
+        chirurgien_formats_process (format_definition, processor_file);
+        elapsed = g_get_monotonic_time () - start;
+
+        best_elapsed = MIN (best_elapsed, elapsed);
+    }
+
+    processor_file_get_progress (processor_file, NULL, &steps_executed);
+    n_fields = processor_file_get_n_fields (processor_file);
+    seconds = MAX (best_elapsed, 1) / (gdouble) G_USEC_PER_SEC;
+
+    fprintf (output,
+             "{\"format\":\"%s\",\"identified\":%s,\"input_size\":%" G_GSIZE_FORMAT ","
+             "\"identify_ns\":%.1f,\"seconds\":%.6f,\"steps\":%u,\"steps_per_second\":%.0f,"
+             "\"fields\":%u,\"fields_per_second\":%.0f,\"peak_rss_kib\":%" G_GUINT64_FORMAT "}\n",
+             generator->name,
+             identified ? "true" : "false",
+             contents_size,
+             identify_ns,
+             seconds,
+             steps_executed,
+             steps_executed / seconds,
+             n_fields,
+             n_fields / seconds,
+             benchmark_peak_rss ());
+    fflush (output);
+
+    processor_file_destroy (processor_file);
+    g_bytes_unref (input);
+
+    return identified;
+}
+
+/* Writes the generated inputs to a directory, to be analyzed or scanned elsewhere */
+static gboolean
+benchmark_write_corpus (const gchar *corpus_path,
+                        gdouble      scale)
+{
+    GBytes *input;
+    g_autofree gchar *file_path = NULL;
+    gchar *file_name;
+
+    GError *error = NULL;
+
+    if (g_mkdir_with_parents (corpus_path, 0755))
+    {
+        g_printerr ("Cannot create %s\n", corpus_path);
+        return FALSE;
+    }
+
+    for (guint i = 0; i < corpus_n_generators; i++)
+    {
+        input = corpus_generate (&corpus_generators[i], scale);
+
+        file_name = g_strconcat ("synthetic.", corpus_generators[i].name, NULL);
+        g_free (file_path);
+        file_path = g_build_filename (corpus_path, file_name, NULL);
+        g_free (file_name);
+
+        if (!g_file_set_contents (file_path,
+                                  g_bytes_get_data (input, NULL),
+                                  g_bytes_get_size (input),
+                                  &error))
+        {
+            g_printerr ("%s\n", error->message);
+            g_error_free (error);
+            g_bytes_unref (input);
+
+            return FALSE;
+        }
+
+        g_bytes_unref (input);
+    }
+
+    return TRUE;
+}
+
+gint
+main (gint   argc,
+      gchar *argv[])
+{
+    GOptionContext *option_context;
+    FILE *output;
+
+    gdouble scale = 1.0;
+    gint iterations = 3;
+    g_autofree gchar *only = NULL;
+    g_autofree gchar *corpus_path = NULL;
+    g_autofree gchar *output_path = NULL;
+
+    gboolean all_identified;
+    GError *error = NULL;
+
+    const GOptionEntry options[] =
+    {
+        { "scale", 's', 0, G_OPTION_ARG_DOUBLE, &scale,
+          "Scale of the generated inputs, 1 by default", "SCALE" },
+        { "iterations", 'i', 0, G_OPTION_ARG_INT, &iterations,
+          "Timed analyses per format, the fastest is reported", "N" },
+        { "only", 0, 0, G_OPTION_ARG_STRING, &only,
+          "Only benchmark the format FORMAT (cpio, elf, gif, jpeg, pe, png, tar, tiff or webp)", "FORMAT" },
+        { "corpus", 0, 0, G_OPTION_ARG_FILENAME, &corpus_path,
+          "Write the generated inputs to DIRECTORY instead", "DIRECTORY" },
+        { "output", 'o', 0, G_OPTION_ARG_FILENAME, &output_path,
+          "Write the results (JSON Lines) to FILE instead of the standard output", "FILE" },
+        { NULL }
+    };
+
+    option_context = g_option_context_new ("- benchmark the format processor");
+    g_option_context_add_main_entries (option_context, options, NULL);
+
+    if (!g_option_context_parse (option_context, &argc, &argv, &error))
+    {
+        g_printerr ("%s\n", error->message);
+        g_error_free (error);
+        g_option_context_free (option_context);
+
+        return 1;
+    }
+
+    g_option_context_free (option_context);
+
+    if (scale <= 0 || iterations < 1)
+    {
+        g_printerr ("The scale and the iterations must be positive\n");
+        return 1;
+    }
+
+    if (corpus_path)
+        return benchmark_write_corpus (corpus_path, scale) ? 0 : 1;
+
+    output = output_path ? fopen (output_path, "w") : stdout;
+
+    if (!output)
+    {
+        g_printerr ("Cannot open %s\n", output_path);
+        return 1;
+    }
+
+    chirurgien_formats_initialize_system ();
+
+    all_identified = TRUE;
+    for (guint i = 0; i < corpus_n_generators; i++)
+    {
+        if (only && g_strcmp0 (only, corpus_generators[i].name))
+            continue;
+
+        all_identified &= benchmark_run (&corpus_generators[i], scale, iterations, output);
+    }
+
+    if (output != stdout)
+        fclose (output);
+
+    return all_identified ? 0 : 1;
+}
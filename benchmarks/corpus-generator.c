@@ -0,0 +1,557 @@
+/* corpus-generator.c
+ *
+ * Copyright (C) 2021 - Daniel Léonard Schardijn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "corpus-generator.h"
+
+#include <string.h>
+
+/*
+ * Synthetic inputs for the bundled formats: valid files made of a single
+ * structure repeated count times, so that the analysis cost scales with count
+ */
+
+
+static void
+put_u8 (GByteArray *output,
+        guint8      value)
+{
+    g_byte_array_append (output, &value, 1);
+}
+
+static void
+put_u16_le (GByteArray *output,
+            guint16     value)
+{
+    value = GUINT16_TO_LE (value);
+    g_byte_array_append (output, (guint8 *) &value, 2);
+}
+
+static void
+put_u32_le (GByteArray *output,
+            guint32     value)
+{
+    value = GUINT32_TO_LE (value);
+    g_byte_array_append (output, (guint8 *) &value, 4);
+}
+
+static void
+put_u64_le (GByteArray *output,
+            guint64     value)
+{
+    value = GUINT64_TO_LE (value);
+    g_byte_array_append (output, (guint8 *) &value, 8);
+}
+
+static void
+put_u16_be (GByteArray *output,
+            guint16     value)
+{
+    value = GUINT16_TO_BE (value);
+    g_byte_array_append (output, (guint8 *) &value, 2);
+}
+
+static void
+put_u32_be (GByteArray *output,
+            guint32     value)
+{
+    value = GUINT32_TO_BE (value);
+    g_byte_array_append (output, (guint8 *) &value, 4);
+}
+
+static void
+put_string (GByteArray  *output,
+            const gchar *string)
+{
+    g_byte_array_append (output, (const guint8 *) string, strlen (string));
+}
+
+static void
+put_zeros (GByteArray *output,
+           gsize       count)
+{
+    gsize offset;
+
+    offset = output->len;
+    g_byte_array_set_size (output, output->len + count);
+    memset (output->data + offset, 0, count);
+}
+
+static void
+set_u32_le (GByteArray *output,
+            gsize       offset,
+            guint32     value)
+{
+    value = GUINT32_TO_LE (value);
+    memcpy (output->data + offset, &value, 4);
+}
+
+static void
+set_u64_le (GByteArray *output,
+            gsize       offset,
+            guint64     value)
+{
+    value = GUINT64_TO_LE (value);
+    memcpy (output->data + offset, &value, 8);
+}
+
+/* Pads the output to a multiple of alignment */
+static void
+put_padding (GByteArray *output,
+             gsize       alignment)
+{
+    put_zeros (output, (alignment - output->len % alignment) % alignment);
+}
+
+static guint32
+png_crc (const guint8 *data,
+         gsize         size)
+{
+    guint32 crc;
+
+    crc = 0xFFFFFFFF;
+
+    for (gsize i = 0; i < size; i++)
+    {
+        crc ^= data[i];
+
+        for (gint bit = 0; bit < 8; bit++)
+            crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+    }
+
+    return crc ^ 0xFFFFFFFF;
+}
+
+static void
+png_chunk (GByteArray   *output,
+           const gchar  *chunk_type,
+           const guint8 *data,
+           guint32       size)
+{
+    gsize type_offset;
+
+    put_u32_be (output, size);
+
+    type_offset = output->len;
+    g_byte_array_append (output, (const guint8 *) chunk_type, 4);
+    g_byte_array_append (output, data, size);
+
+    put_u32_be (output, png_crc (output->data + type_offset, size + 4));
+}
+
+/* A 1x1 grayscale image, with count text chunks */
+static void
+generate_png (GByteArray *output,
+              guint       count)
+{
+    const guint8 header[] = { 0, 0, 0, 1, 0, 0, 0, 1, 8, 0, 0, 0, 0 };
+    const guint8 text[] = "Comment\0synthetic";
+    const guint8 image_data[] = { 0x78, 0x9C, 0x63, 0x60, 0x00, 0x00, 0x00, 0x02, 0x00, 0x01 };
+
+    g_byte_array_append (output, (const guint8 *) "\x89PNG\r\n\x1A\n", 8);
+
+    png_chunk (output, "IHDR", header, sizeof (header));
+
+    for (guint i = 0; i < count; i++)
+        png_chunk (output, "tEXt", text, sizeof (text) - 1);
+
+    png_chunk (output, "IDAT", image_data, sizeof (image_data));
+    png_chunk (output, "IEND", NULL, 0);
+}
+
+/* A little-endian TIFF with a chain of count single-entry IFDs */
+static void
+generate_tiff (GByteArray *output,
+               guint       count)
+{
+    put_string (output, "II");
+    put_u16_le (output, 42);
+    put_u32_le (output, 8);
+
+    for (guint i = 0; i < count; i++)
+    {
+        put_u16_le (output, 1);
+
+        /* ImageWidth, SHORT, 1 value */
+        put_u16_le (output, 256);
+        put_u16_le (output, 3);
+        put_u32_le (output, 1);
+        put_u16_le (output, 1);
+        put_u16_le (output, 0);
+
+        put_u32_le (output, i + 1 < count ? output->len + 4 : 0);
+    }
+}
+
+/* A ustar archive of count 16-byte files */
+static void
+generate_tar (GByteArray *output,
+              guint       count)
+{
+    guint8 *header;
+    guint checksum;
+
+    for (guint i = 0; i < count; i++)
+    {
+        put_zeros (output, 512);
+        header = output->data + output->len - 512;
+
+        g_snprintf ((gchar *) header, 100, "entry-%06u", i);
+        memcpy (header + 100, "0000644", 7);
+        memcpy (header + 108, "0000000", 7);
+        memcpy (header + 116, "0000000", 7);
+        g_snprintf ((gchar *) header + 124, 12, "%011o", 16);
+        g_snprintf ((gchar *) header + 136, 12, "%011o", 0);
+        memset (header + 148, ' ', 8);
+        header[156] = '0';
+        memcpy (header + 257, "ustar", 6);
+        memcpy (header + 263, "00", 2);
+
+        checksum = 0;
+        for (guint j = 0; j < 512; j++)
+            checksum += header[j];
+        g_snprintf ((gchar *) header + 148, 8, "%06o", checksum);
+
+        put_string (output, "synthetic input\n");
+        put_padding (output, 512);
+    }
+
+    put_zeros (output, 1024);
+}
+
+static void
+cpio_entry (GByteArray  *output,
+            guint        inode,
+            guint        mode,
+            const gchar *name,
+            const gchar *contents)
+{
+    gchar header[111];
+
+    g_snprintf (header, sizeof (header),
+                "070701%08X%08X%08X%08X%08X%08X%08X%08X%08X%08X%08X%08X%08X",
+                inode, mode, 0, 0, 1, 0, (guint) strlen (contents),
+                0, 0, 0, 0, (guint) strlen (name) + 1, 0);
+
+    put_string (output, header);
+    g_byte_array_append (output, (const guint8 *) name, strlen (name) + 1);
+    put_padding (output, 4);
+
+    put_string (output, contents);
+    put_padding (output, 4);
+}
+
+/* A new ASCII cpio archive of count 8-byte files */
+static void
+generate_cpio (GByteArray *output,
+               guint       count)
+{
+    gchar name[32];
+
+    for (guint i = 0; i < count; i++)
+    {
+        g_snprintf (name, sizeof (name), "entry-%06u", i);
+        cpio_entry (output, i + 1, 0100644, name, "content\n");
+    }
+
+    cpio_entry (output, 0, 0, "TRAILER!!!", "");
+}
+
+/* A 1x1 GIF with count comment extensions */
+static void
+generate_gif (GByteArray *output,
+              guint       count)
+{
+    const guint8 comment[] = { 0x21, 0xFE, 0x09, 's', 'y', 'n', 't', 'h', 'e', 't', 'i', 'c', 0x00 };
+    const guint8 image[] = { 0x2C, 0, 0, 0, 0, 1, 0, 1, 0, 0x00, 0x02, 0x02, 0x44, 0x01, 0x00 };
+
+    put_string (output, "GIF89a");
+    put_u16_le (output, 1);
+    put_u16_le (output, 1);
+    put_u8 (output, 0);
+    put_u8 (output, 0);
+    put_u8 (output, 0);
+
+    for (guint i = 0; i < count; i++)
+        g_byte_array_append (output, comment, sizeof (comment));
+
+    g_byte_array_append (output, image, sizeof (image));
+    put_u8 (output, 0x3B);
+}
+
+/* A JPEG stream with count comment segments */
+static void
+generate_jpeg (GByteArray *output,
+               guint       count)
+{
+    put_u16_be (output, 0xFFD8);
+
+    for (guint i = 0; i < count; i++)
+    {
+        put_u16_be (output, 0xFFFE);
+        put_u16_be (output, 11);
+        put_string (output, "synthetic");
+    }
+
+    put_u16_be (output, 0xFFD9);
+}
+
+/* A 64-bit relocatable ELF with count sections, one of them a 4 * count symbol table */
+static void
+generate_elf (GByteArray *output,
+              guint       count)
+{
+    GString *section_names;
+    gsize names_offset, symbols_offset, data_offset, headers_offset;
+    guint n_sections, n_symbols;
+    guint *name_offsets;
+
+    n_sections = CLAMP (count, 4, 0xFEFF);
+    n_symbols = count * 4;
+
+    section_names = g_string_new (NULL);
+    name_offsets = g_new0 (guint, n_sections);
+
+    g_string_append_c (section_names, '\0');
+    for (guint i = 1; i < n_sections; i++)
+    {
+        name_offsets[i] = section_names->len;
+
+        if (i == 1)
+            g_string_append (section_names, ".shstrtab");
+        else if (i == 2)
+            g_string_append (section_names, ".symtab");
+        else if (i == 3)
+            g_string_append (section_names, ".strtab");
+        else
+            g_string_append_printf (section_names, ".data.%u", i);
+
+        g_string_append_c (section_names, '\0');
+    }
+
+    /* ELF header, the section header offset is set last */
+    put_string (output, "\x7F" "ELF");
+    put_u8 (output, 2);
+    put_u8 (output, 1);
+    put_u8 (output, 1);
+    put_zeros (output, 9);
+    put_u16_le (output, 1);
+    put_u16_le (output, 62);
+    put_u32_le (output, 1);
+    put_u64_le (output, 0);
+    put_u64_le (output, 0);
+    put_u64_le (output, 0);
+    put_u32_le (output, 0);
+    put_u16_le (output, 64);
+    put_u16_le (output, 56);
+    put_u16_le (output, 0);
+    put_u16_le (output, 64);
+    put_u16_le (output, n_sections);
+    put_u16_le (output, 1);
+
+    names_offset = output->len;
+    g_byte_array_append (output, (const guint8 *) section_names->str, section_names->len);
+    put_padding (output, 8);
+
+    /* Symbols, all named "s" in .strtab */
+    symbols_offset = output->len;
+    put_zeros (output, 24);
+    for (guint i = 1; i < n_symbols; i++)
+    {
+        put_u32_le (output, 1);
+        put_u8 (output, 0x11);
+        put_u8 (output, 0);
+        put_u16_le (output, 4);
+        put_u64_le (output, i * 16);
+        put_u64_le (output, 16);
+    }
+    g_byte_array_append (output, (const guint8 *) "\0s\0", 3);
+    put_padding (output, 8);
+
+    data_offset = output->len;
+    put_zeros (output, 16);
+
+    headers_offset = output->len;
+    set_u64_le (output, 40, headers_offset);
+
+    put_zeros (output, 64);
+    for (guint i = 1; i < n_sections; i++)
+    {
+        put_u32_le (output, name_offsets[i]);
+
+        if (i == 1)
+        {
+            put_u32_le (output, 3);
+            put_u64_le (output, 0);
+            put_u64_le (output, 0);
+            put_u64_le (output, names_offset);
+            put_u64_le (output, section_names->len);
+            put_u32_le (output, 0);
+            put_u32_le (output, 0);
+            put_u64_le (output, 1);
+            put_u64_le (output, 0);
+        }
+        else if (i == 2)
+        {
+            put_u32_le (output, 2);
+            put_u64_le (output, 0);
+            put_u64_le (output, 0);
+            put_u64_le (output, symbols_offset);
+            put_u64_le (output, n_symbols * 24);
+            put_u32_le (output, 3);
+            put_u32_le (output, 1);
+            put_u64_le (output, 8);
+            put_u64_le (output, 24);
+        }
+        else if (i == 3)
+        {
+            put_u32_le (output, 3);
+            put_u64_le (output, 0);
+            put_u64_le (output, 0);
+            put_u64_le (output, symbols_offset + n_symbols * 24);
+            put_u64_le (output, 3);
+            put_u32_le (output, 0);
+            put_u32_le (output, 0);
+            put_u64_le (output, 1);
+            put_u64_le (output, 0);
+        }
+        else
+        {
+            put_u32_le (output, 1);
+            put_u64_le (output, 3);
+            put_u64_le (output, 0);
+            put_u64_le (output, data_offset);
+            put_u64_le (output, 16);
+            put_u32_le (output, 0);
+            put_u32_le (output, 0);
+            put_u64_le (output, 16);
+            put_u64_le (output, 0);
+        }
+    }
+
+    g_free (name_offsets);
+    g_string_free (section_names, TRUE);
+}
+
+/* A PE32+ image with count 16-byte sections */
+static void
+generate_pe (GByteArray *output,
+             guint       count)
+{
+    gsize optional_header_offset, data_offset;
+    gchar section_name[9];
+    guint n_sections;
+
+    n_sections = MIN (count, 0xFFFF);
+
+    /* DOS header */
+    put_string (output, "MZ");
+    put_zeros (output, 58);
+    put_u32_le (output, 64);
+
+    /* COFF header */
+    put_string (output, "PE");
+    put_zeros (output, 2);
+    put_u16_le (output, 0x8664);
+    put_u16_le (output, n_sections);
+    put_u32_le (output, 0);
+    put_u32_le (output, 0);
+    put_u32_le (output, 0);
+    put_u16_le (output, 240);
+    put_u16_le (output, 0x0022);
+
+    /* Optional header, with 16 empty data directories */
+    optional_header_offset = output->len;
+    put_zeros (output, 240);
+    output->data[optional_header_offset] = 0x0B;
+    output->data[optional_header_offset + 1] = 0x02;
+    set_u32_le (output, optional_header_offset + 32, 0x1000);
+    set_u32_le (output, optional_header_offset + 36, 0x10);
+    set_u32_le (output, optional_header_offset + 108, 16);
+
+    data_offset = output->len + n_sections * 40;
+    set_u32_le (output, optional_header_offset + 60, data_offset);
+
+    for (guint i = 0; i < n_sections; i++)
+    {
+        g_snprintf (section_name, sizeof (section_name), ".s%05u", i);
+        g_byte_array_append (output, (const guint8 *) section_name, 8);
+
+        put_u32_le (output, 16);
+        put_u32_le (output, 0x1000 * (i + 1));
+        put_u32_le (output, 16);
+        put_u32_le (output, data_offset + i * 16);
+        put_zeros (output, 12);
+        put_u32_le (output, 0x40000040);
+    }
+
+    for (guint i = 0; i < n_sections; i++)
+        put_string (output, "synthetic input\n");
+}
+
+/* An extended WebP file with count XMP chunks */
+static void
+generate_webp (GByteArray *output,
+               guint       count)
+{
+    put_string (output, "RIFF");
+    put_u32_le (output, 0);
+    put_string (output, "WEBP");
+
+    put_string (output, "VP8X");
+    put_u32_le (output, 10);
+    put_zeros (output, 10);
+
+    for (guint i = 0; i < count; i++)
+    {
+        put_string (output, "XMP ");
+        put_u32_le (output, 8);
+        put_string (output, "synthetc");
+    }
+
+    set_u32_le (output, 4, output->len - 8);
+}
+
+const CorpusGenerator corpus_generators[] =
+{
+    { "cpio", "cpio archive", 20000, generate_cpio },
+    { "elf", "Executable and Linkable Format", 50000, generate_elf },
+    { "gif", "Graphics Interchange Format", 100000, generate_gif },
+    { "jpeg", "Joint Photographic Experts Group", 100000, generate_jpeg },
+    { "pe", "Portable Executable", 10000, generate_pe },
+    { "png", "Portable Network Graphics", 100000, generate_png },
+    { "tar", "tar archive", 50000, generate_tar },
+    { "tiff", "Tag Image File Format", 10000, generate_tiff },
+    { "webp", "WebP image", 100000, generate_webp }
+};
+
+const guint corpus_n_generators = G_N_ELEMENTS (corpus_generators);
+
+/*
+ * Generates the generator's input, with its structure repeated count * scale times
+ */
+GBytes *
+corpus_generate (const CorpusGenerator *generator,
+                 gdouble                scale)
+{
+    GByteArray *output;
+
+    output = g_byte_array_new ();
+    generator->generate (output, MAX (1, (guint) (generator->count * scale)));
+
+    return g_byte_array_free_to_bytes (output);
+}
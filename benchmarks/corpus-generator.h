@@ -0,0 +1,47 @@
+/* corpus-generator.h
+ *
+ * Copyright (C) 2021 - Daniel Léonard Schardijn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* A synthetic input generator for a bundled format */
+typedef struct
+{
+    /* Short name, used to select the generator */
+    const gchar   *name;
+
+    /* The name of the format the input must be identified as */
+    const gchar   *format_name;
+
+    /* Number of repeated structures (chunks, entries, IFDs...) at scale 1 */
+    guint          count;
+
+    void         (*generate) (GByteArray *, guint);
+
+} CorpusGenerator;
+
+extern const CorpusGenerator corpus_generators[];
+extern const guint           corpus_n_generators;
+
+GBytes *    corpus_generate    (const CorpusGenerator *,
+                                gdouble);
+
+G_END_DECLS
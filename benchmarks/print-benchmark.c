@@ -0,0 +1,167 @@
+/* print-benchmark.c
+ *
+ * Copyright (C) 2021 - Daniel Léonard Schardijn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include <chirurgien-print.h>
+
+/* A full-screen 4K redraw: 128 bytes per line (384 characters), 120 lines */
+#define DEFAULT_LINE_BYTES 128
+#define DEFAULT_LINES      120
+#define DEFAULT_REDRAWS    20000
+
+
+/* Returns the microseconds per redraw */
+static gdouble
+print_benchmark_run (ChirurgienPrintKernel  kernel,
+                     gchar                 *destination,
+                     const guchar          *source,
+                     gsize                  window_size,
+                     gsize                  line_break,
+                     gint                   redraws)
+{
+    gint64 start;
+
+    start = g_get_monotonic_time ();
+
+    /* The window scrolls a byte per redraw, as the view does */
+    for (gint i = 0; i < redraws; i++)
+        chirurgien_print_formatted (kernel,
+                                    destination,
+                                    source,
+                                    i % 64,
+                                    window_size * 3,
+                                    window_size + 64,
+                                    line_break);
+
+    return (g_get_monotonic_time () - start) / (gdouble) redraws;
+}
+
+gint
+main (gint   argc,
+      gchar *argv[])
+{
+    GOptionContext *option_context;
+    const ChirurgienPrintKernels *kernels;
+    guint n_kernels;
+
+    gint line_bytes = DEFAULT_LINE_BYTES;
+    gint lines = DEFAULT_LINES;
+    gint redraws = DEFAULT_REDRAWS;
+
+    gsize window_size, line_break;
+    guchar *source;
+    gchar *reference, *destination;
+    gdouble hex_scalar, text_scalar, hex_time, text_time;
+    gboolean all_match;
+
+    GError *error = NULL;
+
+    const GOptionEntry options[] =
+    {
+        { "line-bytes", 0, 0, G_OPTION_ARG_INT, &line_bytes,
+          "Bytes per line, 128 by default", "N" },
+        { "lines", 0, 0, G_OPTION_ARG_INT, &lines,
+          "Lines per redraw, 120 by default", "N" },
+        { "redraws", 0, 0, G_OPTION_ARG_INT, &redraws,
+          "Timed redraws per kernel", "N" },
+        { NULL }
+    };
+
+    option_context = g_option_context_new ("- benchmark the hex and text formatting kernels");
+    g_option_context_add_main_entries (option_context, options, NULL);
+
+    if (!g_option_context_parse (option_context, &argc, &argv, &error))
+    {
+        g_printerr ("%s\n", error->message);
+        g_error_free (error);
+        g_option_context_free (option_context);
+
+        return 1;
+    }
+
+    g_option_context_free (option_context);
+
+    if (line_bytes < 1 || lines < 1 || redraws < 1)
+    {
+        g_printerr ("The line bytes, lines and redraws must be positive\n");
+        return 1;
+    }
+
+    window_size = (gsize) line_bytes * lines;
+    line_break = (gsize) line_bytes * 3;
+
+    source = g_malloc (window_size + 64);
+    for (gsize i = 0; i < window_size + 64; i++)
+        source[i] = g_random_int_range (0, 256);
+
+    reference = g_malloc (window_size * 3);
+    destination = g_malloc (window_size * 3);
+
+    kernels = chirurgien_print_kernels_get_all (&n_kernels);
+    hex_scalar = text_scalar = 0;
+    all_match = TRUE;
+
+    for (guint i = 0; i < n_kernels; i++)
+    {
+        hex_time = print_benchmark_run (kernels[i].hex, destination, source,
+                                        window_size, line_break, redraws);
+
+        /* Kernels must format exactly as the scalar kernel */
+        chirurgien_print_formatted (kernels[0].hex, reference, source, 0,
+                                    window_size * 3, window_size, line_break);
+        chirurgien_print_formatted (kernels[i].hex, destination, source, 0,
+                                    window_size * 3, window_size, line_break);
+        all_match &= !memcmp (reference, destination, window_size * 3);
+
+        text_time = print_benchmark_run (kernels[i].text, destination, source,
+                                         window_size, line_break, redraws);
+
+        chirurgien_print_formatted (kernels[0].text, reference, source, 0,
+                                    window_size * 3, window_size, line_break);
+        chirurgien_print_formatted (kernels[i].text, destination, source, 0,
+                                    window_size * 3, window_size, line_break);
+        all_match &= !memcmp (reference, destination, window_size * 3);
+
+        if (!i)
+        {
+            hex_scalar = hex_time;
+            text_scalar = text_time;
+        }
+
+        printf ("{\"kernel\":\"%s\",\"window_bytes\":%" G_GSIZE_FORMAT ","
+                "\"hex_us_per_redraw\":%.3f,\"hex_speedup\":%.2f,"
+                "\"text_us_per_redraw\":%.3f,\"text_speedup\":%.2f}\n",
+                kernels[i].name,
+                window_size,
+                hex_time,
+                hex_scalar / MAX (hex_time, 0.001),
+                text_time,
+                text_scalar / MAX (text_time, 0.001));
+    }
+
+    g_free (source);
+    g_free (reference);
+    g_free (destination);
+
+    if (!all_match)
+        g_printerr ("A kernel does not format as the scalar kernel\n");
+
+    return all_match ? 0 : 1;
+}
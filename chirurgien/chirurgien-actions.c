@@ -375,6 +375,36 @@ chirurgien_actions_reanalyze (G_GNUC_UNUSED GSimpleAction *action,
     chirurgien_view_redo_analysis (view);
 }
 
+void
+chirurgien_actions_carve (G_GNUC_UNUSED GSimpleAction *action,
+                          G_GNUC_UNUSED GVariant      *parameter,
+                          gpointer user_data)
+{
+    GtkNotebook *notebook;
+    ChirurgienView *view;
+
+    notebook = GTK_NOTEBOOK (gtk_window_get_child (user_data));
+    view = CHIRURGIEN_VIEW (gtk_notebook_get_nth_page (notebook,
+                            gtk_notebook_get_current_page (notebook)));
+
+    chirurgien_view_carve (view);
+}
+
+void
+chirurgien_actions_statistics (G_GNUC_UNUSED GSimpleAction *action,
+                               G_GNUC_UNUSED GVariant      *parameter,
+                               gpointer user_data)
+{
+    GtkNotebook *notebook;
+    ChirurgienView *view;
+
+    notebook = GTK_NOTEBOOK (gtk_window_get_child (user_data));
+    view = CHIRURGIEN_VIEW (gtk_notebook_get_nth_page (notebook,
+                            gtk_notebook_get_current_page (notebook)));
+
+    chirurgien_view_statistics (view);
+}
+
 void
 chirurgien_actions_hex_view (G_GNUC_UNUSED GSimpleAction *action,
                              G_GNUC_UNUSED GVariant      *parameter,
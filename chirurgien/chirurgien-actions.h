@@ -57,6 +57,12 @@ void       chirurgien_actions_close              (GSimpleAction *,
 void       chirurgien_actions_reanalyze          (GSimpleAction *,
                                                   GVariant *,
                                                   gpointer);
+void       chirurgien_actions_carve              (GSimpleAction *,
+                                                  GVariant *,
+                                                  gpointer);
+void       chirurgien_actions_statistics         (GSimpleAction *,
+                                                  GVariant *,
+                                                  gpointer);
 void       chirurgien_actions_hex_view           (GSimpleAction *,
                                                   GVariant *,
                                                   gpointer);
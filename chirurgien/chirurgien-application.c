@@ -58,6 +58,8 @@ chirurgien_application_startup (GApplication *app)
     gtk_application_set_accels_for_action (GTK_APPLICATION (app), "win.save", (const gchar *[]) {"<Primary>S", NULL});
     gtk_application_set_accels_for_action (GTK_APPLICATION (app), "win.close-tab", (const gchar *[]) {"<Primary>W", NULL});
     gtk_application_set_accels_for_action (GTK_APPLICATION (app), "win.reanalyze", (const gchar *[]) {"<Primary>R", NULL});
+    gtk_application_set_accels_for_action (GTK_APPLICATION (app), "win.carve", (const gchar *[]) {"<Primary>E", NULL});
+    gtk_application_set_accels_for_action (GTK_APPLICATION (app), "win.statistics", (const gchar *[]) {"<Primary>I", NULL});
     gtk_application_set_accels_for_action (GTK_APPLICATION (app), "win.hex-view", (const gchar *[]) {"<Primary>H", NULL});
     gtk_application_set_accels_for_action (GTK_APPLICATION (app), "win.text-view", (const gchar *[]) {"<Primary>T", NULL});
     gtk_application_set_accels_for_action (GTK_APPLICATION (app), "win.undo", (const gchar *[]) {"<Primary>Z", NULL});
@@ -66,15 +68,7 @@ chirurgien_application_startup (GApplication *app)
     gtk_application_set_accels_for_action (GTK_APPLICATION (app), "win.previous-tab", (const gchar *[]) {"<Primary><Alt>Page_Up", NULL});
 
     /* Initialize supported formats */
-    chirurgien_formats_initialize ("/io/github/leonardschardijn/chirurgien/format-definitions/cpio-format.xml");
-    chirurgien_formats_initialize ("/io/github/leonardschardijn/chirurgien/format-definitions/elf-format.xml");
-    chirurgien_formats_initialize ("/io/github/leonardschardijn/chirurgien/format-definitions/gif-format.xml");
-    chirurgien_formats_initialize ("/io/github/leonardschardijn/chirurgien/format-definitions/jpeg-format.xml");
-    chirurgien_formats_initialize ("/io/github/leonardschardijn/chirurgien/format-definitions/pe-format.xml");
-    chirurgien_formats_initialize ("/io/github/leonardschardijn/chirurgien/format-definitions/png-format.xml");
-    chirurgien_formats_initialize ("/io/github/leonardschardijn/chirurgien/format-definitions/tar-format.xml");
-    chirurgien_formats_initialize ("/io/github/leonardschardijn/chirurgien/format-definitions/tiff-format.xml");
-    chirurgien_formats_initialize ("/io/github/leonardschardijn/chirurgien/format-definitions/webp-format.xml");
+    chirurgien_formats_initialize_system ();
 }
 
 static void
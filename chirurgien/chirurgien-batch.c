@@ -0,0 +1,373 @@
+/* chirurgien-batch.c
+ *
+ * Copyright (C) 2021 - Daniel Léonard Schardijn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "chirurgien-batch.h"
+
+#include <glib/gstdio.h>
+
+#include <chirurgien-formats.h>
+
+#include "chirurgien-cli.h"
+
+
+typedef struct _BatchScan BatchScan;
+
+typedef struct
+{
+    BatchScan     *scan;
+    guint          index;
+
+    /* Paths to scan, the worker pops from the tail, thieves steal from the head */
+    GQueue         paths;
+    GMutex         paths_lock;
+
+    /* Reused for every file the worker scans, with the processor state */
+    ProcessorFile *processor_file;
+    GString       *line;
+
+    GThread       *thread;
+
+} BatchWorker;
+
+struct _BatchScan
+{
+    BatchWorker   *workers;
+    guint          n_workers;
+
+    /* Paths queued or being scanned, the scan is done when it reaches 0,
+     * and paths queued: idle workers wait for either to change */
+    guint          pending;
+    guint          queued;
+    GMutex         idle_lock;
+    GCond          idle_cond;
+
+    FILE          *output;
+    GMutex         output_lock;
+
+    guint          files_scanned;
+
+};
+
+
+/* The path is counted before it can be taken, the scan cannot end meanwhile */
+static void
+batch_push (BatchWorker *worker,
+            gchar       *path)
+{
+    BatchScan *scan;
+
+    scan = worker->scan;
+
+    g_mutex_lock (&scan->idle_lock);
+
+    scan->pending++;
+    scan->queued++;
+
+    g_mutex_lock (&worker->paths_lock);
+    g_queue_push_tail (&worker->paths, path);
+    g_mutex_unlock (&worker->paths_lock);
+
+    g_cond_signal (&scan->idle_cond);
+    g_mutex_unlock (&scan->idle_lock);
+}
+
+static void
+batch_taken (BatchScan *scan)
+{
+    g_mutex_lock (&scan->idle_lock);
+    scan->queued--;
+    g_mutex_unlock (&scan->idle_lock);
+}
+
+/* A path was scanned, the last one wakes up the idle workers to finish */
+static void
+batch_done (BatchScan *scan)
+{
+    g_mutex_lock (&scan->idle_lock);
+    if (!--scan->pending)
+        g_cond_broadcast (&scan->idle_cond);
+    g_mutex_unlock (&scan->idle_lock);
+}
+
+/*
+ * Waits until paths are queued, or the scan is done
+ * Returns FALSE if the scan is done
+ */
+static gboolean
+batch_wait (BatchScan *scan)
+{
+    gboolean scanning;
+
+    g_mutex_lock (&scan->idle_lock);
+    while (!scan->queued && scan->pending)
+        g_cond_wait (&scan->idle_cond, &scan->idle_lock);
+    scanning = scan->pending != 0;
+    g_mutex_unlock (&scan->idle_lock);
+
+    return scanning;
+}
+
+static gchar *
+batch_pop (BatchWorker *worker)
+{
+    gchar *path;
+
+    g_mutex_lock (&worker->paths_lock);
+    path = g_queue_pop_tail (&worker->paths);
+    g_mutex_unlock (&worker->paths_lock);
+
+    if (path)
+        batch_taken (worker->scan);
+
+    return path;
+}
+
+/* Steals the oldest path of another worker, directories are found there first */
+static gchar *
+batch_steal (BatchWorker *thief)
+{
+    BatchScan *scan;
+    BatchWorker *victim;
+    gchar *path;
+
+    scan = thief->scan;
+    path = NULL;
+
+    for (guint i = 1; i < scan->n_workers && !path; i++)
+    {
+        victim = &scan->workers[(thief->index + i) % scan->n_workers];
+
+        g_mutex_lock (&victim->paths_lock);
+        path = g_queue_pop_head (&victim->paths);
+        g_mutex_unlock (&victim->paths_lock);
+    }
+
+    if (path)
+        batch_taken (scan);
+
+    return path;
+}
+
+static void
+batch_write_line (BatchWorker *worker)
+{
+    BatchScan *scan;
+
+    scan = worker->scan;
+
+    g_string_append_c (worker->line, '\n');
+
+    g_mutex_lock (&scan->output_lock);
+    fwrite (worker->line->str, 1, worker->line->len, scan->output);
+    g_mutex_unlock (&scan->output_lock);
+
+    g_string_truncate (worker->line, 0);
+}
+
+static void
+batch_scan_directory (BatchWorker *worker,
+                      const gchar *path)
+{
+    GDir *directory;
+    const gchar *name;
+
+    directory = g_dir_open (path, 0, NULL);
+
+    if (!directory)
+        return;
+
+    while ((name = g_dir_read_name (directory)))
+        batch_push (worker, g_build_filename (path, name, NULL));
+
+    g_dir_close (directory);
+}
+
+static void
+batch_scan_file (BatchWorker *worker,
+                 const gchar *path)
+{
+    ProcessorFile *processor_file;
+    GMappedFile *file_mapping;
+
+    const gchar *format_name;
+    guint steps_executed, invalid_values, missing_fields;
+
+    GError *error = NULL;
+
+    processor_file = worker->processor_file;
+
+    g_string_append (worker->line, "{\"file\":");
+    chirurgien_cli_append_string (worker->line, path);
+
+    file_mapping = g_mapped_file_new (path, FALSE, &error);
+
+    if (!file_mapping)
+    {
+        g_string_append (worker->line, ",\"error\":");
+        chirurgien_cli_append_string (worker->line, error->message);
+        g_string_append_c (worker->line, '}');
+
+        batch_write_line (worker);
+        g_error_free (error);
+
+        return;
+    }
+
+    processor_file_reset (processor_file,
+                          g_mapped_file_get_contents (file_mapping),
+                          g_mapped_file_get_length (file_mapping));
+
+    format_name = chirurgien_formats_analyze (processor_file);
+
+    processor_file_get_progress (processor_file, NULL, &steps_executed);
+    processor_file_get_errors (processor_file, &invalid_values, &missing_fields);
+
+    g_string_append (worker->line, ",\"format\":");
+    chirurgien_cli_append_string (worker->line, format_name);
+    g_string_append_printf (worker->line,
+                            ",\"size\":%" G_GSIZE_FORMAT ",\"fields\":%u,"
+                            "\"invalid_values\":%u,\"missing_fields\":%u,\"steps\":%u}",
+                            g_mapped_file_get_length (file_mapping),
+                            processor_file_get_n_fields (processor_file),
+                            invalid_values,
+                            missing_fields,
+                            steps_executed);
+
+    batch_write_line (worker);
+
+    g_mapped_file_unref (file_mapping);
+
+    g_atomic_int_inc (&worker->scan->files_scanned);
+}
+
+/* Symbolic links are not followed, the tree has no cycles */
+static void
+batch_scan_path (BatchWorker *worker,
+                 const gchar *path)
+{
+    GStatBuf file_stat;
+
+    if (g_lstat (path, &file_stat))
+        return;
+
+    if (S_ISDIR (file_stat.st_mode))
+        batch_scan_directory (worker, path);
+    else if (S_ISREG (file_stat.st_mode))
+        batch_scan_file (worker, path);
+}
+
+static gpointer
+batch_worker_run (gpointer data)
+{
+    BatchWorker *worker;
+    BatchScan *scan;
+    gchar *path;
+
+    worker = data;
+    scan = worker->scan;
+
+    while (TRUE)
+    {
+        path = batch_pop (worker);
+
+        if (!path)
+            path = batch_steal (worker);
+
+        if (!path)
+        {
+            if (!batch_wait (scan))
+                break;
+
+            continue;
+        }
+
+        batch_scan_path (worker, path);
+        g_free (path);
+
+        batch_done (scan);
+    }
+
+    return NULL;
+}
+
+/*
+ * Scans the files of a directory tree with n_workers threads, writing
+ * a JSON line per file to output
+ * Returns the number of files scanned
+ */
+guint
+chirurgien_batch_scan (const gchar *root_path,
+                       guint        n_workers,
+                       FILE        *output)
+{
+    BatchScan scan = { 0 };
+    BatchWorker *worker;
+
+    if (!n_workers)
+        n_workers = g_get_num_processors ();
+
+    scan.n_workers = n_workers;
+    scan.workers = g_new0 (BatchWorker, n_workers);
+    scan.output = output;
+
+    g_mutex_init (&scan.idle_lock);
+    g_cond_init (&scan.idle_cond);
+    g_mutex_init (&scan.output_lock);
+
+    for (guint i = 0; i < n_workers; i++)
+    {
+        worker = &scan.workers[i];
+
+        worker->scan = &scan;
+        worker->index = i;
+
+        g_queue_init (&worker->paths);
+        g_mutex_init (&worker->paths_lock);
+
+        worker->processor_file = processor_file_create (NULL, 0, NULL);
+        worker->line = g_string_sized_new (512);
+    }
+
+    batch_push (&scan.workers[0], g_strdup (root_path));
+
+    /* The calling thread is the first worker */
+    for (guint i = 1; i < n_workers; i++)
+        scan.workers[i].thread = g_thread_new ("batch-worker", batch_worker_run, &scan.workers[i]);
+
+    batch_worker_run (&scan.workers[0]);
+
+    for (guint i = 0; i < n_workers; i++)
+    {
+        worker = &scan.workers[i];
+
+        if (worker->thread)
+            g_thread_join (worker->thread);
+
+        processor_file_destroy (worker->processor_file);
+        g_string_free (worker->line, TRUE);
+        g_mutex_clear (&worker->paths_lock);
+    }
+
+    g_mutex_clear (&scan.idle_lock);
+    g_cond_clear (&scan.idle_cond);
+    g_mutex_clear (&scan.output_lock);
+
+    g_free (scan.workers);
+
+    return scan.files_scanned;
+}
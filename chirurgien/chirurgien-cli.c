@@ -0,0 +1,327 @@
+/* chirurgien-cli.c
+ *
+ * Copyright (C) 2021 - Daniel Léonard Schardijn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "chirurgien-cli.h"
+
+#include <chirurgien-formats.h>
+
+#include "chirurgien-batch.h"
+
+
+static const gchar * const description_record_types[] =
+{
+    [DESCRIPTION_TITLE] = "title",
+    [DESCRIPTION_SECTION] = "section",
+    [DESCRIPTION_LINE] = "line",
+    [DESCRIPTION_NOTE] = "note",
+    [DESCRIPTION_TEXT] = "text",
+    [DESCRIPTION_TAB] = "tab"
+};
+
+/* Appends a JSON string, null if string is NULL */
+void
+chirurgien_cli_append_string (GString     *output,
+                              const gchar *string)
+{
+    g_autofree gchar *valid_string = NULL;
+
+    if (!string)
+    {
+        g_string_append (output, "null");
+        return;
+    }
+
+    if (!g_utf8_validate (string, -1, NULL))
+        string = valid_string = g_utf8_make_valid (string, -1);
+
+    g_string_append_c (output, '"');
+
+    for (const gchar *c = string; *c; c++)
+    {
+        switch (*c)
+        {
+            case '"':
+            g_string_append (output, "\\\"");
+
+            break;
+            case '\\':
+            g_string_append (output, "\\\\");
+
+            break;
+            case '\n':
+            g_string_append (output, "\\n");
+
+            break;
+            case '\r':
+            g_string_append (output, "\\r");
+
+            break;
+            case '\t':
+            g_string_append (output, "\\t");
+
+            break;
+            default:
+            if ((guchar) *c < 0x20)
+                g_string_append_printf (output, "\\u%04X", (guchar) *c);
+            else
+                g_string_append_c (output, *c);
+
+            break;
+        }
+    }
+
+    g_string_append_c (output, '"');
+}
+
+/* Writes the buffered output, the buffer is reused */
+static void
+cli_flush (GString *buffer,
+           FILE    *output)
+{
+    fwrite (buffer->str, 1, buffer->len, output);
+    g_string_truncate (buffer, 0);
+}
+
+static void
+cli_write_fields (GString          *buffer,
+                  FILE             *output,
+                  const FieldTable *fields)
+{
+    FileField field;
+
+    g_string_append (buffer, "\"fields\":[");
+
+    for (guint i = 0; i < fields->n_fields; i++)
+    {
+        field_table_get_field (fields, i, &field);
+
+        g_string_append (buffer, i ? ",\n{\"name\":" : "\n{\"name\":");
+        chirurgien_cli_append_string (buffer, field.field_name);
+        g_string_append_printf (buffer, ",\"offset\":%" G_GSIZE_FORMAT ",\"size\":%" G_GSIZE_FORMAT,
+                                field.field_offset, field.field_size);
+
+        if (field.color_index != G_MAXUINT)
+            g_string_append_printf (buffer, ",\"color\":%u,\"background\":%s",
+                                    field.color_index, field.background ? "true" : "false");
+        if (field.additional_color_index != G_MAXUINT)
+            g_string_append_printf (buffer, ",\"additional_color\":%u", field.additional_color_index);
+        if (field.navigation_label)
+        {
+            g_string_append (buffer, ",\"navigation\":");
+            chirurgien_cli_append_string (buffer, field.navigation_label);
+        }
+
+        g_string_append_c (buffer, '}');
+        cli_flush (buffer, output);
+    }
+
+    g_string_append (buffer, "]");
+}
+
+static void
+cli_write_description (GString               *buffer,
+                       FILE                  *output,
+                       const FileDescription *description)
+{
+    const DescriptionRecord *record;
+
+    g_string_append (buffer, "\"description\":[");
+
+    for (guint i = 0; i < description->records->len; i++)
+    {
+        record = &g_array_index (description->records, DescriptionRecord, i);
+
+        g_string_append (buffer, i ? ",\n{\"type\":" : "\n{\"type\":");
+        chirurgien_cli_append_string (buffer, description_record_types[record->type]);
+        g_string_append (buffer, ",\"name\":");
+        chirurgien_cli_append_string (buffer, record->name);
+
+        if (record->type == DESCRIPTION_LINE || record->type == DESCRIPTION_TEXT)
+        {
+            g_string_append (buffer, ",\"value\":");
+            chirurgien_cli_append_string (buffer, record->value);
+        }
+        if (record->tooltip)
+        {
+            g_string_append (buffer, ",\"tooltip\":");
+            chirurgien_cli_append_string (buffer, record->tooltip);
+        }
+
+        g_string_append_c (buffer, '}');
+        cli_flush (buffer, output);
+    }
+
+    g_string_append (buffer, "]");
+}
+
+/*
+ * Analyzes a file and writes the result to output
+ * Returns FALSE if the file cannot be read
+ */
+gboolean
+chirurgien_cli_analyze_file (const gchar  *file_path,
+                             FILE         *output,
+                             GError      **error)
+{
+    ProcessorFile *processor_file;
+    FieldTable *fields;
+    FileDescription *description;
+
+    GMappedFile *file_mapping;
+    GString *buffer;
+
+    file_mapping = g_mapped_file_new (file_path, FALSE, error);
+
+    if (!file_mapping)
+        return FALSE;
+
+    processor_file = processor_file_create (g_mapped_file_get_contents (file_mapping),
+                                            g_mapped_file_get_length (file_mapping),
+                                            NULL);
+
+    chirurgien_formats_analyze (processor_file);
+
+    fields = processor_file_get_fields (processor_file);
+    description = processor_file_get_description (processor_file);
+
+    buffer = g_string_sized_new (4096);
+
+    g_string_append (buffer, "{\"file\":");
+    chirurgien_cli_append_string (buffer, file_path);
+    g_string_append_printf (buffer, ",\"size\":%" G_GSIZE_FORMAT ",\n", g_mapped_file_get_length (file_mapping));
+
+    cli_write_fields (buffer, output, fields);
+    g_string_append (buffer, ",\n");
+    cli_write_description (buffer, output, description);
+    g_string_append (buffer, "}\n");
+    cli_flush (buffer, output);
+
+    g_string_free (buffer, TRUE);
+
+    field_table_free (fields);
+    file_description_destroy (description);
+    processor_file_destroy (processor_file);
+
+    g_mapped_file_unref (file_mapping);
+
+    return TRUE;
+}
+
+/* If the command line requests a headless analysis or scan */
+gboolean
+chirurgien_cli_requested (gint   argc,
+                          gchar *argv[])
+{
+    for (gint i = 1; i < argc; i++)
+    {
+        if (!g_strcmp0 (argv[i], "--analyze") ||
+            g_str_has_prefix (argv[i], "--analyze=") ||
+            !g_strcmp0 (argv[i], "--scan") ||
+            g_str_has_prefix (argv[i], "--scan="))
+            return TRUE;
+    }
+
+    return FALSE;
+}
+
+/*
+ * Runs a headless analysis or directory scan: no display is needed,
+ * the only output is the analysis (JSON) or the scan (JSON Lines), written to stdout
+ */
+gint
+chirurgien_cli_run (gint   argc,
+                    gchar *argv[])
+{
+    GOptionContext *option_context;
+
+    g_autofree gchar *file_path = NULL;
+    g_autofree gchar *scan_path = NULL;
+    gint n_workers = 0;
+    g_autofree gchar *output_format = NULL;
+    g_auto (GStrv) definition_paths = NULL;
+
+    g_autofree gchar *error_message = NULL;
+    GError *error = NULL;
+
+    const GOptionEntry options[] =
+    {
+        { "analyze", 0, 0, G_OPTION_ARG_FILENAME, &file_path,
+          "Analyze FILE and write the result to the standard output", "FILE" },
+        { "scan", 0, 0, G_OPTION_ARG_FILENAME, &scan_path,
+          "Scan the files of DIRECTORY, writing a JSON line per file", "DIRECTORY" },
+        { "jobs", 'j', 0, G_OPTION_ARG_INT, &n_workers,
+          "Number of scanning threads, the number of processors by default", "N" },
+        { "format", 0, 0, G_OPTION_ARG_STRING, &output_format,
+          "Output format, only 'json' is supported", "FORMAT" },
+        { "definition", 0, 0, G_OPTION_ARG_FILENAME_ARRAY, &definition_paths,
+          "Load a user-defined format definition, can be repeated", "DEFINITION" },
+        { NULL }
+    };
+
+    option_context = g_option_context_new (NULL);
+    g_option_context_add_main_entries (option_context, options, NULL);
+
+    if (!g_option_context_parse (option_context, &argc, &argv, &error))
+    {
+        g_printerr ("%s\n", error->message);
+        g_error_free (error);
+        g_option_context_free (option_context);
+
+        return 1;
+    }
+
+    g_option_context_free (option_context);
+
+    if (output_format && g_strcmp0 (output_format, "json"))
+    {
+        g_printerr ("Unsupported output format: %s\n", output_format);
+        return 1;
+    }
+
+    chirurgien_formats_initialize_system ();
+
+    for (gchar **definition_path = definition_paths;
+         definition_path && *definition_path;
+         definition_path++)
+    {
+        g_autoptr (GFile) definition_file = g_file_new_for_commandline_arg (*definition_path);
+
+        if ((error_message = chirurgien_formats_load (definition_file)))
+        {
+            g_printerr ("%s: %s\n", *definition_path, error_message);
+            return 1;
+        }
+    }
+
+    if (scan_path)
+    {
+        chirurgien_batch_scan (scan_path, MAX (n_workers, 0), stdout);
+
+        return fflush (stdout) ? 1 : 0;
+    }
+
+    if (!chirurgien_cli_analyze_file (file_path, stdout, &error))
+    {
+        g_printerr ("%s\n", error->message);
+        g_error_free (error);
+
+        return 1;
+    }
+
+    return fflush (stdout) ? 1 : 0;
+}
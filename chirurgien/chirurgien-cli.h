@@ -0,0 +1,40 @@
+/* chirurgien-cli.h
+ *
+ * Copyright (C) 2021 - Daniel Léonard Schardijn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdio.h>
+
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+gboolean    chirurgien_cli_requested        (gint,
+                                             gchar *[]);
+
+gint        chirurgien_cli_run              (gint,
+                                             gchar *[]);
+
+void        chirurgien_cli_append_string    (GString *,
+                                             const gchar *);
+
+gboolean    chirurgien_cli_analyze_file     (const gchar *,
+                                             FILE *,
+                                             GError **);
+
+G_END_DECLS
@@ -0,0 +1,401 @@
+/* chirurgien-document.c
+ *
+ * Copyright (C) 2021 - Daniel Léonard Schardijn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "chirurgien-document.h"
+
+#include <string.h>
+
+
+typedef struct _DocumentNode DocumentNode;
+
+/* A piece of the document, and a node of the tree
+ * Nodes are never modified once created, edits create new nodes */
+struct _DocumentNode
+{
+    gint            ref_count;
+
+    /* Treap priority, parents have a higher priority than their children */
+    guint32         priority;
+
+    DocumentNode   *left;
+    DocumentNode   *right;
+
+    /* The piece: length bytes of buffer, starting at offset */
+    GBytes         *buffer;
+    gsize           offset;
+    gsize           length;
+
+    /* Length of the whole subtree */
+    gsize           subtree_length;
+
+};
+
+struct _ChirurgienDocument
+{
+    DocumentNode   *root;
+};
+
+
+static DocumentNode *
+node_ref (DocumentNode *node)
+{
+    if (node)
+        g_atomic_int_inc (&node->ref_count);
+
+    return node;
+}
+
+static void
+node_unref (DocumentNode *node)
+{
+    if (!node || !g_atomic_int_dec_and_test (&node->ref_count))
+        return;
+
+    node_unref (node->left);
+    node_unref (node->right);
+    g_bytes_unref (node->buffer);
+
+    g_slice_free (DocumentNode, node);
+}
+
+#define SUBTREE_LENGTH(node) ((node) ? (node)->subtree_length : 0)
+
+/* Takes ownership of left and right */
+static DocumentNode *
+node_new (GBytes       *buffer,
+          gsize         offset,
+          gsize         length,
+          DocumentNode *left,
+          DocumentNode *right,
+          guint32       priority)
+{
+    DocumentNode *node;
+
+    node = g_slice_new (DocumentNode);
+
+    node->ref_count = 1;
+    node->priority = priority;
+    node->left = left;
+    node->right = right;
+    node->buffer = g_bytes_ref (buffer);
+    node->offset = offset;
+    node->length = length;
+    node->subtree_length = SUBTREE_LENGTH (left) + length + SUBTREE_LENGTH (right);
+
+    return node;
+}
+
+/*
+ * Splits a tree into its first position bytes and the rest,
+ * splitting a piece if needed
+ * The tree is left untouched, left and right are new references
+ */
+static void
+node_split (DocumentNode  *node,
+            gsize          position,
+            DocumentNode **left,
+            DocumentNode **right)
+{
+    DocumentNode *subtree;
+    gsize left_length, cut;
+
+    if (!node || !position)
+    {
+        *left = NULL;
+        *right = node_ref (node);
+        return;
+    }
+
+    if (position >= node->subtree_length)
+    {
+        *left = node_ref (node);
+        *right = NULL;
+        return;
+    }
+
+    left_length = SUBTREE_LENGTH (node->left);
+
+    if (position <= left_length)
+    {
+        node_split (node->left, position, left, &subtree);
+        *right = node_new (node->buffer, node->offset, node->length,
+                           subtree, node_ref (node->right), node->priority);
+    }
+    else if (position >= left_length + node->length)
+    {
+        node_split (node->right, position - left_length - node->length, &subtree, right);
+        *left = node_new (node->buffer, node->offset, node->length,
+                          node_ref (node->left), subtree, node->priority);
+    }
+    else
+    {
+        cut = position - left_length;
+
+        *left = node_new (node->buffer, node->offset, cut,
+                          node_ref (node->left), NULL, node->priority);
+        *right = node_new (node->buffer, node->offset + cut, node->length - cut,
+                           NULL, node_ref (node->right), node->priority);
+    }
+}
+
+/*
+ * Concatenates two trees
+ * The trees are left untouched, returns a new reference
+ */
+static DocumentNode *
+node_merge (DocumentNode *left,
+            DocumentNode *right)
+{
+    if (!left)
+        return node_ref (right);
+    if (!right)
+        return node_ref (left);
+
+    if (left->priority > right->priority)
+        return node_new (left->buffer, left->offset, left->length,
+                         node_ref (left->left), node_merge (left->right, right),
+                         left->priority);
+    else
+        return node_new (right->buffer, right->offset, right->length,
+                         node_merge (left, right->left), node_ref (right->right),
+                         right->priority);
+}
+
+/*
+ * Finds the piece holding the byte at offset
+ * Returns the piece's bytes from offset on, and their length
+ */
+static const guchar *
+node_get_chunk (const DocumentNode *node,
+                gsize               offset,
+                gsize              *chunk_length)
+{
+    gsize left_length;
+
+    while (node)
+    {
+        left_length = SUBTREE_LENGTH (node->left);
+
+        if (offset < left_length)
+        {
+            node = node->left;
+        }
+        else if (offset < left_length + node->length)
+        {
+            offset -= left_length;
+
+            *chunk_length = node->length - offset;
+            return (const guchar *) g_bytes_get_data (node->buffer, NULL) + node->offset + offset;
+        }
+        else
+        {
+            offset -= left_length + node->length;
+            node = node->right;
+        }
+    }
+
+    *chunk_length = 0;
+    return NULL;
+}
+
+/* Replaces the document's tree with the concatenation of three trees */
+static void
+document_set_root (ChirurgienDocument *document,
+                   DocumentNode       *left,
+                   DocumentNode       *middle,
+                   DocumentNode       *right)
+{
+    DocumentNode *left_middle;
+
+    left_middle = node_merge (left, middle);
+
+    node_unref (document->root);
+    document->root = node_merge (left_middle, right);
+
+    node_unref (left_middle);
+}
+
+/*** Public API ***/
+
+/* Takes a reference to the original buffer, if any */
+ChirurgienDocument *
+chirurgien_document_new (GBytes *original)
+{
+    ChirurgienDocument *document;
+
+    document = g_slice_new0 (ChirurgienDocument);
+
+    if (original && g_bytes_get_size (original))
+        document->root = node_new (original, 0, g_bytes_get_size (original),
+                                   NULL, NULL, g_random_int ());
+
+    return document;
+}
+
+/* The snapshot is not affected by later edits of the document, and can be
+ * used from another thread */
+ChirurgienDocument *
+chirurgien_document_snapshot (const ChirurgienDocument *document)
+{
+    ChirurgienDocument *snapshot;
+
+    snapshot = g_slice_new (ChirurgienDocument);
+    snapshot->root = node_ref (document->root);
+
+    return snapshot;
+}
+
+void
+chirurgien_document_free (gpointer data)
+{
+    ChirurgienDocument *document;
+
+    document = data;
+
+    if (document)
+    {
+        node_unref (document->root);
+        g_slice_free (ChirurgienDocument, document);
+    }
+}
+
+gsize
+chirurgien_document_get_size (const ChirurgienDocument *document)
+{
+    return SUBTREE_LENGTH (document->root);
+}
+
+/*
+ * Copies up to length bytes, starting at offset, to destination
+ * Returns the number of bytes copied
+ */
+gsize
+chirurgien_document_read (const ChirurgienDocument *document,
+                          gsize                     offset,
+                          gsize                     length,
+                          guchar                   *destination)
+{
+    ChirurgienDocumentCursor cursor;
+    gsize copied, chunk_length;
+
+    copied = 0;
+
+    for (chirurgien_document_cursor_init (&cursor, document, offset);
+         cursor.chunk && copied < length;
+         chirurgien_document_cursor_next (&cursor))
+    {
+        chunk_length = MIN (cursor.chunk_length, length - copied);
+        memcpy (destination + copied, cursor.chunk, chunk_length);
+
+        copied += chunk_length;
+    }
+
+    return copied;
+}
+
+void
+chirurgien_document_insert (ChirurgienDocument *document,
+                            gsize               offset,
+                            const guchar       *data,
+                            gsize               length)
+{
+    DocumentNode *left, *right, *piece;
+    GBytes *buffer;
+
+    if (!length)
+        return;
+
+    buffer = g_bytes_new (data, length);
+    piece = node_new (buffer, 0, length, NULL, NULL, g_random_int ());
+    g_bytes_unref (buffer);
+
+    node_split (document->root, offset, &left, &right);
+    document_set_root (document, left, piece, right);
+
+    node_unref (left);
+    node_unref (piece);
+    node_unref (right);
+}
+
+void
+chirurgien_document_delete (ChirurgienDocument *document,
+                            gsize               offset,
+                            gsize               length)
+{
+    DocumentNode *left, *rest, *deleted, *right;
+
+    node_split (document->root, offset, &left, &rest);
+    node_split (rest, length, &deleted, &right);
+    document_set_root (document, left, NULL, right);
+
+    node_unref (left);
+    node_unref (rest);
+    node_unref (deleted);
+    node_unref (right);
+}
+
+/* Overwrites length bytes at offset */
+void
+chirurgien_document_replace (ChirurgienDocument *document,
+                             gsize               offset,
+                             const guchar       *data,
+                             gsize               length)
+{
+    DocumentNode *left, *rest, *replaced, *right, *piece;
+    GBytes *buffer;
+
+    if (!length)
+        return;
+
+    buffer = g_bytes_new (data, length);
+    piece = node_new (buffer, 0, length, NULL, NULL, g_random_int ());
+    g_bytes_unref (buffer);
+
+    node_split (document->root, offset, &left, &rest);
+    node_split (rest, length, &replaced, &right);
+    document_set_root (document, left, piece, right);
+
+    node_unref (left);
+    node_unref (rest);
+    node_unref (replaced);
+    node_unref (right);
+    node_unref (piece);
+}
+
+void
+chirurgien_document_cursor_init (ChirurgienDocumentCursor *cursor,
+                                 const ChirurgienDocument *document,
+                                 gsize                     offset)
+{
+    cursor->document = document;
+    cursor->offset = offset;
+    cursor->chunk = node_get_chunk (document->root, offset, &cursor->chunk_length);
+}
+
+/* Moves to the next chunk, returns FALSE at the end of the document */
+gboolean
+chirurgien_document_cursor_next (ChirurgienDocumentCursor *cursor)
+{
+    if (!cursor->chunk)
+        return FALSE;
+
+    cursor->offset += cursor->chunk_length;
+    cursor->chunk = node_get_chunk (cursor->document->root, cursor->offset, &cursor->chunk_length);
+
+    return cursor->chunk != NULL;
+}
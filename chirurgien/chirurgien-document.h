@@ -0,0 +1,74 @@
+/* chirurgien-document.h
+ *
+ * Copyright (C) 2021 - Daniel Léonard Schardijn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/*
+ * The contents of a view, a piece table over the original file buffer
+ * and the buffers of the inserted bytes
+ * Pieces are kept in a persistent balanced tree: edits cost O(log pieces),
+ * and snapshots share the tree with the document
+ */
+typedef struct _ChirurgienDocument ChirurgienDocument;
+
+/* Iterates over the contiguous chunks of a document */
+typedef struct
+{
+    const ChirurgienDocument *document;
+
+    /* Document offset of the current chunk */
+    gsize                     offset;
+
+    /* The current chunk, NULL at the end of the document */
+    const guchar             *chunk;
+    gsize                     chunk_length;
+
+} ChirurgienDocumentCursor;
+
+ChirurgienDocument *  chirurgien_document_new            (GBytes *);
+ChirurgienDocument *  chirurgien_document_snapshot       (const ChirurgienDocument *);
+void                  chirurgien_document_free           (gpointer);
+
+gsize                 chirurgien_document_get_size       (const ChirurgienDocument *);
+gsize                 chirurgien_document_read           (const ChirurgienDocument *,
+                                                          gsize,
+                                                          gsize,
+                                                          guchar *);
+
+void                  chirurgien_document_insert         (ChirurgienDocument *,
+                                                          gsize,
+                                                          const guchar *,
+                                                          gsize);
+void                  chirurgien_document_delete         (ChirurgienDocument *,
+                                                          gsize,
+                                                          gsize);
+void                  chirurgien_document_replace        (ChirurgienDocument *,
+                                                          gsize,
+                                                          const guchar *,
+                                                          gsize);
+
+void                  chirurgien_document_cursor_init    (ChirurgienDocumentCursor *,
+                                                          const ChirurgienDocument *,
+                                                          gsize);
+gboolean              chirurgien_document_cursor_next    (ChirurgienDocumentCursor *);
+
+G_END_DECLS
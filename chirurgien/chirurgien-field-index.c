@@ -0,0 +1,163 @@
+/* chirurgien-field-index.c
+ *
+ * Copyright (C) 2021 - Daniel Léonard Schardijn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "chirurgien-field-index.h"
+
+
+struct _ChirurgienFieldIndex
+{
+    /* The fields, sorted by offset */
+    FieldTable     *fields;
+
+    /* Segment tree of the greatest field end, node i covers nodes 2i and 2i + 1
+     * Leaves start at n_leaves, a power of two, in offset order */
+    gsize          *max_end;
+    guint           n_leaves;
+
+};
+
+/*
+ * Takes ownership of a FieldTable, sorted by offset
+ */
+ChirurgienFieldIndex *
+chirurgien_field_index_new (FieldTable *fields)
+{
+    ChirurgienFieldIndex *index;
+
+    index = g_slice_new (ChirurgienFieldIndex);
+
+    index->fields = fields;
+
+    index->n_leaves = 1;
+    while (index->n_leaves < fields->n_fields)
+        index->n_leaves *= 2;
+
+    /* Leaves past the last field end at 0, they never overlap */
+    index->max_end = g_new0 (gsize, index->n_leaves * 2);
+
+    for (guint i = 0; i < fields->n_fields; i++)
+        index->max_end[index->n_leaves + i] = fields->offsets[i] + fields->sizes[i];
+
+    for (guint node = index->n_leaves - 1; node; node--)
+        index->max_end[node] = MAX (index->max_end[node * 2], index->max_end[node * 2 + 1]);
+
+    return index;
+}
+
+guint
+chirurgien_field_index_get_n_fields (const ChirurgienFieldIndex *index)
+{
+    return index->fields->n_fields;
+}
+
+void
+chirurgien_field_index_get_field (const ChirurgienFieldIndex *index,
+                                  guint                       field,
+                                  FileField                  *file_field)
+{
+    field_table_get_field (index->fields, field, file_field);
+}
+
+/*
+ * First field in [from, limit) of the subtree of node, covering [node_low, node_high),
+ * that ends past start, G_MAXUINT if none
+ * Subtrees ending at or before start are skipped
+ */
+static guint
+field_index_find (const ChirurgienFieldIndex *index,
+                  guint                       node,
+                  guint                       node_low,
+                  guint                       node_high,
+                  guint                       from,
+                  guint                       limit,
+                  gsize                       start)
+{
+    guint field, middle;
+
+    if (node_high <= from || node_low >= limit || index->max_end[node] <= start)
+        return G_MAXUINT;
+
+    if (node >= index->n_leaves)
+        return node - index->n_leaves;
+
+    middle = node_low + (node_high - node_low) / 2;
+
+    field = field_index_find (index, node * 2, node_low, middle, from, limit, start);
+    if (field == G_MAXUINT)
+        field = field_index_find (index, node * 2 + 1, middle, node_high, from, limit, start);
+
+    return field;
+}
+
+/*
+ * Finds the next field overlapping [start, end), from field from on, G_MAXUINT if none
+ * Iterating from 0 yields the overlapping fields in offset order,
+ * each in O(log n) whatever the size of the fields before them
+ */
+guint
+chirurgien_field_index_next_overlapping (const ChirurgienFieldIndex *index,
+                                         gsize                       start,
+                                         gsize                       end,
+                                         guint                       from)
+{
+    guint low, high, middle;
+
+    /* Fields starting at or past end do not overlap */
+    low = from;
+    high = index->fields->n_fields;
+
+    while (low < high)
+    {
+        middle = low + (high - low) / 2;
+
+        if (index->fields->offsets[middle] >= end)
+            high = middle;
+        else
+            low = middle + 1;
+    }
+
+    return field_index_find (index, 1, 0, index->n_leaves, from, low, start);
+}
+
+void
+chirurgien_field_index_free (gpointer data)
+{
+    ChirurgienFieldIndex *index;
+
+    index = data;
+
+    if (index)
+    {
+        field_table_free (index->fields);
+        g_free (index->max_end);
+
+        g_slice_free (ChirurgienFieldIndex, index);
+    }
+}
+
+/* Frees the index, returning its FieldTable */
+FieldTable *
+chirurgien_field_index_free_to_table (ChirurgienFieldIndex *index)
+{
+    FieldTable *fields;
+
+    fields = g_steal_pointer (&index->fields);
+    chirurgien_field_index_free (index);
+
+    return fields;
+}
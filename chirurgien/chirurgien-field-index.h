@@ -0,0 +1,48 @@
+/* chirurgien-field-index.h
+ *
+ * Copyright (C) 2021 - Daniel Léonard Schardijn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <chirurgien-formats.h>
+
+G_BEGIN_DECLS
+
+/*
+ * An index over the FieldTable of an analysis
+ * Fields are sorted by offset, and a segment tree keeps the greatest field end
+ * of every range of fields, so that the fields overlapping a byte range
+ * are found in logarithmic time each
+ */
+typedef struct _ChirurgienFieldIndex ChirurgienFieldIndex;
+
+ChirurgienFieldIndex *  chirurgien_field_index_new          (FieldTable *);
+
+guint                   chirurgien_field_index_get_n_fields (const ChirurgienFieldIndex *);
+void                    chirurgien_field_index_get_field    (const ChirurgienFieldIndex *,
+                                                             guint,
+                                                             FileField *);
+
+guint                   chirurgien_field_index_next_overlapping (const ChirurgienFieldIndex *,
+                                                                 gsize,
+                                                                 gsize,
+                                                                 guint);
+
+void                    chirurgien_field_index_free         (gpointer);
+FieldTable *            chirurgien_field_index_free_to_table (ChirurgienFieldIndex *);
+
+G_END_DECLS
@@ -27,6 +27,8 @@
 #include <chirurgien-types.h>
 #include "chirurgien-globals.h"
 #include "formats/validator/validator-utils.h"
+#include "formats/validator/chirurgien-validator.h"
+#include <chirurgien-formats.h>
 
 
 typedef struct
@@ -317,12 +319,14 @@ remove_user_format (GtkButton *self,
                                                         user_data);
     chirurgien_user_format_descriptions = g_list_remove (chirurgien_user_format_descriptions,
                                                         format_description);
+    chirurgien_formats_update ();
+
     gtk_stack_remove (dialog->formats,
                       gtk_stack_get_child_by_name (dialog->formats, format_description->name));
     gtk_list_box_remove (dialog->user_formats, gtk_widget_get_ancestor (GTK_WIDGET (self),
                                                                         GTK_TYPE_LIST_BOX_ROW));
 
-    format_definition_destroy (user_data);
+    format_definition_unref (user_data);
     g_free (format_description->name);
     g_object_unref (format_description->description);
     g_slice_free (FormatDescription, format_description);
@@ -406,6 +410,9 @@ chirurgien_formats_dialog_init (ChirurgienFormatsDialog *dialog)
         {
             format_definition = sys_format_iter->data;
 
+            /* The description lists the format's colors */
+            format_complete ((FormatDefinition *) format_definition);
+
             chirurgien_system_format_descriptions = g_slist_append (chirurgien_system_format_descriptions,
                                                     build_format_description (format_definition));
         }
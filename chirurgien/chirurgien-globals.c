@@ -18,16 +18,13 @@
 
 #include "chirurgien-globals.h"
 
-const gchar * const hex_chars = "0123456789ABCDEF";
-
 GdkRGBA    chirurgien_colors[CHIRURGIEN_TOTAL_COLORS];
 PangoColor pango_colors[CHIRURGIEN_TOTAL_COLORS];
 guint16    pango_alphas[CHIRURGIEN_TOTAL_COLORS];
+guint      pango_colors_generation = 0;
 
-GSList    *chirurgien_system_format_definitions = NULL;
 GSList    *chirurgien_system_format_descriptions = NULL;
 
-GList     *chirurgien_user_format_definitions = NULL;
 GList     *chirurgien_user_format_descriptions = NULL;
 
 /* Color name */
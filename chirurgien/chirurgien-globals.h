@@ -20,21 +20,20 @@
 
 #include <gtk/gtk.h>
 
-G_BEGIN_DECLS
-
-#define CHIRURGIEN_TOTAL_COLORS 9
+#include <chirurgien-formats-globals.h>
 
-extern const gchar * const hex_chars;
+G_BEGIN_DECLS
 
 extern GdkRGBA    chirurgien_colors[CHIRURGIEN_TOTAL_COLORS];
 
 extern PangoColor pango_colors[CHIRURGIEN_TOTAL_COLORS];
 extern guint16    pango_alphas[CHIRURGIEN_TOTAL_COLORS];
+/* Incremented when the colors change, invalidates cached highlighting */
+extern guint      pango_colors_generation;
 
-extern GSList    *chirurgien_system_format_definitions;
+/* Descriptions of the format definitions, for the formats dialog */
 extern GSList    *chirurgien_system_format_descriptions;
 
-extern GList     *chirurgien_user_format_definitions;
 extern GList     *chirurgien_user_format_descriptions;
 
 
@@ -0,0 +1,255 @@
+/* chirurgien-minimap.c
+ *
+ * Copyright (C) 2021 - Daniel Léonard Schardijn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "chirurgien-minimap.h"
+
+#include <chirurgien-formats-globals.h>
+
+/* Maximum number of ranges of the lowest level */
+#define MINIMAP_MAX_RANGES 8192
+
+
+typedef struct
+{
+    /* Bytes covered by the fields of each color */
+    guint64         coverage[CHIRURGIEN_TOTAL_COLORS];
+
+} MinimapRange;
+
+struct _ChirurgienMinimap
+{
+    gsize           file_size;
+
+    /* Ranges of the lowest level are (1 << range_shift) bytes */
+    guint           range_shift;
+
+    /* The levels, level 0 is the lowest */
+    MinimapRange  **levels;
+    gsize          *n_ranges;
+    guint           n_levels;
+
+};
+
+/* Adds the coverage of a field to the ranges of the lowest level */
+static void
+minimap_add_field (ChirurgienMinimap *minimap,
+                   gint64            *full_ranges,
+                   const FileField   *file_field)
+{
+    MinimapRange *ranges;
+    gsize field_end, first_range, last_range, range_size;
+    guint color;
+
+    ranges = minimap->levels[0];
+    range_size = (gsize) 1 << minimap->range_shift;
+
+    color = file_field->color_index;
+    field_end = MIN (file_field->field_offset + file_field->field_size, minimap->file_size);
+
+    if (file_field->field_offset >= field_end)
+        return;
+
+    first_range = file_field->field_offset >> minimap->range_shift;
+    last_range = (field_end - 1) >> minimap->range_shift;
+
+    if (first_range == last_range)
+    {
+        ranges[first_range].coverage[color] += field_end - file_field->field_offset;
+        return;
+    }
+
+    /* The partially covered ranges at both ends */
+    ranges[first_range].coverage[color] += ((first_range + 1) << minimap->range_shift) -
+                                           file_field->field_offset;
+    ranges[last_range].coverage[color] += field_end - (last_range << minimap->range_shift);
+
+    /* The fully covered ranges in between, added once all fields are */
+    if (last_range - first_range > 1)
+    {
+        full_ranges[(first_range + 1) * CHIRURGIEN_TOTAL_COLORS + color] += range_size;
+        full_ranges[last_range * CHIRURGIEN_TOTAL_COLORS + color] -= range_size;
+    }
+}
+
+/*
+ * Builds the minimap of a file from the fields of its analysis
+ * Building costs O(fields + ranges), fields spanning many ranges are not iterated
+ */
+ChirurgienMinimap *
+chirurgien_minimap_new (const ChirurgienFieldIndex *index,
+                        gsize                       file_size)
+{
+    ChirurgienMinimap *minimap;
+    MinimapRange *level, *lower_level;
+    FileField file_field;
+
+    gint64 *full_ranges, running[CHIRURGIEN_TOTAL_COLORS] = { 0 };
+    gsize n_ranges;
+
+    minimap = g_slice_new (ChirurgienMinimap);
+
+    minimap->file_size = file_size;
+
+    minimap->range_shift = 0;
+    while ((file_size >> minimap->range_shift) >= MINIMAP_MAX_RANGES)
+        minimap->range_shift++;
+
+    n_ranges = (file_size >> minimap->range_shift) + 1;
+
+    minimap->n_levels = g_bit_storage (n_ranges - 1) + 1;
+    minimap->levels = g_new (MinimapRange *, minimap->n_levels);
+    minimap->n_ranges = g_new (gsize, minimap->n_levels);
+
+    minimap->levels[0] = g_new0 (MinimapRange, n_ranges);
+    minimap->n_ranges[0] = n_ranges;
+
+    full_ranges = g_new0 (gint64, (n_ranges + 1) * CHIRURGIEN_TOTAL_COLORS);
+
+    for (guint i = 0; i < chirurgien_field_index_get_n_fields (index); i++)
+    {
+        chirurgien_field_index_get_field (index, i, &file_field);
+
+        if (file_field.color_index < CHIRURGIEN_TOTAL_COLORS)
+            minimap_add_field (minimap, full_ranges, &file_field);
+    }
+
+    for (gsize i = 0; i < n_ranges; i++)
+    {
+        for (guint color = 0; color < CHIRURGIEN_TOTAL_COLORS; color++)
+        {
+            running[color] += full_ranges[i * CHIRURGIEN_TOTAL_COLORS + color];
+            minimap->levels[0][i].coverage[color] += running[color];
+        }
+    }
+
+    g_free (full_ranges);
+
+    /* Every upper range adds up the two ranges below */
+    for (guint l = 1; l < minimap->n_levels; l++)
+    {
+        lower_level = minimap->levels[l - 1];
+        n_ranges = (minimap->n_ranges[l - 1] + 1) / 2;
+
+        level = g_new0 (MinimapRange, n_ranges);
+
+        for (gsize i = 0; i < n_ranges; i++)
+        {
+            level[i] = lower_level[i * 2];
+
+            if (i * 2 + 1 < minimap->n_ranges[l - 1])
+            {
+                for (guint color = 0; color < CHIRURGIEN_TOTAL_COLORS; color++)
+                    level[i].coverage[color] += lower_level[i * 2 + 1].coverage[color];
+            }
+        }
+
+        minimap->levels[l] = level;
+        minimap->n_ranges[l] = n_ranges;
+    }
+
+    return minimap;
+}
+
+gsize
+chirurgien_minimap_get_file_size (const ChirurgienMinimap *minimap)
+{
+    return minimap->file_size;
+}
+
+/*
+ * Fills colors with the dominant field color of n_rows equal parts of the file,
+ * CHIRURGIEN_MINIMAP_NO_COLOR if no field is there
+ * Every row is read from the highest level with ranges no larger than the row,
+ * it adds up at most 3 ranges
+ */
+void
+chirurgien_minimap_get_colors (const ChirurgienMinimap *minimap,
+                               guint8                  *colors,
+                               guint                    n_rows)
+{
+    const MinimapRange *level;
+    guint64 coverage[CHIRURGIEN_TOTAL_COLORS], dominant_coverage;
+    gsize row_size, row_start, row_end, first_range, last_range;
+    guint l, shift;
+
+    if (!n_rows)
+        return;
+
+    row_size = MAX (minimap->file_size / n_rows, 1);
+
+    for (l = 0; l + 1 < minimap->n_levels; l++)
+    {
+        if (((gsize) 1 << (minimap->range_shift + l + 1)) > row_size)
+            break;
+    }
+
+    level = minimap->levels[l];
+    shift = minimap->range_shift + l;
+
+    for (guint row = 0; row < n_rows; row++)
+    {
+        colors[row] = CHIRURGIEN_MINIMAP_NO_COLOR;
+
+        row_start = (guint64) minimap->file_size * row / n_rows;
+        row_end = (guint64) minimap->file_size * (row + 1) / n_rows;
+
+        if (row_start >= row_end)
+            continue;
+
+        first_range = row_start >> shift;
+        last_range = (row_end - 1) >> shift;
+
+        memset (coverage, 0, sizeof (coverage));
+
+        for (gsize i = first_range; i <= last_range; i++)
+        {
+            for (guint color = 0; color < CHIRURGIEN_TOTAL_COLORS; color++)
+                coverage[color] += level[i].coverage[color];
+        }
+
+        dominant_coverage = 0;
+
+        for (guint color = 0; color < CHIRURGIEN_TOTAL_COLORS; color++)
+        {
+            if (coverage[color] > dominant_coverage)
+            {
+                dominant_coverage = coverage[color];
+                colors[row] = color;
+            }
+        }
+    }
+}
+
+void
+chirurgien_minimap_free (gpointer data)
+{
+    ChirurgienMinimap *minimap;
+
+    minimap = data;
+
+    if (minimap)
+    {
+        for (guint l = 0; l < minimap->n_levels; l++)
+            g_free (minimap->levels[l]);
+
+        g_free (minimap->levels);
+        g_free (minimap->n_ranges);
+
+        g_slice_free (ChirurgienMinimap, minimap);
+    }
+}
@@ -0,0 +1,46 @@
+/* chirurgien-minimap.h
+ *
+ * Copyright (C) 2021 - Daniel Léonard Schardijn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "chirurgien-field-index.h"
+
+G_BEGIN_DECLS
+
+/* No field color in a minimap row */
+#define CHIRURGIEN_MINIMAP_NO_COLOR G_MAXUINT8
+
+/*
+ * An overview of the fields of a whole file: a pyramid of byte ranges,
+ * each level halving the number of ranges of the level below
+ * Every range keeps the bytes covered by each field color, the dominant color
+ * of n rows is found in O(n), whatever the number of fields
+ */
+typedef struct _ChirurgienMinimap ChirurgienMinimap;
+
+ChirurgienMinimap *     chirurgien_minimap_new              (const ChirurgienFieldIndex *,
+                                                             gsize);
+
+gsize                   chirurgien_minimap_get_file_size    (const ChirurgienMinimap *);
+void                    chirurgien_minimap_get_colors       (const ChirurgienMinimap *,
+                                                             guint8 *,
+                                                             guint);
+
+void                    chirurgien_minimap_free             (gpointer);
+
+G_END_DECLS
@@ -149,6 +149,7 @@ reset_default_colors (G_GNUC_UNUSED GtkButton *button,
 
         g_free (color_string);
     }
+    pango_colors_generation++;
 
     set_colors (dialog);
 }
@@ -178,6 +179,7 @@ color_selected (GtkColorButton *button,
     pango_colors[ color_index ].green = color.green * 65535;
     pango_colors[ color_index ].blue = color.blue * 65535;
     pango_alphas[ color_index ] = color.alpha * 65535;
+    pango_colors_generation++;
 
     g_settings_set_string (dialog->preferences_settings,
                            get_color_name (color_index),
@@ -0,0 +1,454 @@
+/* chirurgien-print.c
+ *
+ * Copyright (C) 2021 - Daniel Léonard Schardijn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "chirurgien-print.h"
+
+#include <string.h>
+
+#include <chirurgien-formats-globals.h>
+
+#if defined (__GNUC__) && (defined (__x86_64__) || defined (__i386__))
+#define PRINT_X86_KERNELS
+#include <immintrin.h>
+#elif defined (__GNUC__) && defined (__aarch64__)
+#define PRINT_NEON_KERNELS
+#include <arm_neon.h>
+#endif
+
+
+static void
+hex_kernel_scalar (gchar        *destination,
+                   const guchar *source,
+                   gsize         n_bytes)
+{
+    for (gsize i = 0; i < n_bytes; i++)
+    {
+        *destination++ = hex_chars[ source[i] >> 4 ];
+        *destination++ = hex_chars[ source[i] & 0x0F ];
+        *destination++ = ' ';
+    }
+}
+
+static void
+text_kernel_scalar (gchar        *destination,
+                    const guchar *source,
+                    gsize         n_bytes)
+{
+    for (gsize i = 0; i < n_bytes; i++)
+    {
+        *destination++ = g_ascii_isgraph (source[i]) ? source[i] : '.';
+        *destination++ = ' ';
+        *destination++ = ' ';
+    }
+}
+
+#ifdef PRINT_X86_KERNELS
+
+/* Shuffles spreading 16 hex pairs (bytes 0-7 in the first register, 8-15 in
+ * the second) or 16 text characters over 48 bytes of 3-character cells,
+ * the 0x80 entries are then filled with the spaces */
+static const guint8 hex_first_shuffle[2][16] =
+{
+    { 0x00, 0x01, 0x80, 0x02, 0x03, 0x80, 0x04, 0x05, 0x80, 0x06, 0x07, 0x80, 0x08, 0x09, 0x80, 0x0A },
+    { 0x0B, 0x80, 0x0C, 0x0D, 0x80, 0x0E, 0x0F, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 }
+};
+
+static const guint8 hex_second_shuffle[2][16] =
+{
+    { 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x00, 0x01, 0x80, 0x02, 0x03, 0x80, 0x04, 0x05 },
+    { 0x80, 0x06, 0x07, 0x80, 0x08, 0x09, 0x80, 0x0A, 0x0B, 0x80, 0x0C, 0x0D, 0x80, 0x0E, 0x0F, 0x80 }
+};
+
+static const guint8 hex_spaces[3][16] =
+{
+    { 0x00, 0x00, 0x20, 0x00, 0x00, 0x20, 0x00, 0x00, 0x20, 0x00, 0x00, 0x20, 0x00, 0x00, 0x20, 0x00 },
+    { 0x00, 0x20, 0x00, 0x00, 0x20, 0x00, 0x00, 0x20, 0x00, 0x00, 0x20, 0x00, 0x00, 0x20, 0x00, 0x00 },
+    { 0x20, 0x00, 0x00, 0x20, 0x00, 0x00, 0x20, 0x00, 0x00, 0x20, 0x00, 0x00, 0x20, 0x00, 0x00, 0x20 }
+};
+
+static const guint8 text_shuffle[3][16] =
+{
+    { 0x00, 0x80, 0x80, 0x01, 0x80, 0x80, 0x02, 0x80, 0x80, 0x03, 0x80, 0x80, 0x04, 0x80, 0x80, 0x05 },
+    { 0x80, 0x80, 0x06, 0x80, 0x80, 0x07, 0x80, 0x80, 0x08, 0x80, 0x80, 0x09, 0x80, 0x80, 0x0A, 0x80 },
+    { 0x80, 0x0B, 0x80, 0x80, 0x0C, 0x80, 0x80, 0x0D, 0x80, 0x80, 0x0E, 0x80, 0x80, 0x0F, 0x80, 0x80 }
+};
+
+static const guint8 text_spaces[3][16] =
+{
+    { 0x00, 0x20, 0x20, 0x00, 0x20, 0x20, 0x00, 0x20, 0x20, 0x00, 0x20, 0x20, 0x00, 0x20, 0x20, 0x00 },
+    { 0x20, 0x20, 0x00, 0x20, 0x20, 0x00, 0x20, 0x20, 0x00, 0x20, 0x20, 0x00, 0x20, 0x20, 0x00, 0x20 },
+    { 0x20, 0x00, 0x20, 0x20, 0x00, 0x20, 0x20, 0x00, 0x20, 0x20, 0x00, 0x20, 0x20, 0x00, 0x20, 0x20 }
+};
+
+#define LOAD_TABLE(table) _mm_loadu_si128 ((const __m128i *) (table))
+
+/* Stores the cells of 16 bytes, from their hex pairs
+ * Inlined, so that the AVX2 kernels do not mix in legacy SSE encodings */
+__attribute__ ((target ("ssse3"), always_inline))
+static inline void
+hex_store_ssse3 (gchar   *destination,
+                 __m128i  first_pairs,
+                 __m128i  second_pairs)
+{
+    __m128i cells;
+
+    cells = _mm_or_si128 (_mm_shuffle_epi8 (first_pairs, LOAD_TABLE (hex_first_shuffle[0])),
+                          LOAD_TABLE (hex_spaces[0]));
+    _mm_storeu_si128 ((__m128i *) destination, cells);
+
+    cells = _mm_or_si128 (_mm_or_si128 (_mm_shuffle_epi8 (first_pairs, LOAD_TABLE (hex_first_shuffle[1])),
+                                        _mm_shuffle_epi8 (second_pairs, LOAD_TABLE (hex_second_shuffle[0]))),
+                          LOAD_TABLE (hex_spaces[1]));
+    _mm_storeu_si128 ((__m128i *) (destination + 16), cells);
+
+    cells = _mm_or_si128 (_mm_shuffle_epi8 (second_pairs, LOAD_TABLE (hex_second_shuffle[1])),
+                          LOAD_TABLE (hex_spaces[2]));
+    _mm_storeu_si128 ((__m128i *) (destination + 32), cells);
+}
+
+/* Stores the cells of 16 text characters */
+__attribute__ ((target ("ssse3"), always_inline))
+static inline void
+text_store_ssse3 (gchar   *destination,
+                  __m128i  characters)
+{
+    for (gint i = 0; i < 3; i++)
+        _mm_storeu_si128 ((__m128i *) (destination + i * 16),
+                          _mm_or_si128 (_mm_shuffle_epi8 (characters, LOAD_TABLE (text_shuffle[i])),
+                                        LOAD_TABLE (text_spaces[i])));
+}
+
+__attribute__ ((target ("ssse3")))
+static void
+hex_kernel_ssse3 (gchar        *destination,
+                  const guchar *source,
+                  gsize         n_bytes)
+{
+    const __m128i digits = _mm_loadu_si128 ((const __m128i *) hex_chars);
+    const __m128i nibble_mask = _mm_set1_epi8 (0x0F);
+    __m128i bytes, high, low;
+    gsize i;
+
+    for (i = 0; i + 16 <= n_bytes; i += 16)
+    {
+        bytes = _mm_loadu_si128 ((const __m128i *) (source + i));
+
+        high = _mm_shuffle_epi8 (digits, _mm_and_si128 (_mm_srli_epi16 (bytes, 4), nibble_mask));
+        low = _mm_shuffle_epi8 (digits, _mm_and_si128 (bytes, nibble_mask));
+
+        hex_store_ssse3 (destination + i * 3,
+                         _mm_unpacklo_epi8 (high, low),
+                         _mm_unpackhi_epi8 (high, low));
+    }
+
+    hex_kernel_scalar (destination + i * 3, source + i, n_bytes - i);
+}
+
+/* Printable characters are 0x21-0x7E: as signed bytes, greater than 0x20 and less than 0x7F */
+__attribute__ ((target ("ssse3")))
+static void
+text_kernel_ssse3 (gchar        *destination,
+                   const guchar *source,
+                   gsize         n_bytes)
+{
+    const __m128i lowest = _mm_set1_epi8 (0x20);
+    const __m128i highest = _mm_set1_epi8 (0x7F);
+    const __m128i dots = _mm_set1_epi8 ('.');
+    __m128i bytes, printable;
+    gsize i;
+
+    for (i = 0; i + 16 <= n_bytes; i += 16)
+    {
+        bytes = _mm_loadu_si128 ((const __m128i *) (source + i));
+
+        printable = _mm_and_si128 (_mm_cmpgt_epi8 (bytes, lowest),
+                                   _mm_cmplt_epi8 (bytes, highest));
+
+        text_store_ssse3 (destination + i * 3,
+                          _mm_or_si128 (_mm_and_si128 (printable, bytes),
+                                        _mm_andnot_si128 (printable, dots)));
+    }
+
+    text_kernel_scalar (destination + i * 3, source + i, n_bytes - i);
+}
+
+/* 32 bytes at a time, the cells are spread by 128-bit lane as in the SSSE3 kernels */
+__attribute__ ((target ("avx2")))
+static void
+hex_kernel_avx2 (gchar        *destination,
+                 const guchar *source,
+                 gsize         n_bytes)
+{
+    const __m256i digits = _mm256_broadcastsi128_si256 (_mm_loadu_si128 ((const __m128i *) hex_chars));
+    const __m256i nibble_mask = _mm256_set1_epi8 (0x0F);
+    __m256i bytes, high, low, first_pairs, second_pairs;
+    gsize i;
+
+    for (i = 0; i + 32 <= n_bytes; i += 32)
+    {
+        bytes = _mm256_loadu_si256 ((const __m256i *) (source + i));
+
+        high = _mm256_shuffle_epi8 (digits, _mm256_and_si256 (_mm256_srli_epi16 (bytes, 4), nibble_mask));
+        low = _mm256_shuffle_epi8 (digits, _mm256_and_si256 (bytes, nibble_mask));
+
+        first_pairs = _mm256_unpacklo_epi8 (high, low);
+        second_pairs = _mm256_unpackhi_epi8 (high, low);
+
+        hex_store_ssse3 (destination + i * 3,
+                         _mm256_castsi256_si128 (first_pairs),
+                         _mm256_castsi256_si128 (second_pairs));
+        hex_store_ssse3 (destination + i * 3 + 48,
+                         _mm256_extracti128_si256 (first_pairs, 1),
+                         _mm256_extracti128_si256 (second_pairs, 1));
+    }
+
+    if (i + 16 <= n_bytes)
+    {
+        bytes = _mm256_castsi128_si256 (_mm_loadu_si128 ((const __m128i *) (source + i)));
+
+        high = _mm256_shuffle_epi8 (digits, _mm256_and_si256 (_mm256_srli_epi16 (bytes, 4), nibble_mask));
+        low = _mm256_shuffle_epi8 (digits, _mm256_and_si256 (bytes, nibble_mask));
+
+        hex_store_ssse3 (destination + i * 3,
+                         _mm256_castsi256_si128 (_mm256_unpacklo_epi8 (high, low)),
+                         _mm256_castsi256_si128 (_mm256_unpackhi_epi8 (high, low)));
+        i += 16;
+    }
+
+    /* Avoid the AVX-SSE transition penalty in the code that follows */
+    _mm256_zeroupper ();
+
+    hex_kernel_scalar (destination + i * 3, source + i, n_bytes - i);
+}
+
+__attribute__ ((target ("avx2")))
+static void
+text_kernel_avx2 (gchar        *destination,
+                  const guchar *source,
+                  gsize         n_bytes)
+{
+    const __m256i lowest = _mm256_set1_epi8 (0x20);
+    const __m256i highest = _mm256_set1_epi8 (0x7F);
+    const __m256i dots = _mm256_set1_epi8 ('.');
+    __m256i bytes, printable, characters;
+    gsize i;
+
+    for (i = 0; i + 32 <= n_bytes; i += 32)
+    {
+        bytes = _mm256_loadu_si256 ((const __m256i *) (source + i));
+
+        printable = _mm256_and_si256 (_mm256_cmpgt_epi8 (bytes, lowest),
+                                      _mm256_cmpgt_epi8 (highest, bytes));
+        characters = _mm256_blendv_epi8 (dots, bytes, printable);
+
+        text_store_ssse3 (destination + i * 3, _mm256_castsi256_si128 (characters));
+        text_store_ssse3 (destination + i * 3 + 48, _mm256_extracti128_si256 (characters, 1));
+    }
+
+    if (i + 16 <= n_bytes)
+    {
+        bytes = _mm256_castsi128_si256 (_mm_loadu_si128 ((const __m128i *) (source + i)));
+
+        printable = _mm256_and_si256 (_mm256_cmpgt_epi8 (bytes, lowest),
+                                      _mm256_cmpgt_epi8 (highest, bytes));
+        characters = _mm256_blendv_epi8 (dots, bytes, printable);
+
+        text_store_ssse3 (destination + i * 3, _mm256_castsi256_si128 (characters));
+        i += 16;
+    }
+
+    /* Avoid the AVX-SSE transition penalty in the code that follows */
+    _mm256_zeroupper ();
+
+    text_kernel_scalar (destination + i * 3, source + i, n_bytes - i);
+}
+
+#endif /* PRINT_X86_KERNELS */
+
+#ifdef PRINT_NEON_KERNELS
+
+/* NEON stores 3-way interleaved registers: the cells are written directly */
+static void
+hex_kernel_neon (gchar        *destination,
+                 const guchar *source,
+                 gsize         n_bytes)
+{
+    const uint8x16_t digits = vld1q_u8 ((const uint8_t *) hex_chars);
+    const uint8x16_t nibble_mask = vdupq_n_u8 (0x0F);
+    uint8x16x3_t cells;
+    uint8x16_t bytes;
+    gsize i;
+
+    cells.val[2] = vdupq_n_u8 (' ');
+
+    for (i = 0; i + 16 <= n_bytes; i += 16)
+    {
+        bytes = vld1q_u8 (source + i);
+
+        cells.val[0] = vqtbl1q_u8 (digits, vshrq_n_u8 (bytes, 4));
+        cells.val[1] = vqtbl1q_u8 (digits, vandq_u8 (bytes, nibble_mask));
+
+        vst3q_u8 ((uint8_t *) destination + i * 3, cells);
+    }
+
+    hex_kernel_scalar (destination + i * 3, source + i, n_bytes - i);
+}
+
+static void
+text_kernel_neon (gchar        *destination,
+                  const guchar *source,
+                  gsize         n_bytes)
+{
+    uint8x16x3_t cells;
+    uint8x16_t bytes, printable;
+    gsize i;
+
+    cells.val[1] = vdupq_n_u8 (' ');
+    cells.val[2] = vdupq_n_u8 (' ');
+
+    for (i = 0; i + 16 <= n_bytes; i += 16)
+    {
+        bytes = vld1q_u8 (source + i);
+
+        printable = vandq_u8 (vcgtq_u8 (bytes, vdupq_n_u8 (0x20)),
+                              vcltq_u8 (bytes, vdupq_n_u8 (0x7F)));
+        cells.val[0] = vbslq_u8 (printable, bytes, vdupq_n_u8 ('.'));
+
+        vst3q_u8 ((uint8_t *) destination + i * 3, cells);
+    }
+
+    text_kernel_scalar (destination + i * 3, source + i, n_bytes - i);
+}
+
+#endif /* PRINT_NEON_KERNELS */
+
+/* The kernels supported by the CPU, the last one is the fastest */
+static ChirurgienPrintKernels print_kernels[4];
+static guint n_print_kernels;
+
+static void
+print_kernels_initialize (void)
+{
+    static gsize initialized = 0;
+
+    if (g_once_init_enter (&initialized))
+    {
+        print_kernels[n_print_kernels++] = (ChirurgienPrintKernels) { "scalar", hex_kernel_scalar, text_kernel_scalar };
+
+#ifdef PRINT_X86_KERNELS
+        __builtin_cpu_init ();
+
+        if (__builtin_cpu_supports ("ssse3"))
+            print_kernels[n_print_kernels++] = (ChirurgienPrintKernels) { "ssse3", hex_kernel_ssse3, text_kernel_ssse3 };
+        if (__builtin_cpu_supports ("avx2"))
+            print_kernels[n_print_kernels++] = (ChirurgienPrintKernels) { "avx2", hex_kernel_avx2, text_kernel_avx2 };
+#endif
+#ifdef PRINT_NEON_KERNELS
+        print_kernels[n_print_kernels++] = (ChirurgienPrintKernels) { "neon", hex_kernel_neon, text_kernel_neon };
+#endif
+
+        g_once_init_leave (&initialized, 1);
+    }
+}
+
+/* The fastest kernels supported by the CPU */
+const ChirurgienPrintKernels *
+chirurgien_print_kernels_get (void)
+{
+    print_kernels_initialize ();
+
+    return &print_kernels[n_print_kernels - 1];
+}
+
+/* All the kernels supported by the CPU, from the slowest to the fastest */
+const ChirurgienPrintKernels *
+chirurgien_print_kernels_get_all (guint *n_kernels)
+{
+    print_kernels_initialize ();
+
+    *n_kernels = n_print_kernels;
+
+    return print_kernels;
+}
+
+/*
+ * Formats the raw source from start_offset into destination, a line break
+ * replaces the last character of every line_break characters
+ * Lines are formatted one at a time, their line break written with them
+ */
+void
+chirurgien_print_formatted (ChirurgienPrintKernel  kernel,
+                            gchar                 *destination,
+                            const guchar          *raw_source,
+                            gsize                  start_offset,
+                            gsize                  destination_size,
+                            gsize                  raw_source_size,
+                            gsize                  line_break)
+{
+    gchar last_cell[3];
+    gsize n_bytes, line_bytes, chunk, formatted_index, partial;
+    gboolean whole_cells;
+
+    n_bytes = raw_source_size > start_offset ? raw_source_size - start_offset : 0;
+    n_bytes = MIN (n_bytes, destination_size / 3);
+    raw_source += start_offset;
+
+    /* Cells are never split by a line break if it is a multiple of the cell size */
+    whole_cells = line_break && !(line_break % 3);
+    line_bytes = whole_cells ? line_break / 3 : n_bytes;
+    formatted_index = 0;
+
+    while (n_bytes)
+    {
+        chunk = MIN (line_bytes, n_bytes);
+
+        kernel (destination + formatted_index, raw_source, chunk);
+
+        raw_source += chunk;
+        n_bytes -= chunk;
+        formatted_index += chunk * 3;
+
+        if (whole_cells && chunk == line_bytes)
+            destination[formatted_index - 1] = '\n';
+    }
+
+    /* A last cell that does not fit */
+    partial = destination_size - formatted_index;
+    if (partial && partial < 3 && raw_source_size > start_offset + formatted_index / 3)
+    {
+        kernel (last_cell, raw_source, 1);
+        memcpy (destination + formatted_index, last_cell, partial);
+        formatted_index += partial;
+    }
+
+    if (formatted_index < destination_size)
+        destination[formatted_index] = '\0';
+
+    if (!line_break)
+        return;
+
+    /* Line breaks past the formatted bytes, or all of them if lines split cells */
+    formatted_index = whole_cells ? formatted_index + 1 : 0;
+
+    for (formatted_index += (line_break - 1 - formatted_index % line_break) % line_break;
+         formatted_index < destination_size;
+         formatted_index += line_break)
+    {
+        destination[formatted_index] = '\n';
+    }
+}
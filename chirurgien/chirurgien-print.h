@@ -0,0 +1,55 @@
+/* chirurgien-print.h
+ *
+ * Copyright (C) 2021 - Daniel Léonard Schardijn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/*
+ * Kernels formatting bytes as 3-character cells: "XX " (hex) or "c  " (text)
+ * They write 3 * n_bytes characters, without line breaks
+ */
+typedef void (*ChirurgienPrintKernel) (gchar *,
+                                       const guchar *,
+                                       gsize);
+
+typedef struct
+{
+    const gchar           *name;
+
+    ChirurgienPrintKernel  hex;
+    ChirurgienPrintKernel  text;
+
+} ChirurgienPrintKernels;
+
+const ChirurgienPrintKernels *
+            chirurgien_print_kernels_get        (void);
+const ChirurgienPrintKernels *
+            chirurgien_print_kernels_get_all    (guint *);
+
+void        chirurgien_print_formatted          (ChirurgienPrintKernel,
+                                                 gchar *,
+                                                 const guchar *,
+                                                 gsize,
+                                                 gsize,
+                                                 gsize,
+                                                 gsize);
+
+G_END_DECLS
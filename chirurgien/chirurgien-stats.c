@@ -0,0 +1,606 @@
+/* chirurgien-stats.c
+ *
+ * Copyright (C) 2021 - Daniel Léonard Schardijn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "chirurgien-stats.h"
+
+#include <math.h>
+
+/* Blocks per chunk, chunks are computed in parallel */
+#define STATS_CHUNK_BLOCKS 256
+#define STATS_CHUNK_SIZE (CHIRURGIEN_STATS_BLOCK_SIZE * STATS_CHUNK_BLOCKS)
+
+/* Byte counts of a chunk, and of a region or the whole file */
+typedef guint32 StatsChunkCounts[256];
+typedef guint64 StatsCounts[256];
+
+
+struct _ChirurgienStats
+{
+    gint                  ref_count;
+
+    gsize                 file_size;
+
+    /* Byte counts of the whole file */
+    guint64               histogram[256];
+    gdouble               entropy;
+    gdouble               chi_square;
+
+    guint                 n_blocks;
+    gfloat               *block_entropies;
+    gfloat               *block_chi_squares;
+
+    /* Byte counts of every chunk, reused if the chunk is unchanged */
+    guint                 n_chunks;
+    StatsChunkCounts     *chunk_histograms;
+
+    /* Greatest block entropy of every 2^l blocks, level l = 0 are the blocks */
+    gfloat              **max_entropies;
+    guint                 n_levels;
+
+    /* ChirurgienStatsRegion */
+    GArray               *regions;
+
+};
+
+typedef struct
+{
+    ChirurgienStats          *stats;
+    const ChirurgienStats    *previous;
+    const ChirurgienDocument *document;
+    GCancellable             *cancellable;
+
+    /* Byte counts of every region, added up by the jobs */
+    StatsCounts              *region_histograms;
+    GMutex                    regions_lock;
+
+    /* Jobs still running */
+    gint                      pending;
+    GMutex                    pending_lock;
+    GCond                     pending_cond;
+
+} StatsComputation;
+
+typedef struct
+{
+    StatsComputation         *computation;
+
+    /* A chunk of the document, or a piece of a region if region is not G_MAXUINT */
+    guint                     chunk;
+    guint                     region;
+    gsize                     offset;
+    gsize                     size;
+
+} StatsJob;
+
+/* c * log2 (c) of the counts of a block */
+static gfloat stats_count_log[CHIRURGIEN_STATS_BLOCK_SIZE + 1];
+
+static GThreadPool *stats_pool = NULL;
+
+
+/*
+ * Adds the byte counts of data to counts
+ * Bytes are counted in 4 interleaved tables, runs of the same byte do not serialize
+ * on a single counter, and the tables are added up in a loop the compiler vectorizes
+ */
+static void
+stats_count (const guchar *data,
+             gsize         size,
+             guint32      *counts)
+{
+    guint32 tables[4][256] = { { 0 } };
+    gsize i;
+
+    for (i = 0; i + 4 <= size; i += 4)
+    {
+        tables[0][data[i]]++;
+        tables[1][data[i + 1]]++;
+        tables[2][data[i + 2]]++;
+        tables[3][data[i + 3]]++;
+    }
+
+    for (; i < size; i++)
+        tables[0][data[i]]++;
+
+    for (guint c = 0; c < 256; c++)
+        counts[c] += tables[0][c] + tables[1][c] + tables[2][c] + tables[3][c];
+}
+
+/* Entropy and chi-square of the counts of a block, at most CHIRURGIEN_STATS_BLOCK_SIZE bytes */
+static void
+stats_block (const guint32 *counts,
+             gsize          size,
+             gfloat        *entropy,
+             gfloat        *chi_square)
+{
+    gfloat count_log = 0;
+    guint64 squares = 0;
+
+    for (guint c = 0; c < 256; c++)
+    {
+        count_log += stats_count_log[counts[c]];
+        squares += (guint64) counts[c] * counts[c];
+    }
+
+    /* H = log2 (n) - sum (c * log2 (c)) / n, and with e = n / 256 expected counts,
+     * sum ((c - e)^2 / e) = sum (c^2) / e - n */
+    *entropy = log2f (size) - count_log / size;
+    *chi_square = (gdouble) squares * 256 / size - size;
+}
+
+static void
+stats_totals (const guint64 *histogram,
+              gsize          size,
+              gdouble       *entropy,
+              gdouble       *chi_square)
+{
+    gdouble probability, expected;
+
+    *entropy = *chi_square = 0;
+
+    if (!size)
+        return;
+
+    expected = size / 256.0;
+
+    for (guint c = 0; c < 256; c++)
+    {
+        if (histogram[c])
+        {
+            probability = (gdouble) histogram[c] / size;
+            *entropy -= probability * log2 (probability);
+        }
+
+        *chi_square += (histogram[c] - expected) * (histogram[c] - expected) / expected;
+    }
+}
+
+/* Computes the blocks of a chunk, straight from the document pieces */
+static void
+stats_compute_chunk (StatsComputation *computation,
+                     guint             chunk)
+{
+    ChirurgienStats *stats;
+    ChirurgienDocumentCursor cursor;
+
+    guint32 counts[256];
+    gsize chunk_end, block_start, block_end, position, length;
+    guint block;
+
+    stats = computation->stats;
+
+    block_start = (gsize) chunk * STATS_CHUNK_SIZE;
+    chunk_end = MIN (block_start + STATS_CHUNK_SIZE, stats->file_size);
+
+    memset (stats->chunk_histograms[chunk], 0, sizeof (StatsChunkCounts));
+
+    chirurgien_document_cursor_init (&cursor, computation->document, block_start);
+    position = block_start;
+
+    for (block = chunk * STATS_CHUNK_BLOCKS; block_start < chunk_end; block++)
+    {
+        block_end = MIN (block_start + CHIRURGIEN_STATS_BLOCK_SIZE, chunk_end);
+        memset (counts, 0, sizeof (counts));
+
+        /* A block can span many pieces */
+        while (position < block_end && cursor.chunk)
+        {
+            length = MIN (cursor.offset + cursor.chunk_length, block_end) - position;
+            stats_count (cursor.chunk + (position - cursor.offset), length, counts);
+            position += length;
+
+            if (position == cursor.offset + cursor.chunk_length)
+                chirurgien_document_cursor_next (&cursor);
+        }
+
+        stats_block (counts, block_end - block_start,
+                     &stats->block_entropies[block],
+                     &stats->block_chi_squares[block]);
+
+        for (guint c = 0; c < 256; c++)
+            stats->chunk_histograms[chunk][c] += counts[c];
+
+        block_start = block_end;
+    }
+}
+
+/* Counts the bytes of a piece of a region */
+static void
+stats_compute_region (StatsComputation *computation,
+                      guint             region,
+                      gsize             offset,
+                      gsize             size)
+{
+    ChirurgienDocumentCursor cursor;
+    guint32 counts[256] = { 0 };
+    gsize length;
+
+    for (chirurgien_document_cursor_init (&cursor, computation->document, offset);
+         cursor.chunk && size;
+         chirurgien_document_cursor_next (&cursor))
+    {
+        length = MIN (cursor.chunk_length, size);
+        stats_count (cursor.chunk, length, counts);
+        size -= length;
+    }
+
+    g_mutex_lock (&computation->regions_lock);
+    for (guint c = 0; c < 256; c++)
+        computation->region_histograms[region][c] += counts[c];
+    g_mutex_unlock (&computation->regions_lock);
+}
+
+static void
+stats_run_job (gpointer data,
+               G_GNUC_UNUSED gpointer user_data)
+{
+    StatsJob *job;
+    StatsComputation *computation;
+
+    job = data;
+    computation = job->computation;
+
+    if (!g_cancellable_is_cancelled (computation->cancellable))
+    {
+        if (job->region == G_MAXUINT)
+            stats_compute_chunk (computation, job->chunk);
+        else
+            stats_compute_region (computation, job->region, job->offset, job->size);
+    }
+
+    g_slice_free (StatsJob, job);
+
+    g_mutex_lock (&computation->pending_lock);
+    if (!--computation->pending)
+        g_cond_signal (&computation->pending_cond);
+    g_mutex_unlock (&computation->pending_lock);
+}
+
+static void
+stats_push_job (StatsComputation *computation,
+                guint             chunk,
+                guint             region,
+                gsize             offset,
+                gsize             size)
+{
+    StatsJob *job;
+
+    job = g_slice_new (StatsJob);
+    job->computation = computation;
+    job->chunk = chunk;
+    job->region = region;
+    job->offset = offset;
+    job->size = size;
+
+    g_mutex_lock (&computation->pending_lock);
+    computation->pending++;
+    g_mutex_unlock (&computation->pending_lock);
+
+    g_thread_pool_push (stats_pool, job, NULL);
+}
+
+static void
+stats_initialize (void)
+{
+    static gsize initialized = 0;
+
+    if (g_once_init_enter (&initialized))
+    {
+        stats_count_log[0] = 0;
+
+        for (guint c = 1; c <= CHIRURGIEN_STATS_BLOCK_SIZE; c++)
+            stats_count_log[c] = c * log2 (c);
+
+        stats_pool = g_thread_pool_new (stats_run_job, NULL, g_get_num_processors (), FALSE, NULL);
+
+        g_once_init_leave (&initialized, 1);
+    }
+}
+
+/* If a chunk of the previous statistics can be reused */
+static gboolean
+stats_chunk_unchanged (const ChirurgienStats *stats,
+                       const ChirurgienStats *previous,
+                       guint                  chunk,
+                       gsize                  dirty_start,
+                       gsize                  dirty_end)
+{
+    gsize chunk_start, chunk_end;
+
+    if (!previous || chunk >= previous->n_chunks)
+        return FALSE;
+
+    chunk_start = (gsize) chunk * STATS_CHUNK_SIZE;
+    chunk_end = MIN (chunk_start + STATS_CHUNK_SIZE, stats->file_size);
+
+    /* The chunk must have the same size in both */
+    if (chunk_end != MIN (chunk_start + STATS_CHUNK_SIZE, previous->file_size))
+        return FALSE;
+
+    /* Before the edited range, or after it if the edits kept the file size */
+    return chunk_end <= dirty_start ||
+           (dirty_end != G_MAXSIZE && chunk_start >= dirty_end && stats->file_size == previous->file_size);
+}
+
+static void
+stats_build_levels (ChirurgienStats *stats)
+{
+    gfloat *level, *lower_level;
+    guint n_entries;
+
+    stats->n_levels = g_bit_storage (MAX (stats->n_blocks, 1) - 1) + 1;
+    stats->max_entropies = g_new (gfloat *, stats->n_levels);
+    stats->max_entropies[0] = stats->block_entropies;
+
+    n_entries = stats->n_blocks;
+
+    for (guint l = 1; l < stats->n_levels; l++)
+    {
+        lower_level = stats->max_entropies[l - 1];
+        level = g_new (gfloat, (n_entries + 1) / 2);
+
+        for (guint i = 0; i < n_entries / 2; i++)
+            level[i] = MAX (lower_level[i * 2], lower_level[i * 2 + 1]);
+
+        if (n_entries % 2)
+            level[n_entries / 2] = lower_level[n_entries - 1];
+
+        n_entries = (n_entries + 1) / 2;
+        stats->max_entropies[l] = level;
+    }
+}
+
+/*
+ * Computes the statistics of a document, on a thread pool, one job per chunk of blocks
+ * The blocks of previous (NULL if none) outside [dirty_start, dirty_end) are reused,
+ * dirty_end is G_MAXSIZE if the edits resized the document
+ * The statistics of regions (ChirurgienStatsRegion, NULL if none) are computed too,
+ * the statistics take ownership of the array
+ * Returns NULL if cancelled
+ */
+ChirurgienStats *
+chirurgien_stats_compute (const ChirurgienStats    *previous,
+                          const ChirurgienDocument *document,
+                          gsize                     dirty_start,
+                          gsize                     dirty_end,
+                          GArray                   *regions,
+                          GCancellable             *cancellable)
+{
+    ChirurgienStats *stats;
+    ChirurgienStatsRegion *region;
+    StatsComputation computation;
+    gsize first_block, piece;
+
+    stats_initialize ();
+
+    stats = g_slice_new0 (ChirurgienStats);
+    stats->ref_count = 1;
+
+    stats->file_size = chirurgien_document_get_size (document);
+    stats->n_blocks = (stats->file_size + CHIRURGIEN_STATS_BLOCK_SIZE - 1) / CHIRURGIEN_STATS_BLOCK_SIZE;
+    stats->n_chunks = (stats->file_size + STATS_CHUNK_SIZE - 1) / STATS_CHUNK_SIZE;
+
+    stats->block_entropies = g_new (gfloat, stats->n_blocks);
+    stats->block_chi_squares = g_new (gfloat, stats->n_blocks);
+    stats->chunk_histograms = g_new (StatsChunkCounts, stats->n_chunks);
+
+    stats->regions = regions ? regions : g_array_new (FALSE, FALSE, sizeof (ChirurgienStatsRegion));
+
+    computation.stats = stats;
+    computation.previous = previous;
+    computation.document = document;
+    computation.cancellable = cancellable;
+    computation.region_histograms = g_new0 (StatsCounts, stats->regions->len);
+    computation.pending = 0;
+
+    g_mutex_init (&computation.regions_lock);
+    g_mutex_init (&computation.pending_lock);
+    g_cond_init (&computation.pending_cond);
+
+    for (guint chunk = 0; chunk < stats->n_chunks; chunk++)
+    {
+        if (stats_chunk_unchanged (stats, previous, chunk, dirty_start, dirty_end))
+        {
+            first_block = chunk * STATS_CHUNK_BLOCKS;
+
+            memcpy (stats->chunk_histograms[chunk], previous->chunk_histograms[chunk],
+                    sizeof (StatsChunkCounts));
+            memcpy (stats->block_entropies + first_block, previous->block_entropies + first_block,
+                    MIN (STATS_CHUNK_BLOCKS, stats->n_blocks - first_block) * sizeof (gfloat));
+            memcpy (stats->block_chi_squares + first_block, previous->block_chi_squares + first_block,
+                    MIN (STATS_CHUNK_BLOCKS, stats->n_blocks - first_block) * sizeof (gfloat));
+        }
+        else
+        {
+            stats_push_job (&computation, chunk, G_MAXUINT, 0, 0);
+        }
+    }
+
+    /* Regions are split in chunk sized pieces too */
+    for (guint i = 0; i < stats->regions->len; i++)
+    {
+        region = &g_array_index (stats->regions, ChirurgienStatsRegion, i);
+        region->size = MIN (region->size, stats->file_size - MIN (region->offset, stats->file_size));
+
+        for (gsize offset = 0; offset < region->size; offset += piece)
+        {
+            piece = MIN (STATS_CHUNK_SIZE, region->size - offset);
+            stats_push_job (&computation, 0, i, region->offset + offset, piece);
+        }
+    }
+
+    g_mutex_lock (&computation.pending_lock);
+    while (computation.pending)
+        g_cond_wait (&computation.pending_cond, &computation.pending_lock);
+    g_mutex_unlock (&computation.pending_lock);
+
+    g_mutex_clear (&computation.regions_lock);
+    g_mutex_clear (&computation.pending_lock);
+    g_cond_clear (&computation.pending_cond);
+
+    if (g_cancellable_is_cancelled (cancellable))
+    {
+        g_free (computation.region_histograms);
+        chirurgien_stats_unref (stats);
+
+        return NULL;
+    }
+
+    for (guint chunk = 0; chunk < stats->n_chunks; chunk++)
+    {
+        for (guint c = 0; c < 256; c++)
+            stats->histogram[c] += stats->chunk_histograms[chunk][c];
+    }
+
+    stats_totals (stats->histogram, stats->file_size, &stats->entropy, &stats->chi_square);
+
+    for (guint i = 0; i < stats->regions->len; i++)
+    {
+        region = &g_array_index (stats->regions, ChirurgienStatsRegion, i);
+        stats_totals (computation.region_histograms[i], region->size,
+                      &region->entropy, &region->chi_square);
+    }
+
+    g_free (computation.region_histograms);
+
+    stats_build_levels (stats);
+
+    return stats;
+}
+
+ChirurgienStats *
+chirurgien_stats_ref (ChirurgienStats *stats)
+{
+    g_atomic_int_inc (&stats->ref_count);
+
+    return stats;
+}
+
+void
+chirurgien_stats_unref (gpointer data)
+{
+    ChirurgienStats *stats;
+
+    stats = data;
+
+    if (!stats || !g_atomic_int_dec_and_test (&stats->ref_count))
+        return;
+
+    /* Level 0 are the block entropies */
+    for (guint l = 1; l < stats->n_levels; l++)
+        g_free (stats->max_entropies[l]);
+    g_free (stats->max_entropies);
+
+    g_free (stats->block_entropies);
+    g_free (stats->block_chi_squares);
+    g_free (stats->chunk_histograms);
+    g_array_unref (stats->regions);
+
+    g_slice_free (ChirurgienStats, stats);
+}
+
+gsize
+chirurgien_stats_get_file_size (const ChirurgienStats *stats)
+{
+    return stats->file_size;
+}
+
+/* The 256 byte counts of the whole file */
+const guint64 *
+chirurgien_stats_get_histogram (const ChirurgienStats *stats)
+{
+    return stats->histogram;
+}
+
+/* Entropy and chi-square of the whole file */
+void
+chirurgien_stats_get_totals (const ChirurgienStats *stats,
+                             gdouble               *entropy,
+                             gdouble               *chi_square)
+{
+    *entropy = stats->entropy;
+    *chi_square = stats->chi_square;
+}
+
+guint
+chirurgien_stats_get_n_blocks (const ChirurgienStats *stats)
+{
+    return stats->n_blocks;
+}
+
+void
+chirurgien_stats_get_block (const ChirurgienStats *stats,
+                            guint                  block,
+                            gdouble               *entropy,
+                            gdouble               *chi_square)
+{
+    *entropy = stats->block_entropies[block];
+    *chi_square = stats->block_chi_squares[block];
+}
+
+/*
+ * Fills entropies with the greatest block entropy of n_rows equal parts of the file
+ * Every row is read from the highest level with entries no larger than the row,
+ * it takes at most 3 entries
+ */
+void
+chirurgien_stats_get_entropies (const ChirurgienStats *stats,
+                                gfloat                *entropies,
+                                guint                  n_rows)
+{
+    const gfloat *level;
+    gsize row_blocks, first_block, last_block;
+    guint l;
+
+    if (!n_rows)
+        return;
+
+    if (!stats->n_blocks)
+    {
+        memset (entropies, 0, n_rows * sizeof (gfloat));
+        return;
+    }
+
+    row_blocks = MAX (stats->n_blocks / n_rows, 1);
+
+    for (l = 0; l + 1 < stats->n_levels; l++)
+    {
+        if (((gsize) 1 << (l + 1)) > row_blocks)
+            break;
+    }
+
+    level = stats->max_entropies[l];
+
+    for (guint row = 0; row < n_rows; row++)
+    {
+        first_block = (guint64) stats->n_blocks * row / n_rows;
+        last_block = MAX ((guint64) stats->n_blocks * (row + 1) / n_rows, first_block + 1) - 1;
+
+        entropies[row] = 0;
+
+        for (gsize i = first_block >> l; i <= last_block >> l; i++)
+            entropies[row] = MAX (entropies[row], level[i]);
+    }
+}
+
+/* The statistics of the regions, ChirurgienStatsRegion */
+const GArray *
+chirurgien_stats_get_regions (const ChirurgienStats *stats)
+{
+    return stats->regions;
+}
@@ -0,0 +1,78 @@
+/* chirurgien-stats.h
+ *
+ * Copyright (C) 2021 - Daniel Léonard Schardijn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <gio/gio.h>
+
+#include "chirurgien-document.h"
+
+G_BEGIN_DECLS
+
+/* Bytes per block, the unit of the per-block statistics */
+#define CHIRURGIEN_STATS_BLOCK_SIZE 4096
+
+/*
+ * Byte statistics of a document: the byte histogram, and the Shannon entropy
+ * and chi-square of the whole document, of every block and of a set of regions
+ * Statistics are immutable and reference counted, a new computation reuses
+ * the blocks of the previous one outside the edited range
+ */
+typedef struct _ChirurgienStats ChirurgienStats;
+
+/* Statistics of a byte range */
+typedef struct
+{
+    gsize                 offset;
+    gsize                 size;
+
+    /* Shannon entropy, in bits per byte */
+    gdouble               entropy;
+    /* Chi-square of the byte counts against a uniform distribution, 255 degrees of freedom */
+    gdouble               chi_square;
+
+} ChirurgienStatsRegion;
+
+ChirurgienStats *   chirurgien_stats_compute            (const ChirurgienStats *,
+                                                         const ChirurgienDocument *,
+                                                         gsize,
+                                                         gsize,
+                                                         GArray *,
+                                                         GCancellable *);
+
+ChirurgienStats *   chirurgien_stats_ref                (ChirurgienStats *);
+void                chirurgien_stats_unref              (gpointer);
+
+gsize               chirurgien_stats_get_file_size      (const ChirurgienStats *);
+const guint64 *     chirurgien_stats_get_histogram      (const ChirurgienStats *);
+void                chirurgien_stats_get_totals         (const ChirurgienStats *,
+                                                         gdouble *,
+                                                         gdouble *);
+
+guint               chirurgien_stats_get_n_blocks       (const ChirurgienStats *);
+void                chirurgien_stats_get_block          (const ChirurgienStats *,
+                                                         guint,
+                                                         gdouble *,
+                                                         gdouble *);
+void                chirurgien_stats_get_entropies      (const ChirurgienStats *,
+                                                         gfloat *,
+                                                         guint);
+
+const GArray *      chirurgien_stats_get_regions        (const ChirurgienStats *);
+
+G_END_DECLS
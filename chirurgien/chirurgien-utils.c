@@ -18,7 +18,7 @@
 
 #include "chirurgien-utils.h"
 
-#include "chirurgien-globals.h"
+#include "chirurgien-print.h"
 
 
 void
@@ -29,26 +29,13 @@ chirurgien_utils_hex_print (gchar        *destination,
                             gsize         raw_source_size,
                             gsize         line_break)
 {
-    gsize raw_index, formatted_index;
-
-    for (raw_index = start_offset, formatted_index = 0;
-         formatted_index < destination_size && raw_index < raw_source_size;
-         raw_index++)
-    {
-        destination[formatted_index++] = hex_chars[ raw_source[raw_index] >> 4 ];
-        destination[formatted_index++] = hex_chars[ raw_source[raw_index] & 0x0F ];
-        destination[formatted_index++] = ' ';
-    }
-
-    if (formatted_index < destination_size)
-        destination[formatted_index] = '\0';
-
-    for (formatted_index = line_break - 1;
-         formatted_index < destination_size;
-         formatted_index += line_break)
-    {
-        destination[formatted_index] = '\n';
-    }
+    chirurgien_print_formatted (chirurgien_print_kernels_get ()->hex,
+                                destination,
+                                raw_source,
+                                start_offset,
+                                destination_size,
+                                raw_source_size,
+                                line_break);
 }
 
 void
@@ -59,27 +46,11 @@ chirurgien_utils_text_print (gchar        *destination,
                              gsize         raw_source_size,
                              gsize         line_break)
 {
-    gsize raw_index, formatted_index;
-
-    for (raw_index = start_offset, formatted_index = 0;
-         formatted_index < destination_size && raw_index < raw_source_size;
-         raw_index++)
-    {
-        if (g_ascii_isgraph (raw_source[raw_index]))
-            destination[formatted_index++] = raw_source[raw_index];
-        else
-            destination[formatted_index++] = '.';
-        destination[formatted_index++] = ' ';
-        destination[formatted_index++] = ' ';
-    }
-
-    if (formatted_index < destination_size)
-        destination[formatted_index] = '\0';
-
-    for (formatted_index = line_break - 1;
-         formatted_index < destination_size;
-         formatted_index += line_break)
-    {
-        destination[formatted_index] = '\n';
-    }
+    chirurgien_print_formatted (chirurgien_print_kernels_get ()->text,
+                                destination,
+                                raw_source,
+                                start_offset,
+                                destination_size,
+                                raw_source_size,
+                                line_break);
 }
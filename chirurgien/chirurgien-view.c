@@ -21,6 +21,7 @@
 #include "chirurgien-view.h"
 
 #include <glib/gi18n.h>
+#include <math.h>
 
 #include <chirurgien-formats.h>
 
@@ -29,6 +30,20 @@
 #include "chirurgien-view-tab.h"
 #include "chirurgien-editor.h"
 #include "chirurgien-actions.h"
+#include "chirurgien-field-index.h"
+#include "chirurgien-minimap.h"
+#include "chirurgien-stats.h"
+#include "chirurgien-document.h"
+
+/* Width of the entropy strip along the right edge of the minimap, in pixels */
+#define MINIMAP_ENTROPY_WIDTH 4
+
+/* The 'Statistics' page lists up to this many regions of each kind */
+#define STATS_MAX_LISTED_REGIONS 64
+/* Compressed or encrypted data is at or above this entropy, in bits per byte */
+#define STATS_HIGH_ENTROPY 7.5
+/* Chi-square of uniformly distributed bytes at the 1% significance level, 255 degrees of freedom */
+#define STATS_RANDOM_CHI_SQUARE 310.5
 
 
 typedef enum
@@ -56,6 +71,79 @@ typedef struct
 
 } FileModification;
 
+typedef struct
+{
+    /* Snapshot of the document being analyzed, the processor reads its chunks in place */
+    ChirurgienDocument   *document;
+
+    /* The analysis starts at this offset of the contents */
+    gsize                 origin;
+
+    /* The processor's input and output */
+    ProcessorFile        *file;
+
+    /* The index over the output fields */
+    ChirurgienFieldIndex *field_index;
+    /* The overview of the output fields */
+    ChirurgienMinimap    *minimap;
+
+} AnalysisData;
+
+typedef struct
+{
+    /* Snapshot of the document being carved */
+    ChirurgienDocument   *document;
+    /* The snapshot's chunks */
+    ProcessorFile        *contents;
+
+    /* The formats found, EmbeddedFormats */
+    GArray               *embedded_formats;
+
+} CarvingData;
+
+typedef struct
+{
+    /* Snapshot of the document being measured */
+    ChirurgienDocument   *document;
+
+    /* The statistics being updated, NULL if none */
+    ChirurgienStats      *previous;
+    /* Range edited since the previous statistics */
+    gsize                 dirty_start;
+    gsize                 dirty_end;
+
+    /* The regions to measure, ChirurgienStatsRegions */
+    GArray               *regions;
+
+    /* The computed statistics */
+    ChirurgienStats      *stats;
+
+    /* Edit generation of the snapshot */
+    guint                 generation;
+    /* Show the 'Statistics' page once computed */
+    gboolean              select;
+
+} StatsData;
+
+typedef struct
+{
+    /* File offset of the row, G_MAXSIZE if never drawn */
+    gsize                 offset;
+
+    /* The bytes the row was drawn from */
+    guchar               *contents;
+    gsize                 contents_size;
+
+    /* The shaped row, for drawing and hit testing */
+    PangoLayout          *layout;
+    /* The drawn row */
+    cairo_surface_t      *surface;
+
+    /* Rows of an older generation are redrawn */
+    guint                 generation;
+
+} ViewRow;
+
 
 struct _ChirurgienView
 {
@@ -81,8 +169,10 @@ struct _ChirurgienView
 
     /* The file view */
     GtkWidget            *file_view;
-    PangoLayout          *view_layout;
+    /* The text of the row being drawn */
     gchar                *view_buffer;
+    /* The visible file bytes, read from the document */
+    guchar               *window_contents;
 
     /* Active view type */
     ChirurgienViewType    active_view;
@@ -97,8 +187,50 @@ struct _ChirurgienView
     /* Adjustment for the view scrollbar */
     GtkAdjustment        *adjustment;
 
-    /* The file fields, a list of FileField structs */
-    GSList               *file_fields;
+    /* The strip beside the scrollbar, showing the fields of the whole file */
+    GtkWidget            *minimap_view;
+    ChirurgienMinimap    *minimap;
+
+    /* The file fields, indexed by the byte ranges they cover */
+    ChirurgienFieldIndex *field_index;
+
+    /* The description of the last analysis, its pages are materialized when shown */
+    FileDescription      *file_description;
+    /* Checkpoints of the last analysis, to resume it after an edit */
+    ProcessorCheckpoints *analysis_checkpoints;
+    /* Range edited since the last analysis, G_MAXSIZE if none
+     * Insertions and deletions resize the file */
+    gsize                 edited_start;
+    gsize                 edited_end;
+    gboolean              edited_resize;
+
+    /* Cancels the in-flight analysis */
+    GCancellable         *analysis_cancellable;
+    /* The in-flight analysis, used to report progress */
+    ProcessorFile        *analysis_file;
+    /* Progress report timeout */
+    guint                 analysis_progress_source;
+
+    /* Offset the analysis starts at, to analyze an embedded format in place */
+    gsize                 analysis_origin;
+
+    /* Cancels the in-flight carving */
+    GCancellable         *carving_cancellable;
+    /* The 'Embedded formats' page in the description panel, NULL if none */
+    GtkWidget            *carving_page;
+
+    /* Byte statistics, NULL until requested */
+    ChirurgienStats      *stats;
+    /* Cancels the in-flight statistics */
+    GCancellable         *stats_cancellable;
+    /* The 'Statistics' page in the description panel, NULL if none */
+    GtkWidget            *stats_page;
+    /* Incremented by every edit */
+    guint                 stats_generation;
+    /* Range edited since the statistics were computed, G_MAXSIZE if none
+     * The end is G_MAXSIZE if the file was resized */
+    gsize                 stats_dirty_start;
+    gsize                 stats_dirty_end;
 
     /* The modifications stack */
     GQueue                modifications;
@@ -113,7 +245,7 @@ struct _ChirurgienView
 
     /* The index of the byte pointed to by the mouse */
     gsize                 current_mouse_index;
-    /* List of fields at the byte pointed to by the mouse */
+    /* List of fields (their index) at the byte pointed to by the mouse */
     GSList               *fields_at_mouse_index;
     /* Number of fields at the mouse index */
     gint                  n_fields_at_mouse_index;
@@ -121,22 +253,36 @@ struct _ChirurgienView
     /* File offset of the scroll, in bytes */
     gsize                 scroll_offset;
 
+    /* The drawn rows, a row's slot is its line number modulo n_rows */
+    ViewRow              *rows;
+    guint                 n_rows;
+    /* The geometry the rows were drawn with */
+    gint                  rows_line_length;
+    gint                  rows_width;
+    gint                  rows_scale;
+    /* The appearance the rows were drawn with */
+    ChirurgienViewType    rows_view;
+    guint                 rows_colors_generation;
+    GdkRGBA               rows_color;
+    guint                 rows_generation;
+
     /* The popover selected field */
-    FileField            *selected_field;
+    FileField             selected_field;
 
     /* The view's tab on the main window notebook */
     ChirurgienViewTab    *view_tab;
 
     /* The file being viewed */
     gchar                *file_path;
-    GByteArray           *file_contents;
+    /* The file contents, a piece table over the mapped file */
+    ChirurgienDocument   *document;
 
     /* The navigation icon above the navigation buttons */
     GtkWidget            *navigation_icon;
     /* The navigation buttons */
     GtkBox               *navigation;
-    /* Selected navigation target */
-    const FileField      *navigation_target;
+    /* Selected navigation target, G_MAXUINT if none */
+    guint                 navigation_target;
 
     /* View state */
     gboolean              has_file;
@@ -154,6 +300,12 @@ struct _ChirurgienView
 
 G_DEFINE_TYPE (ChirurgienView, chirurgien_view, GTK_TYPE_WIDGET)
 
+static gsize
+get_file_size (ChirurgienView *view)
+{
+    return chirurgien_document_get_size (view->document);
+}
+
 static void
 switch_view (GtkToggleButton *togglebutton,
              gpointer         user_data)
@@ -177,8 +329,8 @@ resize_view (G_GNUC_UNUSED GtkDrawingArea *area,
              gpointer user_data)
 {
     ChirurgienView *view;
-    gint line_length, visible_lines, total_lines;
-    gsize buffer_size, print_file_size;
+    gint line_length, visible_lines;
+    gsize buffer_size, print_file_size, total_lines;
 
     view = user_data;
 
@@ -188,6 +340,7 @@ resize_view (G_GNUC_UNUSED GtkDrawingArea *area,
 
         if (view->view_buffer)
             g_free (g_steal_pointer (&view->view_buffer));
+        g_clear_pointer (&view->window_contents, g_free);
 
         return;
     }
@@ -230,7 +383,7 @@ resize_view (G_GNUC_UNUSED GtkDrawingArea *area,
     {
         view->buffer_size = buffer_size;
 
-        print_file_size = view->file_contents->len * 3;
+        print_file_size = get_file_size (view) * 3;
         total_lines = print_file_size / line_length;
 
         if (print_file_size % line_length)
@@ -244,11 +397,12 @@ resize_view (G_GNUC_UNUSED GtkDrawingArea *area,
                                   visible_lines - 1,
                                   visible_lines);
 
-        if (view->view_buffer)
-            g_free (view->view_buffer);
-
-        view->view_buffer = g_malloc (view->buffer_size);
+        g_free (view->window_contents);
+        view->window_contents = g_malloc (view->buffer_size / 3 + 1);
     }
+
+    /* The line length can change with the buffer size */
+    view->view_buffer = g_realloc (view->view_buffer, line_length);
 }
 
 static void
@@ -263,170 +417,443 @@ scroll_view (G_GNUC_UNUSED GtkAdjustment *adjustment,
     view->scroll_offset *= (view->line_length / 3);
 
     gtk_widget_queue_draw (view->file_view);
+    gtk_widget_queue_draw (view->minimap_view);
 }
 
-static void
-highlight_fields (ChirurgienView *view,
-                  PangoLayout    *layout)
+/*
+ * Adds the attributes of a field to the attributes of a row
+ * Returns the attribute to embolden if the field is the navigation target
+ */
+static PangoAttribute *
+highlight_field (PangoAttrList   *attribute_list,
+                 const FileField *file_field,
+                 gsize            row_offset,
+                 gsize            row_end)
 {
-    PangoAttrList *attribute_list;
-    PangoAttribute *attribute, *alpha_attribute, *navigation_attribute,
-                   *additional_attribute = NULL, *additional_alpha_attribute;
+    PangoAttribute *attribute, *alpha_attribute,
+                   *additional_attribute, *additional_alpha_attribute;
 
-    const FileField *file_field;
+    gsize field_end;
 
-    gsize real_field_start;
-    gsize field_end, scroll_end;
+    field_end = file_field->field_offset + file_field->field_size;
 
-    pango_layout_set_attributes (layout, NULL);
+    if (file_field->background)
+    {
+        attribute = pango_attr_background_new (pango_colors[ file_field->color_index ].red,
+                                               pango_colors[ file_field->color_index ].green,
+                                               pango_colors[ file_field->color_index ].blue);
+        alpha_attribute = pango_attr_background_alpha_new (pango_alphas [ file_field->color_index ]);
+    }
+    else
+    {
+        attribute = pango_attr_foreground_new (pango_colors[ file_field->color_index ].red,
+                                               pango_colors[ file_field->color_index ].green,
+                                               pango_colors[ file_field->color_index ].blue);
+        alpha_attribute = pango_attr_foreground_alpha_new (pango_alphas [ file_field->color_index ]);
+    }
 
-    if (!view->file_fields)
-        return;
+    if (file_field->field_offset < row_offset)
+        attribute->start_index = PANGO_ATTR_INDEX_FROM_TEXT_BEGINNING;
+    else
+        attribute->start_index = (file_field->field_offset - row_offset) * 3;
 
-    /* Last byte of the buffer/frame */
-    scroll_end = view->scroll_offset + view->buffer_size / 3;
+    /* The field continues in the next row */
+    if (field_end > row_end)
+        attribute->end_index = (row_end - row_offset) * 3;
+    else
+        attribute->end_index = ((field_end - row_offset) * 3) - 1;
 
-    attribute_list = pango_attr_list_new ();
+    alpha_attribute->start_index = attribute->start_index;
+    alpha_attribute->end_index = attribute->end_index;
 
-    for (GSList *i = view->file_fields; i; i = i->next)
+    /* Additional color */
+    if (file_field->additional_color_index < CHIRURGIEN_TOTAL_COLORS &&
+        file_field->field_offset >= row_offset)
     {
-        file_field = i->data;
-
-        if (file_field->field_offset > scroll_end)
-            break;
-
-        field_end = file_field->field_offset + file_field->field_size;
-        if (field_end <= view->scroll_offset)
-            continue;
-
         if (file_field->background)
         {
-            attribute = pango_attr_background_new (pango_colors[ file_field->color_index ].red,
-                                                   pango_colors[ file_field->color_index ].green,
-                                                   pango_colors[ file_field->color_index ].blue);
-            alpha_attribute = pango_attr_background_alpha_new (pango_alphas [ file_field->color_index ]);
+            additional_attribute = pango_attr_background_new (pango_colors[ file_field->additional_color_index ].red,
+                                                              pango_colors[ file_field->additional_color_index ].green,
+                                                              pango_colors[ file_field->additional_color_index ].blue);
+            additional_alpha_attribute = pango_attr_background_alpha_new (pango_alphas [ file_field->additional_color_index ]);
         }
         else
         {
-            attribute = pango_attr_foreground_new (pango_colors[ file_field->color_index ].red,
-                                                   pango_colors[ file_field->color_index ].green,
-                                                   pango_colors[ file_field->color_index ].blue);
-            alpha_attribute = pango_attr_foreground_alpha_new (pango_alphas [ file_field->color_index ]);
+            additional_attribute = pango_attr_foreground_new (pango_colors[ file_field->additional_color_index ].red,
+                                                              pango_colors[ file_field->additional_color_index ].green,
+                                                              pango_colors[ file_field->additional_color_index ].blue);
+            additional_alpha_attribute = pango_attr_foreground_alpha_new (pango_alphas [ file_field->additional_color_index ]);
         }
 
-        real_field_start = (file_field->field_offset - view->scroll_offset) * 3;
+        additional_attribute->start_index = additional_attribute->end_index = attribute->start_index;
+        additional_attribute->end_index += 2;
+        attribute->start_index += 2;
+        alpha_attribute->start_index = attribute->start_index;
 
-        if (file_field->field_offset < view->scroll_offset)
-            attribute->start_index = PANGO_ATTR_INDEX_FROM_TEXT_BEGINNING;
-        else
-            attribute->start_index = real_field_start;
+        additional_alpha_attribute->start_index = additional_attribute->start_index;
+        additional_alpha_attribute->end_index = additional_attribute->end_index;
 
-        attribute->end_index = ((field_end - view->scroll_offset) * 3) - 1;
+        pango_attr_list_insert (attribute_list, additional_attribute);
+        pango_attr_list_insert (attribute_list, additional_alpha_attribute);
+        pango_attr_list_insert (attribute_list, attribute);
+        pango_attr_list_insert (attribute_list, alpha_attribute);
 
-        /* Additional color */
-        if (file_field->additional_color_index < CHIRURGIEN_TOTAL_COLORS &&
-            attribute->start_index == real_field_start)
-        {
-            if (file_field->background)
-            {
-                additional_attribute = pango_attr_background_new (pango_colors[ file_field->additional_color_index ].red,
-                                                                  pango_colors[ file_field->additional_color_index ].green,
-                                                                  pango_colors[ file_field->additional_color_index ].blue);
-                additional_alpha_attribute = pango_attr_background_alpha_new (pango_alphas [ file_field->additional_color_index ]);
-            }
-            else
-            {
-                additional_attribute = pango_attr_foreground_new (pango_colors[ file_field->additional_color_index ].red,
-                                                                  pango_colors[ file_field->additional_color_index ].green,
-                                                                  pango_colors[ file_field->additional_color_index ].blue);
-                additional_alpha_attribute = pango_attr_foreground_alpha_new (pango_alphas [ file_field->additional_color_index ]);
-            }
+        return additional_attribute;
+    }
 
-            additional_attribute->start_index = additional_attribute->end_index = attribute->start_index;
-            additional_attribute->end_index += 2;
-            attribute->start_index += 2;
+    pango_attr_list_insert (attribute_list, attribute);
+    pango_attr_list_insert (attribute_list, alpha_attribute);
 
-            additional_alpha_attribute->start_index = additional_attribute->start_index;
-            additional_alpha_attribute->end_index = additional_attribute->end_index;
+    return attribute;
+}
 
-            pango_attr_list_insert (attribute_list, additional_attribute);
-            pango_attr_list_insert (attribute_list, additional_alpha_attribute);
-        }
+/* Builds the attributes of the fields in [row_offset, row_end), NULL if none */
+static PangoAttrList *
+highlight_row (ChirurgienView *view,
+               gsize           row_offset,
+               gsize           row_end)
+{
+    PangoAttrList *attribute_list;
+    PangoAttribute *attribute, *navigation_attribute;
 
-        alpha_attribute->start_index = attribute->start_index;
-        alpha_attribute->end_index = attribute->end_index;
+    FileField file_field;
+    guint field;
 
-        pango_attr_list_insert (attribute_list, attribute);
-        pango_attr_list_insert (attribute_list, alpha_attribute);
+    if (!view->field_index)
+        return NULL;
+
+    field = chirurgien_field_index_next_overlapping (view->field_index, row_offset, row_end, 0);
+
+    if (field == G_MAXUINT)
+        return NULL;
+
+    attribute_list = pango_attr_list_new ();
+
+    for (guint i = field;
+         i != G_MAXUINT;
+         i = chirurgien_field_index_next_overlapping (view->field_index, row_offset, row_end, i + 1))
+    {
+        chirurgien_field_index_get_field (view->field_index, i, &file_field);
+
+        attribute = highlight_field (attribute_list, &file_field, row_offset, row_end);
 
         /* Nagivation target */
-        if (view->navigation_target == file_field)
+        if (view->navigation_target == i)
         {
             navigation_attribute = pango_attr_weight_new (PANGO_WEIGHT_ULTRABOLD);
-            if (additional_attribute)
-            {
-                navigation_attribute->start_index = additional_attribute->start_index;
-                navigation_attribute->end_index = additional_attribute->end_index;
-            }
-            else
-            {
-                navigation_attribute->start_index = attribute->start_index;
-                navigation_attribute->end_index = attribute->end_index;
-            }
+            navigation_attribute->start_index = attribute->start_index;
+            navigation_attribute->end_index = attribute->end_index;
             pango_attr_list_insert (attribute_list, navigation_attribute);
         }
+    }
+
+    return attribute_list;
+}
+
+static void
+clear_rows (ChirurgienView *view)
+{
+    ViewRow *row;
 
-        additional_attribute = NULL;
+    for (guint i = 0; i < view->n_rows; i++)
+    {
+        row = &view->rows[i];
+
+        g_clear_object (&row->layout);
+        g_clear_pointer (&row->surface, cairo_surface_destroy);
+        g_free (row->contents);
     }
 
-    pango_layout_set_attributes (layout, attribute_list);
+    g_clear_pointer (&view->rows, g_free);
+    view->n_rows = 0;
+}
 
-    pango_attr_list_unref (attribute_list);
+/* Shapes and draws a row, the row is kept until its bytes or highlighting change */
+static void
+render_row (ChirurgienView *view,
+            ViewRow        *row,
+            gsize           row_offset,
+            const guchar   *contents,
+            gsize           contents_size,
+            const GdkRGBA  *color)
+{
+    PangoAttrList *attribute_list;
+    cairo_t *cr;
+
+    if (view->active_view == CHIRURGIEN_HEX_VIEW)
+        chirurgien_utils_hex_print (view->view_buffer,
+                                    contents,
+                                    0,
+                                    view->line_length,
+                                    contents_size,
+                                    0);
+    else
+        chirurgien_utils_text_print (view->view_buffer,
+                                     contents,
+                                     0,
+                                     view->line_length,
+                                     contents_size,
+                                     0);
+
+    if (!row->layout)
+        row->layout = gtk_widget_create_pango_layout (view->file_view, NULL);
+
+    attribute_list = highlight_row (view, row_offset, row_offset + view->line_length / 3);
+
+    pango_layout_set_attributes (row->layout, attribute_list);
+    /* The last cell separator is not drawn */
+    pango_layout_set_text (row->layout, view->view_buffer,
+                           MIN (contents_size * 3, (gsize) view->line_length - 1));
+
+    if (attribute_list)
+        pango_attr_list_unref (attribute_list);
 
-    view->navigation_target = NULL;
+    if (!row->surface)
+    {
+        row->surface = cairo_image_surface_create (CAIRO_FORMAT_ARGB32,
+                                                   view->rows_width * view->rows_scale,
+                                                   PANGO_PIXELS_CEIL (view->line_height) * view->rows_scale);
+        cairo_surface_set_device_scale (row->surface, view->rows_scale, view->rows_scale);
+    }
+
+    cr = cairo_create (row->surface);
+
+    cairo_set_operator (cr, CAIRO_OPERATOR_CLEAR);
+    cairo_paint (cr);
+    cairo_set_operator (cr, CAIRO_OPERATOR_OVER);
+
+    gdk_cairo_set_source_rgba (cr, color);
+    pango_cairo_show_layout (cr, row->layout);
+
+    cairo_destroy (cr);
+
+    memcpy (row->contents, contents, contents_size);
+    row->contents_size = contents_size;
+    row->offset = row_offset;
+    row->generation = view->rows_generation;
 }
 
+/*
+ * Draws the visible rows, rows are cached by file offset: scrolling reuses the
+ * rows still visible, only the rows that came into view are shaped and drawn
+ */
 static void
 draw_view (GtkDrawingArea *drawing_area,
            cairo_t        *cr,
-           G_GNUC_UNUSED gint width,
+           gint            width,
            G_GNUC_UNUSED gint height,
            gpointer        user_data)
 {
     ChirurgienView *view;
+    ViewRow *row;
     GdkRGBA color;
     GtkStyleContext *context;
 
+    gsize window_size, bytes_per_line, row_start, row_size;
+    guint n_rows;
+    gint scale;
+
     view = user_data;
 
+    if (!view->buffer_size)
+        return;
+
+    bytes_per_line = view->line_length / 3;
+    n_rows = view->buffer_size / view->line_length;
+    scale = gtk_widget_get_scale_factor (GTK_WIDGET (drawing_area));
+
+    /* Every byte takes 3 characters in both views */
+    window_size = chirurgien_document_read (view->document,
+                                            view->scroll_offset,
+                                            view->buffer_size / 3,
+                                            view->window_contents);
+
     context = gtk_widget_get_style_context (GTK_WIDGET (drawing_area));
+    gtk_style_context_get_color (context, &color);
+
+    /* The row geometry changed */
+    if (view->n_rows != n_rows ||
+        view->rows_line_length != view->line_length ||
+        view->rows_width != width ||
+        view->rows_scale != scale)
+    {
+        clear_rows (view);
+
+        view->rows = g_new0 (ViewRow, n_rows);
+        view->n_rows = n_rows;
+        view->rows_line_length = view->line_length;
+        view->rows_width = width;
+        view->rows_scale = scale;
+
+        for (guint i = 0; i < n_rows; i++)
+        {
+            view->rows[i].offset = G_MAXSIZE;
+            view->rows[i].contents = g_malloc (bytes_per_line);
+        }
+    }
+
+    /* The row appearance changed */
+    if (view->rows_view != view->active_view ||
+        view->rows_colors_generation != pango_colors_generation ||
+        !gdk_rgba_equal (&view->rows_color, &color) ||
+        view->navigation_target != G_MAXUINT)
+    {
+        view->rows_generation++;
+
+        view->rows_view = view->active_view;
+        view->rows_colors_generation = pango_colors_generation;
+        view->rows_color = color;
+    }
+
+    for (guint i = 0; i < n_rows; i++)
+    {
+        row_start = i * bytes_per_line;
+
+        if (row_start >= window_size)
+            break;
+
+        row_size = MIN (bytes_per_line, window_size - row_start);
+
+        /* Consecutive rows never share a slot */
+        row = &view->rows[((view->scroll_offset + row_start) / bytes_per_line) % n_rows];
+
+        if (row->offset != view->scroll_offset + row_start ||
+            row->generation != view->rows_generation ||
+            row->contents_size != row_size ||
+            memcmp (row->contents, view->window_contents + row_start, row_size))
+        {
+            render_row (view, row,
+                        view->scroll_offset + row_start,
+                        view->window_contents + row_start,
+                        row_size,
+                        &color);
+        }
+
+        cairo_set_source_surface (cr, row->surface, 0, (gdouble) i * view->line_height / PANGO_SCALE);
+        cairo_paint (cr);
+    }
+
+    /* The navigation target is emboldened once */
+    if (view->navigation_target != G_MAXUINT)
+    {
+        view->navigation_target = G_MAXUINT;
+        view->rows_generation++;
+    }
+}
 
+/*
+ * Draws the dominant field color of every minimap row, the highest block entropy
+ * of every row along the right edge, and the visible part of the file
+ * Drawing costs O(height), whatever the number of fields and blocks
+ */
+static void
+draw_minimap (GtkDrawingArea *drawing_area,
+              cairo_t        *cr,
+              gint            width,
+              gint            height,
+              gpointer        user_data)
+{
+    ChirurgienView *view;
+    GdkRGBA color;
+    GtkStyleContext *context;
+
+    guint8 *colors;
+    gfloat *entropies;
+    gsize file_size;
+    gdouble visible_start, visible_end;
+    gint run_start;
+
+    view = user_data;
+
+    if (height <= 0)
+        return;
+
+    context = gtk_widget_get_style_context (GTK_WIDGET (drawing_area));
     gtk_style_context_get_color (context, &color);
-    gdk_cairo_set_source_rgba (cr, &color);
 
-    if (view->active_view == CHIRURGIEN_HEX_VIEW)
+    if (view->minimap)
     {
-        chirurgien_utils_hex_print (view->view_buffer,
-                                    view->file_contents->data,
-                                    view->scroll_offset,
-                                    view->buffer_size,
-                                    view->file_contents->len,
-                                    view->line_length);
+        colors = g_malloc (height);
+        chirurgien_minimap_get_colors (view->minimap, colors, height);
+
+        /* Rows of the same color are drawn together */
+        run_start = 0;
+
+        for (gint row = 1; row <= height; row++)
+        {
+            if (row < height && colors[row] == colors[run_start])
+                continue;
+
+            if (colors[run_start] != CHIRURGIEN_MINIMAP_NO_COLOR)
+            {
+                gdk_cairo_set_source_rgba (cr, &chirurgien_colors[ colors[run_start] ]);
+                cairo_rectangle (cr, 0, run_start, width, row - run_start);
+                cairo_fill (cr);
+            }
+
+            run_start = row;
+        }
+
+        g_free (colors);
     }
-    else if (view->active_view == CHIRURGIEN_TEXT_VIEW)
+
+    if (view->stats)
     {
-        chirurgien_utils_text_print (view->view_buffer,
-                                     view->file_contents->data,
-                                     view->scroll_offset,
-                                     view->buffer_size,
-                                     view->file_contents->len,
-                                     view->line_length);
+        entropies = g_new (gfloat, height);
+        chirurgien_stats_get_entropies (view->stats, entropies, height);
+
+        /* Compressed and encrypted data light up, from 6 bits per byte on */
+        for (gint row = 0; row < height; row++)
+        {
+            if (entropies[row] <= 6.0f)
+                continue;
+
+            cairo_set_source_rgba (cr, color.red, color.green, color.blue,
+                                   MIN ((entropies[row] - 6.0f) / 2.0f, 1.0f) * color.alpha);
+            cairo_rectangle (cr, width - MINIMAP_ENTROPY_WIDTH, row, MINIMAP_ENTROPY_WIDTH, 1);
+            cairo_fill (cr);
+        }
+
+        g_free (entropies);
     }
 
-    highlight_fields (view, view->view_layout);
+    file_size = get_file_size (view);
+
+    if (!file_size)
+        return;
+
+    visible_start = (gdouble) view->scroll_offset / file_size * height;
+    visible_end = (gdouble) (view->scroll_offset + view->buffer_size / 3) / file_size * height;
+    visible_end = MAX (MIN (visible_end, height), visible_start + 2);
+
+    gdk_cairo_set_source_rgba (cr, &color);
+
+    cairo_set_line_width (cr, 1);
+    cairo_rectangle (cr, 0.5, visible_start + 0.5, width - 1, visible_end - visible_start - 1);
+    cairo_stroke (cr);
+}
+
+/* Scrolls the view to center the clicked part of the file */
+static void
+handle_minimap_click (G_GNUC_UNUSED GtkGestureClick *gesture,
+                      G_GNUC_UNUSED gint             n_press,
+                      G_GNUC_UNUSED gdouble          x,
+                      gdouble  y,
+                      gpointer user_data)
+{
+    ChirurgienView *view;
+    gint height;
+
+    view = user_data;
+
+    height = gtk_widget_get_height (view->minimap_view);
+
+    if (height <= 0)
+        return;
 
-    pango_layout_set_text (view->view_layout, view->view_buffer, view->buffer_size);
-    pango_cairo_show_layout (cr, view->view_layout);
+    gtk_adjustment_set_value (view->adjustment,
+                              y / height * gtk_adjustment_get_upper (view->adjustment) -
+                              gtk_adjustment_get_page_size (view->adjustment) / 2);
 }
 
 static gboolean
@@ -488,19 +915,33 @@ handle_motion_event (G_GNUC_UNUSED GtkEventControllerMotion *controller,
                      gpointer user_data)
 {
     ChirurgienView *view;
-    FileField *file_field;
-    gint byte_position;
-    gsize byte_index;
+    ViewRow *row;
+    FileField file_field;
+    gint byte_position, row_index;
+    gsize byte_index, row_offset = 0;
 
     GString *field_tooltip;
 
     view = user_data;
 
-    if (!pango_layout_xy_to_index (view->view_layout,
-                                   x * PANGO_SCALE,
-                                   y * PANGO_SCALE,
-                                   &byte_position,
-                                   NULL))
+    /* Hit test the drawn row under the pointer */
+    row = NULL;
+    row_index = y * PANGO_SCALE / view->line_height;
+
+    if (view->n_rows && row_index >= 0 && (guint) row_index < view->n_rows)
+    {
+        row_offset = view->scroll_offset + row_index * (view->line_length / 3);
+        row = &view->rows[(row_offset / (view->line_length / 3)) % view->n_rows];
+
+        if (row->offset != row_offset || !row->layout)
+            row = NULL;
+    }
+
+    if (!row || !pango_layout_xy_to_index (row->layout,
+                                           x * PANGO_SCALE,
+                                           y * PANGO_SCALE - row_index * view->line_height,
+                                           &byte_position,
+                                           NULL))
     {
         view->current_mouse_index = G_MAXSIZE;
         view->n_fields_at_mouse_index = 0;
@@ -510,7 +951,7 @@ handle_motion_event (G_GNUC_UNUSED GtkEventControllerMotion *controller,
         return;
     }
 
-    byte_index = view->scroll_offset + (byte_position - (byte_position % 3)) / 3;
+    byte_index = row_offset + (byte_position - (byte_position % 3)) / 3;
 
     /* Same byte index, nothing to do */
     if (view->current_mouse_index == byte_index)
@@ -522,25 +963,30 @@ handle_motion_event (G_GNUC_UNUSED GtkEventControllerMotion *controller,
 
     field_tooltip = g_string_new (NULL);
 
-    /* Build the list of fields at the new mouse index */
-    for (GSList *i = view->file_fields; i; i = i->next)
+    if (!view->field_index)
     {
-        file_field = i->data;
+        gtk_widget_set_tooltip_text (view->file_view, NULL);
+        g_string_free (field_tooltip, TRUE);
 
-        if (file_field->field_offset > byte_index)
-            break;
+        return;
+    }
 
-        if (file_field->field_offset + file_field->field_size > byte_index)
-        {
-            view->fields_at_mouse_index = g_slist_prepend (view->fields_at_mouse_index, file_field);
+    /* Build the list of fields at the new mouse index */
+    for (guint i = chirurgien_field_index_next_overlapping (view->field_index, byte_index, byte_index + 1, 0);
+         i != G_MAXUINT;
+         i = chirurgien_field_index_next_overlapping (view->field_index, byte_index, byte_index + 1, i + 1))
+    {
+        chirurgien_field_index_get_field (view->field_index, i, &file_field);
 
-            if (field_tooltip->len)
-                field_tooltip = g_string_append_c (field_tooltip, '\n');
+        view->fields_at_mouse_index = g_slist_prepend (view->fields_at_mouse_index,
+                                                       GUINT_TO_POINTER (i));
 
-            field_tooltip = g_string_append (field_tooltip, file_field->field_name);
+        if (field_tooltip->len)
+            field_tooltip = g_string_append_c (field_tooltip, '\n');
 
-            view->n_fields_at_mouse_index++;
-        }
+        field_tooltip = g_string_append (field_tooltip, file_field.field_name);
+
+        view->n_fields_at_mouse_index++;
     }
 
     gtk_widget_set_tooltip_text (view->file_view, field_tooltip->str);
@@ -548,12 +994,37 @@ handle_motion_event (G_GNUC_UNUSED GtkEventControllerMotion *controller,
     g_string_free (field_tooltip, TRUE);
 }
 
+static void
+stop_analysis_progress (ChirurgienView *view)
+{
+    g_clear_handle_id (&view->analysis_progress_source, g_source_remove);
+    view->analysis_file = NULL;
+
+    gtk_statusbar_remove_all (view->status,
+                              gtk_statusbar_get_context_id (view->status, "analysis"));
+}
+
+static void
+cancel_analysis (ChirurgienView *view)
+{
+    if (view->analysis_cancellable)
+    {
+        g_cancellable_cancel (view->analysis_cancellable);
+        g_clear_object (&view->analysis_cancellable);
+
+        stop_analysis_progress (view);
+    }
+}
+
 static void
 file_modified (ChirurgienView *view,
                gboolean        force_reanalysis)
 {
     view->modified = TRUE;
 
+    /* The in-flight analysis is outdated */
+    cancel_analysis (view);
+
     if (view->modification_save_point == view->modification_index)
         chirurgien_view_tab_set_unsaved (view->view_tab, FALSE);
     else
@@ -590,32 +1061,33 @@ edit_field_response (GtkDialog *dialog,
     ChirurgienView *view;
     FileModification *modification, *old_modification;
 
-    const guchar *file_contents;
+    g_autofree guchar *file_contents = NULL;
     const guchar *new_contents;
 
     if (response_id == GTK_RESPONSE_ACCEPT)
     {
         view = user_data;
 
-        file_contents = view->file_contents->data +
-                        view->selected_field->field_offset;
+        file_contents = g_malloc (view->selected_field.field_size);
+        chirurgien_document_read (view->document,
+                                  view->selected_field.field_offset,
+                                  view->selected_field.field_size,
+                                  file_contents);
         new_contents = chirurgien_editor_get_contents (CHIRURGIEN_EDITOR
                                                       (gtk_widget_get_first_child
                                                       (gtk_dialog_get_content_area (dialog))));
 
         if (memcmp (file_contents,
                     new_contents,
-                    view->selected_field->field_size))
+                    view->selected_field.field_size))
         {
             modification = g_slice_new (FileModification);
 
             modification->type = FIELD_EDITION;
-            modification->offset = view->selected_field->field_offset;
-            modification->length = view->selected_field->field_size;
+            modification->offset = view->selected_field.field_offset;
+            modification->length = view->selected_field.field_size;
             modification->data = g_malloc (modification->length);
 
-            file_contents = view->file_contents->data + modification->offset;
-
             for (gsize i = 0; i < modification->length; i++)
                 modification->data[i] = new_contents[i] ^ file_contents[i];
 
@@ -647,21 +1119,28 @@ edit_field (GtkButton *button,
     GtkWidget *editor, *edition_dialog, *content_area;
 
     g_autofree gchar *short_field_name = NULL;
+    g_autofree guchar *field_contents = NULL;
 
     view = user_data;
 
     gtk_popover_popdown (GTK_POPOVER (gtk_widget_get_ancestor (GTK_WIDGET (button),
                                       GTK_TYPE_POPOVER)));
 
+    field_contents = g_malloc (view->selected_field.field_size);
+    chirurgien_document_read (view->document,
+                              view->selected_field.field_offset,
+                              view->selected_field.field_size,
+                              field_contents);
+
     editor = chirurgien_editor_new ();
     chirurgien_editor_set_contents (CHIRURGIEN_EDITOR (editor),
-                                    view->file_contents->data + view->selected_field->field_offset,
-                                    view->selected_field->field_size);
+                                    field_contents,
+                                    view->selected_field.field_size);
 
     for (gsize i = 0; !short_field_name; i++)
-        if (view->selected_field->field_name[i] == '\n' ||
-            view->selected_field->field_name[i] == '\0')
-            short_field_name = g_strndup (view->selected_field->field_name, i);
+        if (view->selected_field.field_name[i] == '\n' ||
+            view->selected_field.field_name[i] == '\0')
+            short_field_name = g_strndup (view->selected_field.field_name, i);
 
     edition_dialog = gtk_dialog_new_with_buttons (short_field_name,
                          GTK_WINDOW (gtk_widget_get_ancestor (GTK_WIDGET (view), CHIRURGIEN_TYPE_WINDOW)),
@@ -691,6 +1170,9 @@ extract_field (G_GNUC_UNUSED GtkButton *button,
     ChirurgienWindow *window;
     ChirurgienView *view, *extract_view;
 
+    guchar *field_contents;
+    GBytes *field_bytes;
+
     g_autofree gchar *short_field_name = NULL;
     g_autofree gchar *basename;
 
@@ -698,15 +1180,23 @@ extract_field (G_GNUC_UNUSED GtkButton *button,
     window = CHIRURGIEN_WINDOW (gtk_widget_get_ancestor (GTK_WIDGET (view),
                                                          CHIRURGIEN_TYPE_WINDOW));
 
+    field_contents = g_malloc (view->selected_field.field_size);
+    chirurgien_document_read (view->document,
+                              view->selected_field.field_offset,
+                              view->selected_field.field_size,
+                              field_contents);
+    field_bytes = g_bytes_new_take (field_contents, view->selected_field.field_size);
+
     extract_view = chirurgien_view_new (window);
-    g_byte_array_append (extract_view->file_contents,
-                         view->file_contents->data + view->selected_field->field_offset,
-                         view->selected_field->field_size);
+    chirurgien_document_free (extract_view->document);
+    extract_view->document = chirurgien_document_new (field_bytes);
+
+    g_bytes_unref (field_bytes);
 
     for (gsize i = 0; !short_field_name; i++)
-        if (view->selected_field->field_name[i] == '\n' ||
-            view->selected_field->field_name[i] == '\0')
-            short_field_name = g_strndup (view->selected_field->field_name, i);
+        if (view->selected_field.field_name[i] == '\n' ||
+            view->selected_field.field_name[i] == '\0')
+            short_field_name = g_strndup (view->selected_field.field_name, i);
 
     basename = g_path_get_basename (view->file_path);
 
@@ -734,13 +1224,14 @@ delete_field (GtkButton *button,
     modification = g_slice_new (FileModification);
 
     modification->type = FIELD_DELETION;
-    modification->offset = view->selected_field->field_offset;
-    modification->length = view->selected_field->field_size;
+    modification->offset = view->selected_field.field_offset;
+    modification->length = view->selected_field.field_size;
     modification->data = g_malloc (modification->length);
 
-    memcpy (modification->data,
-            view->file_contents->data + modification->offset,
-            modification->length);
+    chirurgien_document_read (view->document,
+                              modification->offset,
+                              modification->length,
+                              modification->data);
 
     /* Delete now outdated modifications */
     while ((old_modification = g_queue_pop_nth (&view->modifications,
@@ -777,10 +1268,10 @@ insert_edit_response (GtkDialog *dialog,
 
         modification->type = FIELD_INSERTION;
         if (!view->insertion_type)
-            modification->offset = view->selected_field->field_offset;
+            modification->offset = view->selected_field.field_offset;
         else
-            modification->offset = view->selected_field->field_offset +
-                                   view->selected_field->field_size;
+            modification->offset = view->selected_field.field_offset +
+                                   view->selected_field.field_size;
         modification->length = chirurgien_editor_get_contents_size (editor);
         modification->data = g_malloc (modification->length);
 
@@ -891,7 +1382,7 @@ insert_field (GtkButton *button,
 
 static void
 create_field_popover (GtkPopover *popover,
-                      FileField  *file_field)
+                      guint       field)
 {
     ChirurgienView *view;
     GtkWidget *grid, *widget1, *widget2, *widget3;
@@ -899,6 +1390,8 @@ create_field_popover (GtkPopover *popover,
     view = CHIRURGIEN_VIEW (gtk_widget_get_ancestor (GTK_WIDGET (popover),
                                                      CHIRURGIEN_TYPE_VIEW));
 
+    chirurgien_field_index_get_field (view->field_index, field, &view->selected_field);
+
     grid = gtk_grid_new ();
     gtk_grid_set_column_spacing (GTK_GRID (grid), 10);
     gtk_grid_set_row_spacing (GTK_GRID (grid), 15);
@@ -908,7 +1401,7 @@ create_field_popover (GtkPopover *popover,
     gtk_widget_set_margin_bottom (grid, 5);
     gtk_widget_set_margin_top (grid, 5);
 
-    widget1 = gtk_label_new (file_field->field_name);
+    widget1 = gtk_label_new (view->selected_field.field_name);
 
     gtk_grid_attach (GTK_GRID (grid), widget1, 0, 0, 6, 1);
 
@@ -957,8 +1450,6 @@ create_field_popover (GtkPopover *popover,
         gtk_grid_attach_next_to (GTK_GRID (grid), widget3, widget2, GTK_POS_RIGHT, 2, 1);
     }
 
-    view->selected_field = file_field;
-
     gtk_popover_set_child (popover, grid);
 }
 
@@ -972,7 +1463,7 @@ field_selected (GtkButton *button,
                            GTK_TYPE_POPOVER));
 
     gtk_widget_unparent (gtk_popover_get_child (popover));
-    create_field_popover (popover, user_data);
+    create_field_popover (popover, GPOINTER_TO_UINT (user_data));
 }
 
 static void
@@ -986,7 +1477,7 @@ handle_click (GtkGestureClick *gesture,
     GtkWidget *popover, *grid, *widget, *button;
     GdkRectangle position;
 
-    FileField *file_field;
+    FileField file_field;
     gint grid_row;
 
     gchar *byte_index;
@@ -1002,14 +1493,16 @@ handle_click (GtkGestureClick *gesture,
 
         if (view->n_fields_at_mouse_index == 1)
         {
-            file_field = view->fields_at_mouse_index->data;
+            chirurgien_field_index_get_field (view->field_index,
+                                              GPOINTER_TO_UINT (view->fields_at_mouse_index->data),
+                                              &file_field);
             byte_index = g_strdup_printf (_("Byte offset: %lu (hex: %lX)\t\tField offset: %lu (hex: %lX)\t\tByte offset in field: %lu (hex: %lX)"),
                                           view->current_mouse_index,
                                           view->current_mouse_index,
-                                          file_field->field_offset,
-                                          file_field->field_offset,
-                                          view->current_mouse_index - file_field->field_offset,
-                                          view->current_mouse_index - file_field->field_offset);
+                                          file_field.field_offset,
+                                          file_field.field_offset,
+                                          view->current_mouse_index - file_field.field_offset,
+                                          view->current_mouse_index - file_field.field_offset);
         }
         else
         {
@@ -1047,7 +1540,8 @@ handle_click (GtkGestureClick *gesture,
 
         if (view->n_fields_at_mouse_index == 1)
         {
-            create_field_popover (GTK_POPOVER (popover), view->fields_at_mouse_index->data);
+            create_field_popover (GTK_POPOVER (popover),
+                                  GPOINTER_TO_UINT (view->fields_at_mouse_index->data));
         }
         else
         {
@@ -1067,9 +1561,11 @@ handle_click (GtkGestureClick *gesture,
             grid_row = 1;
             for (GSList *i = view->fields_at_mouse_index; i; i = i->next)
             {
-                file_field = i->data;
+                chirurgien_field_index_get_field (view->field_index,
+                                                  GPOINTER_TO_UINT (i->data),
+                                                  &file_field);
 
-                widget = gtk_label_new (file_field->field_name);
+                widget = gtk_label_new (file_field.field_name);
                 gtk_widget_set_halign (widget, GTK_ALIGN_END);
 
                 button = gtk_button_new_from_icon_name ("go-next-symbolic");
@@ -1077,7 +1573,7 @@ handle_click (GtkGestureClick *gesture,
                 gtk_widget_set_tooltip_text (button, _("Select field"));
                 gtk_widget_add_css_class (button, "circular");
 
-                g_signal_connect (button, "clicked", G_CALLBACK (field_selected), file_field);
+                g_signal_connect (button, "clicked", G_CALLBACK (field_selected), i->data);
 
                 gtk_grid_attach (GTK_GRID (grid), widget, 0, grid_row++, 1, 1);
                 gtk_grid_attach_next_to (GTK_GRID (grid), button, widget, GTK_POS_RIGHT, 1, 1);
@@ -1096,21 +1592,21 @@ navigate_view (GtkButton *button,
                gpointer   user_data)
 {
     ChirurgienView *view;
-    const FileField *file_field;
+    FileField file_field;
 
     gsize field_line;
 
     view = CHIRURGIEN_VIEW (gtk_widget_get_ancestor (GTK_WIDGET (button), CHIRURGIEN_TYPE_VIEW));
-    file_field = user_data;
+    chirurgien_field_index_get_field (view->field_index, GPOINTER_TO_UINT (user_data), &file_field);
 
-    field_line = (file_field->field_offset * 3) / view->line_length;
+    field_line = (file_field.field_offset * 3) / view->line_length;
 
     if (field_line <= 3)
         field_line = 0;
     else
         field_line -= 3;
 
-    view->navigation_target = file_field;
+    view->navigation_target = GPOINTER_TO_UINT (user_data);
 
     gtk_adjustment_set_value (view->adjustment, field_line);
 
@@ -1121,17 +1617,17 @@ navigate_view (GtkButton *button,
 static void
 build_navigation_buttons (ChirurgienView *view)
 {
-    FileField *file_field;
+    FileField file_field;
     GtkWidget *button;
 
-    for (GSList *i = view->file_fields; i; i = i->next)
+    for (guint i = 0; i < chirurgien_field_index_get_n_fields (view->field_index); i++)
     {
-        file_field = i->data;
+        chirurgien_field_index_get_field (view->field_index, i, &file_field);
 
-        if (file_field->navigation_label)
+        if (file_field.navigation_label)
         {
-            button = gtk_button_new_with_label (file_field->navigation_label);
-            g_signal_connect (button, "clicked", G_CALLBACK (navigate_view), file_field);
+            button = gtk_button_new_with_label (file_field.navigation_label);
+            g_signal_connect (button, "clicked", G_CALLBACK (navigate_view), GUINT_TO_POINTER (i));
             gtk_widget_add_css_class (button, "flat");
 
             gtk_box_append (view->navigation, button);
@@ -1156,56 +1652,836 @@ build_navigation_buttons (ChirurgienView *view)
 }
 
 static void
-get_view_measures (ChirurgienView *view)
+create_section (GtkWidget  **expander,
+                GtkWidget  **grid,
+                const gchar *section_name)
 {
-    PangoContext *context;
-    PangoFontMetrics *font_metrics;
+    *grid = gtk_grid_new ();
+    gtk_grid_set_column_spacing (GTK_GRID (*grid), 10);
+    gtk_widget_set_margin_start (*grid, 10);
+    gtk_widget_set_margin_end (*grid, 10);
+    gtk_widget_set_margin_top (*grid, 10);
+    gtk_widget_set_margin_bottom (*grid, 10);
+    gtk_widget_set_halign (*grid, GTK_ALIGN_CENTER);
+
+    *expander = gtk_expander_new (section_name);
+    gtk_expander_set_child (GTK_EXPANDER (*expander), *grid);
+    gtk_expander_set_expanded (GTK_EXPANDER (*expander), TRUE);
+}
 
-    gint bytes_per_line;
+static void
+create_line_labels (GtkWidget  **left_label,
+                    GtkWidget  **right_label,
+                    const gchar *field_name,
+                    const gchar *field_value,
+                    const gchar *field_tooltip,
+                    gint         margin_top,
+                    gint         margin_bottom)
+{
+    *left_label = gtk_label_new (NULL);
+    gtk_label_set_markup (GTK_LABEL (*left_label), field_name);
+    gtk_label_set_wrap (GTK_LABEL (*left_label), TRUE);
+    gtk_label_set_xalign (GTK_LABEL (*left_label), 1.0f);
+    gtk_widget_set_halign (*left_label, GTK_ALIGN_END);
+    gtk_widget_set_margin_top (*left_label, margin_top);
+    gtk_widget_set_margin_bottom (*left_label, margin_bottom);
+    gtk_widget_add_css_class (*left_label, "dim-label");
+
+    if (field_tooltip)
+        gtk_widget_set_tooltip_markup (GTK_WIDGET (*left_label), field_tooltip);
+
+    *right_label = gtk_label_new (NULL);
+    gtk_label_set_markup (GTK_LABEL (*right_label), field_value);
+    gtk_label_set_wrap (GTK_LABEL (*right_label), TRUE);
+    gtk_label_set_xalign (GTK_LABEL (*right_label), 0.0f);
+    gtk_widget_set_halign (*right_label, GTK_ALIGN_START);
+    gtk_widget_set_margin_top (*right_label, margin_top);
+    gtk_widget_set_margin_bottom (*right_label, margin_bottom);
+}
 
-    context = gtk_widget_get_pango_context (view->file_view);
-    font_metrics = pango_context_get_metrics (context, pango_context_get_font_description (context),
-                                              pango_context_get_language (context));
+static GtkWidget *
+create_title_label (const gchar *title)
+{
+    GtkWidget *label;
+    PangoAttrList *attribute_list;
+    PangoAttribute *size, *weight;
 
-    view->char_width =  pango_font_metrics_get_approximate_digit_width (font_metrics);
+    attribute_list = pango_attr_list_new ();
 
-    view->line_height = pango_font_metrics_get_ascent (font_metrics) +
-                        pango_font_metrics_get_descent (font_metrics);
+    weight = pango_attr_weight_new (PANGO_WEIGHT_BOLD);
+    size = pango_attr_scale_new (PANGO_SCALE_LARGE);
 
-    bytes_per_line = g_settings_get_int (view->preferences_settings, "bytes-per-line");
-    if (bytes_per_line)
-    {
-        view->manual_line_length = TRUE;
-        view->line_length = bytes_per_line * 3;
-    }
-    else
-    {
-        view->manual_line_length = FALSE;
-    }
+    weight->start_index = size->start_index = PANGO_ATTR_INDEX_FROM_TEXT_BEGINNING;
+    weight->end_index = size->end_index = PANGO_ATTR_INDEX_TO_TEXT_END;
 
-    pango_font_metrics_unref (font_metrics);
-}
+    pango_attr_list_insert (attribute_list, weight);
+    pango_attr_list_insert (attribute_list, size);
+
+    label = gtk_label_new (title);
+    gtk_label_set_attributes (GTK_LABEL (label), attribute_list);
+
+    pango_attr_list_unref (attribute_list);
+
+    return label;
+}
+
+static GtkWidget *
+create_note_label (const gchar *note)
+{
+    GtkWidget *label;
+
+    label = gtk_label_new (NULL);
+    gtk_label_set_markup (GTK_LABEL (label), note);
+    gtk_label_set_wrap (GTK_LABEL (label), TRUE);
+    gtk_label_set_xalign (GTK_LABEL (label), 0.0f);
+    gtk_widget_set_halign (label, GTK_ALIGN_START);
+    gtk_widget_add_css_class (label, "dim-label");
+
+    return label;
+}
+
+static GtkWidget *
+create_text_expander (const gchar *field_name,
+                      const gchar *text)
+{
+    GtkWidget *textview, *expander;
+    GtkTextBuffer *buffer;
+    GtkTextIter start;
+
+    textview = gtk_text_view_new ();
+    gtk_widget_set_margin_start (textview, 10);
+    gtk_widget_set_margin_end (textview, 10);
+    gtk_widget_set_margin_bottom (textview, 10);
+    gtk_widget_set_margin_top (textview, 10);
+    gtk_text_view_set_editable (GTK_TEXT_VIEW (textview), FALSE);
+    gtk_text_view_set_cursor_visible (GTK_TEXT_VIEW (textview), FALSE);
+    buffer = gtk_text_view_get_buffer (GTK_TEXT_VIEW (textview));
+
+    if (text)
+    {
+        gtk_text_buffer_set_text (buffer, text, -1);
+    }
+    else
+    {
+        gtk_text_buffer_get_start_iter (buffer, &start);
+        gtk_text_buffer_insert_markup (buffer, &start,
+                     "<span foreground=\"red\">[INVALID ENCODING]</span>", -1);
+    }
+
+    expander = gtk_expander_new (field_name);
+    gtk_expander_set_child (GTK_EXPANDER (expander), textview);
+    gtk_expander_set_expanded (GTK_EXPANDER (expander), TRUE);
+
+    return expander;
+}
+
+static GtkWidget *
+create_page_contents (void)
+{
+    GtkWidget *contents;
+
+    contents = gtk_box_new (GTK_ORIENTATION_VERTICAL, 10);
+    gtk_widget_set_can_focus (contents, FALSE);
+    gtk_widget_set_margin_start (contents, 10);
+    gtk_widget_set_margin_end (contents, 10);
+    gtk_widget_set_margin_top (contents, 10);
+    gtk_widget_set_margin_bottom (contents, 10);
+
+    return contents;
+}
+
+/* Materializes the description records of a page into widgets */
+static void
+build_description_page (ChirurgienView *view,
+                        guint           page,
+                        GtkBox         *contents)
+{
+    const DescriptionRecord *record;
+    GtkWidget *expander, *grid, *left_label, *right_label;
+
+    GtkGrid *section;
+    guint first_record, last_record, description_lines_count;
+
+    file_description_get_page (view->file_description, page,
+                               &first_record, &last_record);
+
+    section = NULL;
+    description_lines_count = 0;
+
+    for (guint i = first_record; i < last_record; i++)
+    {
+        record = &g_array_index (view->file_description->records, DescriptionRecord, i);
+
+        switch (record->type)
+        {
+            case DESCRIPTION_TITLE:
+            gtk_box_append (contents, create_title_label (record->name));
+
+            break;
+            case DESCRIPTION_SECTION:
+            create_section (&expander, &grid, record->name);
+            gtk_box_append (contents, expander);
+
+            section = GTK_GRID (grid);
+            description_lines_count = 0;
+
+            break;
+            case DESCRIPTION_LINE:
+            if (!section)
+                break;
+
+            create_line_labels (&left_label, &right_label,
+                                record->name, record->value, record->tooltip,
+                                record->margin_top, record->margin_bottom);
+
+            gtk_grid_attach (section, left_label, 0, description_lines_count++, 1, 1);
+            gtk_grid_attach_next_to (section, right_label, left_label, GTK_POS_RIGHT, 1, 1);
+
+            break;
+            case DESCRIPTION_NOTE:
+            gtk_box_append (contents, create_note_label (record->name));
+
+            break;
+            case DESCRIPTION_TEXT:
+            gtk_box_append (contents, create_text_expander (record->name, record->value));
+
+            break;
+            default:
+            break;
+        }
+    }
+}
+
+/*
+ * Materializes the 'Overview' page, the other pages are only
+ * inserted as empty tabs until they are first shown
+ */
+static void
+build_description (ChirurgienView *view)
+{
+    const DescriptionRecord *record;
+    GtkWidget *scrolled;
+
+    guint first_record, last_record;
+
+    build_description_page (view, 0, view->overview);
+
+    for (guint page = 1;
+         page < file_description_get_n_pages (view->file_description);
+         page++)
+    {
+        file_description_get_page (view->file_description, page,
+                                   &first_record, &last_record);
+        record = &g_array_index (view->file_description->records, DescriptionRecord, first_record);
+
+        scrolled = gtk_scrolled_window_new ();
+        g_object_set_data (G_OBJECT (scrolled), "description-page", GUINT_TO_POINTER (page));
+
+        gtk_notebook_insert_page (view->description, scrolled,
+                                  gtk_label_new (record->name), -1);
+    }
+}
+
+static void
+description_page_switched (G_GNUC_UNUSED GtkNotebook *notebook,
+                           GtkWidget   *page,
+                           G_GNUC_UNUSED guint        page_num,
+                           gpointer     user_data)
+{
+    ChirurgienView *view;
+    GtkWidget *contents;
+
+    guint description_page;
+
+    view = user_data;
+
+    /* Only description pages have a page number, the 'Overview' is page 0 */
+    description_page = GPOINTER_TO_UINT (g_object_get_data (G_OBJECT (page), "description-page"));
+
+    if (!description_page ||
+        !view->file_description ||
+        gtk_scrolled_window_get_child (GTK_SCROLLED_WINDOW (page)))
+    {
+        return;
+    }
+
+    contents = create_page_contents ();
+    build_description_page (view, description_page, GTK_BOX (contents));
+
+    gtk_scrolled_window_set_child (GTK_SCROLLED_WINDOW (page), contents);
+}
+
+/* What the entropy and chi-square of a byte range suggest about its contents */
+static const gchar *
+statistics_verdict (gdouble entropy,
+                    gdouble chi_square,
+                    gsize   size)
+{
+    /* The chi-square test needs at least 5 expected counts per byte value */
+    if (size < 256 * 5)
+        return _("Too small to classify");
+
+    if (entropy >= STATS_HIGH_ENTROPY)
+    {
+        if (chi_square <= STATS_RANDOM_CHI_SQUARE)
+            return _("Random, likely encrypted");
+        else
+            return _("Likely compressed");
+    }
+
+    if (entropy < 1.0)
+        return _("Mostly constant");
+
+    return _("Structured");
+}
+
+/* Draws the byte histogram of the statistics, in a logarithmic scale */
+static void
+draw_histogram (GtkDrawingArea *drawing_area,
+                cairo_t        *cr,
+                gint            width,
+                gint            height,
+                gpointer        user_data)
+{
+    GdkRGBA color;
+    GtkStyleContext *context;
+
+    const guint64 *histogram;
+    gdouble max_count, bar_width, bar_height;
+
+    histogram = chirurgien_stats_get_histogram (user_data);
+
+    max_count = 0;
+    for (guint c = 0; c < 256; c++)
+        max_count = MAX (max_count, log1p (histogram[c]));
+
+    if (!max_count)
+        return;
+
+    context = gtk_widget_get_style_context (GTK_WIDGET (drawing_area));
+    gtk_style_context_get_color (context, &color);
+    gdk_cairo_set_source_rgba (cr, &color);
+
+    bar_width = (gdouble) width / 256;
+
+    for (guint c = 0; c < 256; c++)
+    {
+        bar_height = log1p (histogram[c]) / max_count * height;
+        cairo_rectangle (cr, c * bar_width, height - bar_height, bar_width, bar_height);
+    }
+
+    cairo_fill (cr);
+}
+
+/* The unused data regions of the last analysis, the statistics page lists their statistics */
+static GArray *
+collect_unused_regions (ChirurgienView *view)
+{
+    GArray *regions;
+    ChirurgienStatsRegion region = { 0 };
+    FileField field;
+
+    guint n_fields;
+
+    regions = g_array_new (FALSE, FALSE, sizeof (ChirurgienStatsRegion));
+
+    if (!view->field_index)
+        return regions;
+
+    n_fields = chirurgien_field_index_get_n_fields (view->field_index);
+
+    for (guint i = 0; i < n_fields && regions->len < STATS_MAX_LISTED_REGIONS; i++)
+    {
+        chirurgien_field_index_get_field (view->field_index, i, &field);
+
+        if (!field.unused)
+            continue;
+
+        region.offset = field.field_offset;
+        region.size = field.field_size;
+        g_array_append_val (regions, region);
+    }
+
+    return regions;
+}
+
+static void
+build_statistics_page (ChirurgienView *view,
+                       gboolean        select)
+{
+    const ChirurgienStatsRegion *region;
+    const GArray *regions;
+
+    GtkWidget *contents, *expander, *grid, *left_label, *right_label, *histogram;
+
+    g_autofree gchar *offset_text = NULL;
+    g_autofree gchar *value_text = NULL;
+    gdouble entropy, chi_square, run_entropy;
+    gsize file_size, run_offset;
+    guint n_blocks, run_start, listed;
+    gint page_num;
+
+    file_size = chirurgien_stats_get_file_size (view->stats);
+    chirurgien_stats_get_totals (view->stats, &entropy, &chi_square);
+
+    contents = create_page_contents ();
+    gtk_box_append (GTK_BOX (contents), create_title_label (_("Statistics")));
+
+    create_section (&expander, &grid, _("Whole file"));
+    gtk_box_append (GTK_BOX (contents), expander);
+
+    value_text = g_strdup_printf (_("%lu bytes"), file_size);
+    create_line_labels (&left_label, &right_label, _("Size"), value_text, NULL, 0, 0);
+    gtk_grid_attach (GTK_GRID (grid), left_label, 0, 0, 1, 1);
+    gtk_grid_attach_next_to (GTK_GRID (grid), right_label, left_label, GTK_POS_RIGHT, 1, 1);
+
+    g_free (value_text);
+    value_text = g_strdup_printf (_("%.4f bits per byte"), entropy);
+    create_line_labels (&left_label, &right_label, _("Entropy"), value_text, NULL, 0, 0);
+    gtk_grid_attach (GTK_GRID (grid), left_label, 0, 1, 1, 1);
+    gtk_grid_attach_next_to (GTK_GRID (grid), right_label, left_label, GTK_POS_RIGHT, 1, 1);
+
+    g_free (value_text);
+    value_text = g_strdup_printf ("%.2f", chi_square);
+    create_line_labels (&left_label, &right_label, _("Chi-square"), value_text,
+                        _("Chi-square of the byte counts against uniformly distributed bytes"), 0, 0);
+    gtk_grid_attach (GTK_GRID (grid), left_label, 0, 2, 1, 1);
+    gtk_grid_attach_next_to (GTK_GRID (grid), right_label, left_label, GTK_POS_RIGHT, 1, 1);
+
+    create_line_labels (&left_label, &right_label, _("Contents"),
+                        statistics_verdict (entropy, chi_square, file_size), NULL, 0, 0);
+    gtk_grid_attach (GTK_GRID (grid), left_label, 0, 3, 1, 1);
+    gtk_grid_attach_next_to (GTK_GRID (grid), right_label, left_label, GTK_POS_RIGHT, 1, 1);
+
+    create_section (&expander, &grid, _("Byte histogram"));
+    gtk_box_append (GTK_BOX (contents), expander);
+
+    histogram = gtk_drawing_area_new ();
+    gtk_drawing_area_set_content_width (GTK_DRAWING_AREA (histogram), 512);
+    gtk_drawing_area_set_content_height (GTK_DRAWING_AREA (histogram), 128);
+    gtk_drawing_area_set_draw_func (GTK_DRAWING_AREA (histogram), draw_histogram,
+                                    chirurgien_stats_ref (view->stats), chirurgien_stats_unref);
+    gtk_widget_set_tooltip_text (histogram, _("Byte values 0x00 to 0xFF, logarithmic scale"));
+    gtk_grid_attach (GTK_GRID (grid), histogram, 0, 0, 1, 1);
+
+    regions = chirurgien_stats_get_regions (view->stats);
+
+    if (regions->len)
+    {
+        create_section (&expander, &grid, _("Unused data"));
+        gtk_box_append (GTK_BOX (contents), expander);
+
+        for (guint i = 0; i < regions->len; i++)
+        {
+            region = &g_array_index (regions, ChirurgienStatsRegion, i);
+
+            g_free (offset_text);
+            offset_text = g_strdup_printf ("0x%lX", region->offset);
+            g_free (value_text);
+            value_text = g_strdup_printf (_("%lu bytes, entropy %.2f, chi-square %.2f: %s"),
+                                          region->size, region->entropy, region->chi_square,
+                                          statistics_verdict (region->entropy, region->chi_square,
+                                                              region->size));
+
+            create_line_labels (&left_label, &right_label, offset_text, value_text, NULL, 0, 0);
+            gtk_grid_attach (GTK_GRID (grid), left_label, 0, i, 1, 1);
+            gtk_grid_attach_next_to (GTK_GRID (grid), right_label, left_label, GTK_POS_RIGHT, 1, 1);
+        }
+    }
+
+    /* Runs of high entropy blocks */
+    n_blocks = chirurgien_stats_get_n_blocks (view->stats);
+    run_start = G_MAXUINT;
+    run_entropy = 0;
+    listed = 0;
+    grid = NULL;
+
+    for (guint block = 0; block <= n_blocks && listed < STATS_MAX_LISTED_REGIONS; block++)
+    {
+        entropy = 0;
+        if (block < n_blocks)
+            chirurgien_stats_get_block (view->stats, block, &entropy, &chi_square);
+
+        if (entropy >= STATS_HIGH_ENTROPY)
+        {
+            if (run_start == G_MAXUINT)
+            {
+                run_start = block;
+                run_entropy = 0;
+            }
+            run_entropy += entropy;
+
+            continue;
+        }
+
+        if (run_start == G_MAXUINT)
+            continue;
+
+        if (!grid)
+        {
+            create_section (&expander, &grid, _("High entropy data"));
+            gtk_box_append (GTK_BOX (contents), expander);
+        }
+
+        run_offset = (gsize) run_start * CHIRURGIEN_STATS_BLOCK_SIZE;
+
+        g_free (offset_text);
+        offset_text = g_strdup_printf ("0x%lX", run_offset);
+        g_free (value_text);
+        value_text = g_strdup_printf (_("%lu bytes, mean block entropy %.2f"),
+                                      MIN ((gsize) block * CHIRURGIEN_STATS_BLOCK_SIZE, file_size) - run_offset,
+                                      run_entropy / (block - run_start));
+
+        create_line_labels (&left_label, &right_label, offset_text, value_text, NULL, 0, 0);
+        gtk_grid_attach (GTK_GRID (grid), left_label, 0, listed++, 1, 1);
+        gtk_grid_attach_next_to (GTK_GRID (grid), right_label, left_label, GTK_POS_RIGHT, 1, 1);
+
+        run_start = G_MAXUINT;
+    }
+
+    /* The page is replaced in place, and stays selected */
+    page_num = 1;
+
+    if (view->stats_page)
+    {
+        page_num = gtk_notebook_page_num (view->description, view->stats_page);
+        if (gtk_notebook_get_current_page (view->description) == page_num)
+            select = TRUE;
+
+        gtk_notebook_remove_page (view->description, page_num);
+    }
+
+    view->stats_page = gtk_scrolled_window_new ();
+    gtk_scrolled_window_set_child (GTK_SCROLLED_WINDOW (view->stats_page), contents);
+
+    gtk_notebook_insert_page (view->description, view->stats_page,
+                              gtk_label_new (_("Statistics")), page_num);
+    if (select)
+        gtk_notebook_set_current_page (view->description, page_num);
+}
+
+static void
+stats_data_destroy (gpointer data)
+{
+    StatsData *stats;
+
+    stats = data;
+
+    chirurgien_document_free (stats->document);
+    if (stats->previous)
+        chirurgien_stats_unref (stats->previous);
+    if (stats->regions)
+        g_array_unref (stats->regions);
+    if (stats->stats)
+        chirurgien_stats_unref (stats->stats);
+
+    g_slice_free (StatsData, stats);
+}
+
+static void
+compute_statistics (GTask        *task,
+                    G_GNUC_UNUSED gpointer      source_object,
+                    gpointer      task_data,
+                    GCancellable *cancellable)
+{
+    StatsData *stats;
+
+    stats = task_data;
+
+    stats->stats = chirurgien_stats_compute (stats->previous,
+                                             stats->document,
+                                             stats->dirty_start,
+                                             stats->dirty_end,
+                                             g_steal_pointer (&stats->regions),
+                                             cancellable);
+
+    g_task_return_boolean (task, stats->stats != NULL);
+}
+
+static void
+statistics_finished (GObject      *source_object,
+                     GAsyncResult *result,
+                     G_GNUC_UNUSED gpointer user_data)
+{
+    ChirurgienView *view;
+    StatsData *stats;
+
+    if (!g_task_propagate_boolean (G_TASK (result), NULL))
+        return;
+
+    view = CHIRURGIEN_VIEW (source_object);
+    stats = g_task_get_task_data (G_TASK (result));
+
+    g_clear_object (&view->stats_cancellable);
+
+    g_clear_pointer (&view->stats, chirurgien_stats_unref);
+    view->stats = g_steal_pointer (&stats->stats);
+
+    /* Edits made meanwhile stay dirty */
+    if (stats->generation == view->stats_generation)
+    {
+        view->stats_dirty_start = G_MAXSIZE;
+        view->stats_dirty_end = 0;
+    }
+
+    build_statistics_page (view, stats->select);
+
+    gtk_widget_queue_draw (view->minimap_view);
+}
+
+/* Computes the statistics again, reusing the blocks outside the edited range */
+static void
+update_statistics (ChirurgienView *view,
+                   gboolean        select)
+{
+    StatsData *stats;
+    GTask *task;
+
+    /* A requested computation that has not finished yet still shows its page */
+    if (view->stats_cancellable && !view->stats_page)
+        select = TRUE;
+
+    if (view->stats_cancellable)
+        g_cancellable_cancel (view->stats_cancellable);
+    g_clear_object (&view->stats_cancellable);
+
+    view->stats_cancellable = g_cancellable_new ();
+
+    stats = g_slice_new0 (StatsData);
+    stats->document = chirurgien_document_snapshot (view->document);
+    stats->previous = view->stats ? chirurgien_stats_ref (view->stats) : NULL;
+    stats->dirty_start = view->stats_dirty_start;
+    stats->dirty_end = view->stats_dirty_end;
+    stats->regions = collect_unused_regions (view);
+    stats->generation = view->stats_generation;
+    stats->select = select;
+
+    task = g_task_new (view, view->stats_cancellable, statistics_finished, NULL);
+    g_task_set_task_data (task, stats, stats_data_destroy);
+    g_task_run_in_thread (task, compute_statistics);
+    g_object_unref (task);
+}
+
+static void
+clear_analysis (ChirurgienView *view)
+{
+    GtkWidget *child_widget;
+    gint description_pages;
+
+    /* The fields and description are kept for the next analysis to resume */
+    g_slist_free (g_steal_pointer (&view->fields_at_mouse_index));
+
+    view->current_mouse_index = G_MAXSIZE;
+    view->n_fields_at_mouse_index = 0;
+
+    view->navigation_target = G_MAXUINT;
+
+    for (child_widget = gtk_widget_get_first_child (GTK_WIDGET (view->navigation));
+         child_widget;
+         child_widget = gtk_widget_get_first_child (GTK_WIDGET (view->navigation)))
+        gtk_widget_unparent (child_widget);
+
+    for (child_widget = gtk_widget_get_first_child (GTK_WIDGET (view->overview));
+         child_widget;
+         child_widget = gtk_widget_get_first_child (GTK_WIDGET (view->overview)))
+        gtk_widget_unparent (child_widget);
+
+    /* The 'Overview', 'Embedded formats' and 'Statistics' pages stay */
+    description_pages = gtk_notebook_get_n_pages (view->description);
+
+    while (--description_pages)
+    {
+        child_widget = gtk_notebook_get_nth_page (view->description, description_pages);
+
+        if (child_widget != view->carving_page && child_widget != view->stats_page)
+            gtk_notebook_remove_page (view->description, description_pages);
+    }
+}
+
+static void
+analysis_data_destroy (gpointer data)
+{
+    AnalysisData *analysis;
+
+    analysis = data;
+
+    processor_file_destroy (analysis->file);
+    chirurgien_field_index_free (analysis->field_index);
+    chirurgien_minimap_free (analysis->minimap);
+    chirurgien_document_free (analysis->document);
+
+    g_slice_free (AnalysisData, analysis);
+}
+
+/* Sets the contents of a file to the chunks of a document, from origin on, without copying them */
+static void
+set_file_chunks (ProcessorFile            *file,
+                 const ChirurgienDocument *document,
+                 gsize                     origin)
+{
+    ChirurgienDocumentCursor cursor;
+
+    for (chirurgien_document_cursor_init (&cursor, document, origin);
+         cursor.chunk;
+         chirurgien_document_cursor_next (&cursor))
+        processor_file_append_chunk (file, cursor.chunk, cursor.chunk_length);
+}
+
+static void
+analyze_file (GTask        *task,
+              G_GNUC_UNUSED gpointer      source_object,
+              gpointer      task_data,
+              G_GNUC_UNUSED GCancellable *cancellable)
+{
+    AnalysisData *analysis;
+    FieldTable *fields;
+
+    gsize contents_size;
+
+    analysis = task_data;
+
+    contents_size = chirurgien_document_get_size (analysis->document);
+
+    analysis->origin = MIN (analysis->origin, contents_size);
+    set_file_chunks (analysis->file, analysis->document, analysis->origin);
+
+    chirurgien_formats_analyze (analysis->file);
+
+    fields = processor_file_get_fields (analysis->file);
+    field_table_rebase (fields, analysis->origin);
+
+    analysis->field_index = chirurgien_field_index_new (fields);
+    analysis->minimap = chirurgien_minimap_new (analysis->field_index, contents_size);
+
+    g_task_return_boolean (task, TRUE);
+}
+
+static gboolean
+report_analysis_progress (gpointer user_data)
+{
+    ChirurgienView *view;
+
+    gsize bytes_covered;
+    guint steps_executed;
+    gchar *progress;
+
+    view = user_data;
+
+    processor_file_get_progress (view->analysis_file, &bytes_covered, &steps_executed);
+
+    progress = g_strdup_printf (_("Analyzing: %lu of %lu bytes covered, %u steps executed"),
+                                MIN (bytes_covered, get_file_size (view)),
+                                get_file_size (view),
+                                steps_executed);
+
+    gtk_statusbar_remove_all (view->status,
+                              gtk_statusbar_get_context_id (view->status, "analysis"));
+    gtk_statusbar_push (view->status,
+                        gtk_statusbar_get_context_id (view->status, "analysis"),
+                        progress);
+    g_free (progress);
+
+    return G_SOURCE_CONTINUE;
+}
+
+static void
+analysis_finished (GObject      *source_object,
+                   GAsyncResult *result,
+                   G_GNUC_UNUSED gpointer user_data)
+{
+    ChirurgienView *view;
+    AnalysisData *analysis;
+
+    /* Cancelled analyses are superseded by a newer one, or the view is gone */
+    if (!g_task_propagate_boolean (G_TASK (result), NULL))
+        return;
+
+    view = CHIRURGIEN_VIEW (source_object);
+    analysis = g_task_get_task_data (G_TASK (result));
+
+    g_clear_object (&view->analysis_cancellable);
+    stop_analysis_progress (view);
+
+    view->field_index = g_steal_pointer (&analysis->field_index);
+    view->minimap = g_steal_pointer (&analysis->minimap);
+    view->rows_generation++;
+    view->file_description = processor_file_get_description (analysis->file);
+    /* Only whole file analyses take checkpoints */
+    if (!analysis->origin)
+        view->analysis_checkpoints = processor_file_get_checkpoints (analysis->file);
+
+    build_description (view);
+    build_navigation_buttons (view);
+
+    /* The unused data regions changed */
+    if (view->stats_page || view->stats_cancellable)
+        update_statistics (view, FALSE);
+
+    gtk_widget_queue_draw (view->file_view);
+    gtk_widget_queue_draw (view->minimap_view);
+}
+
+static void
+get_view_measures (ChirurgienView *view)
+{
+    PangoContext *context;
+    PangoFontMetrics *font_metrics;
+
+    gint bytes_per_line;
+
+    context = gtk_widget_get_pango_context (view->file_view);
+    font_metrics = pango_context_get_metrics (context, pango_context_get_font_description (context),
+                                              pango_context_get_language (context));
+
+    view->char_width =  pango_font_metrics_get_approximate_digit_width (font_metrics);
+
+    view->line_height = pango_font_metrics_get_ascent (font_metrics) +
+                        pango_font_metrics_get_descent (font_metrics);
+
+    bytes_per_line = g_settings_get_int (view->preferences_settings, "bytes-per-line");
+    if (bytes_per_line)
+    {
+        view->manual_line_length = TRUE;
+        view->line_length = bytes_per_line * 3;
+    }
+    else
+    {
+        view->manual_line_length = FALSE;
+    }
+
+    pango_font_metrics_unref (font_metrics);
+}
 
 static void
 chirurgien_view_dispose (GObject *object)
 {
     ChirurgienView *view;
-    FileField *file_field;
     FileModification *modification;
 
     view = CHIRURGIEN_VIEW (object);
 
-    gtk_widget_unparent (GTK_WIDGET (g_steal_pointer (&view->main)));
-    gtk_widget_unparent (GTK_WIDGET (g_steal_pointer (&view->status)));
+    cancel_analysis (view);
 
-    for (GSList *i = view->file_fields; i; i = i->next)
+    if (view->carving_cancellable)
     {
-        file_field = i->data;
-        g_free (file_field->field_name);
-        g_free (file_field->navigation_label);
-        g_slice_free (FileField, file_field);
+        g_cancellable_cancel (view->carving_cancellable);
+        g_clear_object (&view->carving_cancellable);
     }
-    g_slist_free (g_steal_pointer (&view->file_fields));
+
+    if (view->stats_cancellable)
+    {
+        g_cancellable_cancel (view->stats_cancellable);
+        g_clear_object (&view->stats_cancellable);
+    }
+
+    gtk_widget_unparent (GTK_WIDGET (g_steal_pointer (&view->main)));
+    gtk_widget_unparent (GTK_WIDGET (g_steal_pointer (&view->status)));
+
+    g_clear_pointer (&view->field_index, chirurgien_field_index_free);
+    g_clear_pointer (&view->minimap, chirurgien_minimap_free);
+    g_clear_pointer (&view->stats, chirurgien_stats_unref);
+    g_clear_pointer (&view->file_description, file_description_destroy);
+    g_clear_pointer (&view->analysis_checkpoints, processor_checkpoints_free);
 
     for (GList *i = view->modifications.head; i; i = i->next)
     {
@@ -1218,11 +2494,13 @@ chirurgien_view_dispose (GObject *object)
 
     g_slist_free (g_steal_pointer (&view->fields_at_mouse_index));
 
-    g_object_unref (g_steal_pointer (&view->view_layout));
+    clear_rows (view);
 
     g_free (g_steal_pointer (&view->view_buffer));
 
-    g_byte_array_unref (g_steal_pointer (&view->file_contents));
+    g_clear_pointer (&view->window_contents, g_free);
+
+    g_clear_pointer (&view->document, chirurgien_document_free);
     g_free (g_steal_pointer (&view->file_path));
 
     G_OBJECT_CLASS (chirurgien_view_parent_class)->dispose (object);
@@ -1249,6 +2527,7 @@ chirurgien_view_class_init (ChirurgienViewClass *klass)
     gtk_widget_class_bind_template_child (widget_class, ChirurgienView, overview);
     gtk_widget_class_bind_template_child (widget_class, ChirurgienView, status);
     gtk_widget_class_bind_template_child (widget_class, ChirurgienView, adjustment);
+    gtk_widget_class_bind_template_child (widget_class, ChirurgienView, minimap_view);
     gtk_widget_class_bind_template_child (widget_class, ChirurgienView, view_tab);
     gtk_widget_class_bind_template_child (widget_class, ChirurgienView, reanalyze_notice);
 }
@@ -1268,8 +2547,6 @@ chirurgien_view_init (ChirurgienView *view)
     gtk_widget_set_layout_manager (GTK_WIDGET (view),
                                    gtk_box_layout_new (GTK_ORIENTATION_VERTICAL));
 
-    view->view_layout = gtk_widget_create_pango_layout (view->file_view, NULL);
-
     g_signal_connect (view->file_view, "resize", G_CALLBACK (resize_view), view);
     g_signal_connect (view->adjustment, "value-changed", G_CALLBACK (scroll_view), view);
 
@@ -1294,12 +2571,19 @@ chirurgien_view_init (ChirurgienView *view)
     g_signal_connect (controller, "pressed", G_CALLBACK (handle_click), view);
     gtk_widget_add_controller (view->file_view, controller);
 
+    gtk_drawing_area_set_draw_func (GTK_DRAWING_AREA (view->minimap_view), draw_minimap, view, NULL);
+
+    controller = GTK_EVENT_CONTROLLER (gtk_gesture_click_new ());
+    g_signal_connect (controller, "pressed", G_CALLBACK (handle_minimap_click), view);
+    gtk_widget_add_controller (view->minimap_view, controller);
+
     g_signal_connect (view->hex_view, "toggled", G_CALLBACK (switch_view), GINT_TO_POINTER (CHIRURGIEN_HEX_VIEW));
     g_signal_connect (view->text_view, "toggled", G_CALLBACK (switch_view), GINT_TO_POINTER (CHIRURGIEN_TEXT_VIEW));
+    g_signal_connect (view->description, "switch-page", G_CALLBACK (description_page_switched), view);
 
     chirurgien_view_tab_set_view (view->view_tab, view);
 
-    view->file_contents = g_byte_array_new ();
+    view->document = chirurgien_document_new (NULL);
 
     g_queue_init (&view->modifications);
     view->modification_index = G_MAXUINT;
@@ -1307,15 +2591,39 @@ chirurgien_view_init (ChirurgienView *view)
     view->active_view = CHIRURGIEN_HEX_VIEW;
 
     view->view_buffer = NULL;
+    view->window_contents = NULL;
     view->buffer_size = 0;
 
-    view->file_fields = NULL;
+    view->field_index = NULL;
+    view->minimap = NULL;
+    view->rows = NULL;
+    view->n_rows = 0;
+    view->rows_generation = 0;
+    view->analysis_checkpoints = NULL;
+    view->edited_start = G_MAXSIZE;
+
+    view->file_description = NULL;
+
+    view->analysis_cancellable = NULL;
+    view->analysis_file = NULL;
+    view->analysis_progress_source = 0;
+    view->analysis_origin = 0;
+
+    view->carving_cancellable = NULL;
+    view->carving_page = NULL;
+
+    view->stats = NULL;
+    view->stats_cancellable = NULL;
+    view->stats_page = NULL;
+    view->stats_generation = 0;
+    view->stats_dirty_start = G_MAXSIZE;
+    view->stats_dirty_end = 0;
 
     view->current_mouse_index = G_MAXSIZE;
     view->fields_at_mouse_index = NULL;
     view->n_fields_at_mouse_index = 0;
 
-    view->navigation_target = NULL;
+    view->navigation_target = G_MAXUINT;
 
     view->has_file = FALSE;
     view->modified = FALSE;
@@ -1352,28 +2660,49 @@ void
 chirurgien_view_set_file (ChirurgienView *view,
                           GFile          *file)
 {
-    g_autoptr (GFileInputStream) file_input;
+    g_autoptr (GFileInputStream) file_input = NULL;
     g_autoptr (GFileInfo) file_info;
 
     g_autofree gchar *basename;
-    guint file_size;
+    g_autofree gchar *local_path;
+    goffset file_size;
+
+    GMappedFile *file_mapping = NULL;
+    GBytes *file_contents;
+    guchar *file_data;
 
-    file_input = g_file_read (file, NULL, NULL);
     file_info = g_file_query_info (file, G_FILE_ATTRIBUTE_STANDARD_SIZE","G_FILE_ATTRIBUTE_ACCESS_CAN_WRITE,
                                    G_FILE_QUERY_INFO_NONE, NULL, NULL);
 
-    file_size = g_file_info_get_size (file_info);
+    /* Map local files, edits never touch the mapping: the document keeps
+     * them in its own buffers */
+    local_path = g_file_get_path (file);
+    if (local_path)
+        file_mapping = g_mapped_file_new (local_path, FALSE, NULL);
+
+    if (file_mapping)
+    {
+        file_contents = g_mapped_file_get_bytes (file_mapping);
+        g_mapped_file_unref (file_mapping);
+    }
+    else
+    {
+        file_input = g_file_read (file, NULL, NULL);
+        file_size = g_file_info_get_size (file_info);
+
+        file_data = g_malloc (file_size);
 
-    /* Limit file size to 50 MiB */
-    if (file_size > 52428800)
-        file_size = 52428800;
+        g_input_stream_read_all (G_INPUT_STREAM (file_input),
+                                 file_data,
+                                 file_size,
+                                 NULL, NULL, NULL);
 
-    g_byte_array_set_size (view->file_contents, file_size);
+        file_contents = g_bytes_new_take (file_data, file_size);
+    }
 
-    g_input_stream_read_all (G_INPUT_STREAM (file_input),
-                             view->file_contents->data,
-                             view->file_contents->len,
-                             NULL, NULL, NULL);
+    chirurgien_document_free (view->document);
+    view->document = chirurgien_document_new (file_contents);
+    g_bytes_unref (file_contents);
 
     if (g_file_info_get_attribute_boolean (file_info, G_FILE_ATTRIBUTE_ACCESS_CAN_WRITE))
     {
@@ -1396,73 +2725,273 @@ chirurgien_view_set_file (ChirurgienView *view,
 void
 chirurgien_view_do_analysis (ChirurgienView *view)
 {
-    ProcessorFile *file;
+    AnalysisData *analysis;
+    GTask *task;
 
-    file = processor_file_create (view->file_contents->data,
-                                  view->file_contents->len,
-                                  view->description,
-                                  view->overview);
+    cancel_analysis (view);
 
-    chirurgien_formats_analyze (file);
+    view->analysis_cancellable = g_cancellable_new ();
 
-    view->file_fields = processor_file_get_field_list (file);
-    processor_file_destroy (file);
+    /* The analysis works on a snapshot, the view can be edited meanwhile */
+    analysis = g_slice_new (AnalysisData);
+    analysis->field_index = NULL;
+    analysis->minimap = NULL;
+    analysis->origin = view->analysis_origin;
+    analysis->document = chirurgien_document_snapshot (view->document);
+    analysis->file = processor_file_create (NULL, 0, view->analysis_cancellable);
 
-    build_navigation_buttons (view);
+    /* Checkpoints are relative to the analyzed range, only whole file analyses resume */
+    processor_file_set_checkpointed (analysis->file, !analysis->origin);
+
+    /* Resume the last analysis, it is replaced by this one */
+    if (view->analysis_checkpoints && view->field_index && view->file_description &&
+        view->edited_start != G_MAXSIZE && !view->analysis_origin)
+    {
+        processor_file_resume (analysis->file,
+                               g_steal_pointer (&view->analysis_checkpoints),
+                               chirurgien_field_index_free_to_table (g_steal_pointer (&view->field_index)),
+                               g_steal_pointer (&view->file_description),
+                               view->edited_start,
+                               view->edited_end,
+                               view->edited_resize);
+    }
+    else
+    {
+        g_clear_pointer (&view->field_index, chirurgien_field_index_free);
+        g_clear_pointer (&view->file_description, file_description_destroy);
+        g_clear_pointer (&view->analysis_checkpoints, processor_checkpoints_free);
+    }
+    g_clear_pointer (&view->minimap, chirurgien_minimap_free);
+    gtk_widget_queue_draw (view->minimap_view);
+
+    /* The rows lose their highlighting until the analysis finishes */
+    view->rows_generation++;
+
+    view->edited_start = G_MAXSIZE;
+    view->edited_end = 0;
+    view->edited_resize = FALSE;
+
+    task = g_task_new (view, view->analysis_cancellable, analysis_finished, NULL);
+    g_task_set_task_data (task, analysis, analysis_data_destroy);
+    g_task_run_in_thread (task, analyze_file);
+    g_object_unref (task);
+
+    view->analysis_file = analysis->file;
+    view->analysis_progress_source = g_timeout_add (100, report_analysis_progress, view);
 }
 
-void
-chirurgien_view_redo_analysis (ChirurgienView *view)
+/* Analyzes the file from origin, the whole file if 0 */
+static void
+analyze_from (ChirurgienView *view,
+              gsize           origin)
 {
-    GtkWidget *child_widget;
-    gint description_pages;
+    view->analysis_origin = origin;
 
-    if (!view->modified)
+    clear_analysis (view);
+
+    chirurgien_view_do_analysis (view);
+
+    view->modified = FALSE;
+    chirurgien_view_tab_set_modified (view->view_tab, FALSE);
+    gtk_revealer_set_reveal_child (view->reanalyze_notice, FALSE);
+
+    gtk_widget_queue_draw (view->file_view);
+}
+
+static void
+analyze_embedded_format (GtkButton *button,
+                         gpointer   user_data)
+{
+    gsize *origin;
+
+    origin = g_object_get_data (G_OBJECT (button), "origin");
+
+    analyze_from (user_data, origin ? *origin : 0);
+}
+
+static void
+carving_data_destroy (gpointer data)
+{
+    CarvingData *carving;
+
+    carving = data;
+
+    if (carving->contents)
+        processor_file_destroy (carving->contents);
+    chirurgien_document_free (carving->document);
+    if (carving->embedded_formats)
+        g_array_unref (carving->embedded_formats);
+
+    g_slice_free (CarvingData, carving);
+}
+
+static void
+carve_file (GTask        *task,
+            G_GNUC_UNUSED gpointer      source_object,
+            gpointer      task_data,
+            GCancellable *cancellable)
+{
+    CarvingData *carving;
+
+    carving = task_data;
+
+    carving->contents = processor_file_create (NULL, 0, NULL);
+    set_file_chunks (carving->contents, carving->document, 0);
+
+    carving->embedded_formats = chirurgien_formats_carve (carving->contents, cancellable);
+
+    g_task_return_boolean (task, !g_cancellable_is_cancelled (cancellable));
+}
+
+/* Lists the embedded formats in the 'Embedded formats' page, each can be analyzed in place */
+static void
+carving_finished (GObject      *source_object,
+                  GAsyncResult *result,
+                  G_GNUC_UNUSED gpointer user_data)
+{
+    ChirurgienView *view;
+    CarvingData *carving;
+    const EmbeddedFormat *embedded_format;
+
+    GtkWidget *contents, *expander, *grid, *left_label, *right_label, *button;
+
+    g_autofree gchar *offset_text = NULL;
+    gsize *origin;
+
+    if (!g_task_propagate_boolean (G_TASK (result), NULL))
         return;
 
-    for (GSList *i = view->file_fields; i; i = i->next)
-        g_slice_free (FileField, i->data);
-    g_slist_free (g_steal_pointer (&view->file_fields));
+    view = CHIRURGIEN_VIEW (source_object);
+    carving = g_task_get_task_data (G_TASK (result));
 
-    g_slist_free (g_steal_pointer (&view->fields_at_mouse_index));
+    g_clear_object (&view->carving_cancellable);
 
-    view->current_mouse_index = G_MAXSIZE;
-    view->n_fields_at_mouse_index = 0;
+    contents = create_page_contents ();
+    gtk_box_append (GTK_BOX (contents), create_title_label (_("Embedded formats")));
 
-    view->selected_field = NULL;
+    if (carving->embedded_formats->len)
+    {
+        create_section (&expander, &grid, _("Formats found"));
+        gtk_box_append (GTK_BOX (contents), expander);
 
-    for (child_widget = gtk_widget_get_first_child (GTK_WIDGET (view->navigation));
-         child_widget;
-         child_widget = gtk_widget_get_first_child (GTK_WIDGET (view->navigation)))
-        gtk_widget_unparent (child_widget);
+        for (guint i = 0; i < carving->embedded_formats->len; i++)
+        {
+            embedded_format = &g_array_index (carving->embedded_formats, EmbeddedFormat, i);
 
-    for (child_widget = gtk_widget_get_first_child (GTK_WIDGET (view->overview));
-         child_widget;
-         child_widget = gtk_widget_get_first_child (GTK_WIDGET (view->overview)))
-        gtk_widget_unparent (child_widget);
+            g_free (offset_text);
+            offset_text = g_strdup_printf ("0x%lX", embedded_format->offset);
 
-    description_pages = gtk_notebook_get_n_pages (view->description);
+            create_line_labels (&left_label, &right_label,
+                                offset_text, embedded_format->format_name, NULL,
+                                0, 0);
 
-    while (--description_pages)
-        gtk_notebook_remove_page (view->description, -1);
+            button = gtk_button_new_with_label (_("Analyze"));
+            gtk_widget_set_tooltip_text (button, _("Analyze the file from this offset"));
+            gtk_widget_set_valign (button, GTK_ALIGN_CENTER);
 
-    chirurgien_view_do_analysis (view);
+            origin = g_new (gsize, 1);
+            *origin = embedded_format->offset;
+            g_object_set_data_full (G_OBJECT (button), "origin", origin, g_free);
+            g_signal_connect (button, "clicked", G_CALLBACK (analyze_embedded_format), view);
 
-    view->modified = FALSE;
-    chirurgien_view_tab_set_modified (view->view_tab, FALSE);
-    gtk_revealer_set_reveal_child (view->reanalyze_notice, FALSE);
+            gtk_grid_attach (GTK_GRID (grid), left_label, 0, i, 1, 1);
+            gtk_grid_attach_next_to (GTK_GRID (grid), right_label, left_label, GTK_POS_RIGHT, 1, 1);
+            gtk_grid_attach_next_to (GTK_GRID (grid), button, right_label, GTK_POS_RIGHT, 1, 1);
+        }
+    }
+    else
+    {
+        gtk_box_append (GTK_BOX (contents), create_note_label (_("No embedded formats found")));
+    }
 
-    gtk_widget_queue_draw (view->file_view);
+    button = gtk_button_new_with_label (_("Analyze the whole file"));
+    gtk_widget_set_halign (button, GTK_ALIGN_CENTER);
+    g_signal_connect (button, "clicked", G_CALLBACK (analyze_embedded_format), view);
+    gtk_box_append (GTK_BOX (contents), button);
+
+    if (view->carving_page)
+        gtk_notebook_remove_page (view->description,
+                                  gtk_notebook_page_num (view->description, view->carving_page));
+
+    view->carving_page = gtk_scrolled_window_new ();
+    gtk_scrolled_window_set_child (GTK_SCROLLED_WINDOW (view->carving_page), contents);
+
+    gtk_notebook_insert_page (view->description, view->carving_page,
+                              gtk_label_new (_("Embedded formats")), 1);
+    gtk_notebook_set_current_page (view->description, 1);
+}
+
+void
+chirurgien_view_carve (ChirurgienView *view)
+{
+    CarvingData *carving;
+    GTask *task;
+
+    if (view->carving_cancellable)
+        g_cancellable_cancel (view->carving_cancellable);
+    g_clear_object (&view->carving_cancellable);
+
+    view->carving_cancellable = g_cancellable_new ();
+
+    carving = g_slice_new0 (CarvingData);
+    carving->document = chirurgien_document_snapshot (view->document);
+
+    task = g_task_new (view, view->carving_cancellable, carving_finished, NULL);
+    g_task_set_task_data (task, carving, carving_data_destroy);
+    g_task_run_in_thread (task, carve_file);
+    g_object_unref (task);
+}
+
+void
+chirurgien_view_statistics (ChirurgienView *view)
+{
+    update_statistics (view, TRUE);
+}
+
+void
+chirurgien_view_redo_analysis (ChirurgienView *view)
+{
+    if (!view->modified)
+        return;
+
+    analyze_from (view, view->analysis_origin);
+}
+
+/*
+ * Writes the document, one piece at a time
+ * The pieces can be mapped from the file being replaced: it is written to
+ * a temporary file and renamed, never overwritten in place
+ */
+static gboolean
+write_document (ChirurgienDocument *document,
+                GFile              *file)
+{
+    g_autoptr (GFileOutputStream) file_output = NULL;
+    ChirurgienDocumentCursor cursor;
+
+    file_output = g_file_replace (file, NULL, FALSE, G_FILE_CREATE_REPLACE_DESTINATION, NULL, NULL);
+    if (!file_output)
+        return FALSE;
+
+    for (chirurgien_document_cursor_init (&cursor, document, 0);
+         cursor.chunk;
+         chirurgien_document_cursor_next (&cursor))
+    {
+        if (!g_output_stream_write_all (G_OUTPUT_STREAM (file_output),
+                                        cursor.chunk,
+                                        cursor.chunk_length,
+                                        NULL, NULL, NULL))
+            return FALSE;
+    }
+
+    return g_output_stream_close (G_OUTPUT_STREAM (file_output), NULL, NULL);
 }
 
 gboolean
 chirurgien_view_save (ChirurgienView *view,
                       GFile          *file)
 {
-    if (g_file_replace_contents (file,
-                                (const gchar *) view->file_contents->data,
-                                 view->file_contents->len,
-                                 NULL, FALSE, G_FILE_CREATE_NONE, NULL, NULL, NULL))
+    if (write_document (view->document, file))
     {
         g_free (view->file_path);
         view->file_path = g_file_get_path (file);
@@ -1484,53 +3013,79 @@ chirurgien_view_save (ChirurgienView *view,
     return FALSE;
 }
 
+/* Widens the range edited since the last analysis and statistics */
+static void
+mark_edited (ChirurgienView   *view,
+             FileModification *modification)
+{
+    view->edited_start = MIN (view->edited_start, modification->offset);
+    view->edited_end = MAX (view->edited_end, modification->offset + modification->length);
+
+    if (modification->type != FIELD_EDITION)
+        view->edited_resize = TRUE;
+
+    view->stats_dirty_start = MIN (view->stats_dirty_start, modification->offset);
+    if (modification->type != FIELD_EDITION)
+        view->stats_dirty_end = G_MAXSIZE;
+    else
+        view->stats_dirty_end = MAX (view->stats_dirty_end, modification->offset + modification->length);
+
+    view->stats_generation++;
+}
+
+/* Edits are stored as the XOR of the old and new contents, applying them twice restores the field */
+static void
+apply_field_edition (ChirurgienView   *view,
+                     FileModification *modification)
+{
+    g_autofree guchar *contents = NULL;
+
+    contents = g_malloc (modification->length);
+    chirurgien_document_read (view->document,
+                              modification->offset,
+                              modification->length,
+                              contents);
+
+    for (gsize i = 0; i < modification->length; i++)
+        contents[i] ^= modification->data[i];
+
+    chirurgien_document_replace (view->document,
+                                 modification->offset,
+                                 contents,
+                                 modification->length);
+}
+
 void
 chirurgien_view_undo (ChirurgienView *view)
 {
     FileModification *modification;
-    guchar *contents;
 
-    GByteArray *new_file_contents;
     gboolean force_reanalysis = FALSE;
 
     if (view->modification_index == G_MAXUINT)
         return;
 
     modification = g_queue_peek_nth (&view->modifications, view->modification_index);
+    mark_edited (view, modification);
 
     if (modification->type == FIELD_EDITION)
     {
-        contents = view->file_contents->data + modification->offset;
-
-        for (gsize i = 0; i < modification->length; i++)
-            contents[i] ^= modification->data[i];
+        apply_field_edition (view, modification);
     }
     else if (modification->type == FIELD_DELETION)
     {
-        new_file_contents = g_byte_array_sized_new (view->file_contents->len +
-                                                    modification->length);
-        g_byte_array_append (new_file_contents,
-                             view->file_contents->data,
-                             modification->offset);
-        g_byte_array_append (new_file_contents,
-                             modification->data,
-                             modification->length);
-        g_byte_array_append (new_file_contents,
-                             view->file_contents->data +
-                             modification->offset,
-                             view->file_contents->len -
-                             modification->offset);
-
-        g_byte_array_unref (view->file_contents);
-        view->file_contents = new_file_contents;
+        chirurgien_document_insert (view->document,
+                                    modification->offset,
+                                    modification->data,
+                                    modification->length);
 
         force_reanalysis = TRUE;
     }
     else if (modification->type == FIELD_INSERTION)
     {
-        g_byte_array_remove_range (view->file_contents,
-                                   modification->offset,
-                                   modification->length);
+        chirurgien_document_delete (view->document,
+                                    modification->offset,
+                                    modification->length);
 
         force_reanalysis = TRUE;
     }
@@ -1538,60 +3093,50 @@ chirurgien_view_undo (ChirurgienView *view)
     view->modification_index--;
 
     file_modified (view, force_reanalysis);
+
+    if (view->stats_page || view->stats_cancellable)
+        update_statistics (view, FALSE);
 }
 
 void
 chirurgien_view_redo (ChirurgienView *view)
 {
     FileModification *modification;
-    guchar *contents;
 
-    GByteArray *new_file_contents;
     gboolean force_reanalysis = FALSE;
 
     if (view->modification_index == view->modifications.length - 1)
         return;
 
     modification = g_queue_peek_nth (&view->modifications, ++view->modification_index);
+    mark_edited (view, modification);
 
     if (modification->type == FIELD_EDITION)
     {
-        contents = view->file_contents->data + modification->offset;
-
-        for (gsize i = 0; i < modification->length; i++)
-            contents[i] ^= modification->data[i];
+        apply_field_edition (view, modification);
     }
     else if (modification->type == FIELD_DELETION)
     {
-        g_byte_array_remove_range (view->file_contents,
-                                   modification->offset,
-                                   modification->length);
+        chirurgien_document_delete (view->document,
+                                    modification->offset,
+                                    modification->length);
 
         force_reanalysis = TRUE;
     }
     else if (modification->type == FIELD_INSERTION)
     {
-        new_file_contents = g_byte_array_sized_new (view->file_contents->len +
-                                                    modification->length);
-        g_byte_array_append (new_file_contents,
-                             view->file_contents->data,
-                             modification->offset);
-        g_byte_array_append (new_file_contents,
-                             modification->data,
-                             modification->length);
-        g_byte_array_append (new_file_contents,
-                             view->file_contents->data +
-                             modification->offset,
-                             view->file_contents->len -
-                             modification->offset);
-
-        g_byte_array_unref (view->file_contents);
-        view->file_contents = new_file_contents;
+        chirurgien_document_insert (view->document,
+                                    modification->offset,
+                                    modification->data,
+                                    modification->length);
 
         force_reanalysis = TRUE;
     }
 
     file_modified (view, force_reanalysis);
+
+    if (view->stats_page || view->stats_cancellable)
+        update_statistics (view, FALSE);
 }
 
 void
@@ -1635,6 +3180,8 @@ void
 chirurgien_view_refresh (ChirurgienView *view)
 {
     get_view_measures (view);
+    /* The font may have changed */
+    clear_rows (view);
 
     gtk_widget_queue_resize (view->file_view);
     gtk_widget_queue_draw (view->file_view);
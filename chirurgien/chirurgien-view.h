@@ -35,6 +35,8 @@ void                 chirurgien_view_set_file                     (ChirurgienVie
 
 void                 chirurgien_view_do_analysis                  (ChirurgienView *);
 void                 chirurgien_view_redo_analysis                (ChirurgienView *);
+void                 chirurgien_view_carve                        (ChirurgienView *);
+void                 chirurgien_view_statistics                   (ChirurgienView *);
 
 void                 chirurgien_view_select_view                  (ChirurgienView *,
                                                                    ChirurgienViewType);
@@ -54,6 +54,8 @@ static GActionEntry win_entries[] =
     { "save-as", chirurgien_actions_save, NULL, NULL, NULL },
     { "close-tab", chirurgien_actions_close, NULL, NULL, NULL },
     { "reanalyze", chirurgien_actions_reanalyze, NULL, NULL, NULL },
+    { "carve", chirurgien_actions_carve, NULL, NULL, NULL },
+    { "statistics", chirurgien_actions_statistics, NULL, NULL, NULL },
     { "hex-view", chirurgien_actions_hex_view, NULL, NULL, NULL },
     { "text-view", chirurgien_actions_text_view, NULL, NULL, NULL },
     { "undo", chirurgien_actions_undo, NULL, NULL, NULL },
@@ -373,13 +375,15 @@ static void
 toggle_view_actions (ChirurgienWindow *window,
                      gboolean          enable)
 {
-    GAction *save_action, *save_as_action, *close_tab_action, *reanalyze_action,
-            *hex_view_action, *text_view_action, *next_tab_action, *prev_tab_action;
+    GAction *save_action, *save_as_action, *close_tab_action, *reanalyze_action, *carve_action,
+            *statistics_action, *hex_view_action, *text_view_action, *next_tab_action, *prev_tab_action;
 
     save_action = g_action_map_lookup_action (G_ACTION_MAP (window), "save");
     save_as_action = g_action_map_lookup_action (G_ACTION_MAP (window), "save-as");
     close_tab_action = g_action_map_lookup_action (G_ACTION_MAP (window), "close-tab");
     reanalyze_action = g_action_map_lookup_action (G_ACTION_MAP (window), "reanalyze");
+    carve_action = g_action_map_lookup_action (G_ACTION_MAP (window), "carve");
+    statistics_action = g_action_map_lookup_action (G_ACTION_MAP (window), "statistics");
     hex_view_action = g_action_map_lookup_action (G_ACTION_MAP (window), "hex-view");
     text_view_action = g_action_map_lookup_action (G_ACTION_MAP (window), "text-view");
     next_tab_action = g_action_map_lookup_action (G_ACTION_MAP (window), "next-tab");
@@ -391,6 +395,8 @@ toggle_view_actions (ChirurgienWindow *window,
         g_simple_action_set_enabled (G_SIMPLE_ACTION (save_as_action), TRUE);
         g_simple_action_set_enabled (G_SIMPLE_ACTION (close_tab_action), TRUE);
         g_simple_action_set_enabled (G_SIMPLE_ACTION (reanalyze_action), TRUE);
+        g_simple_action_set_enabled (G_SIMPLE_ACTION (carve_action), TRUE);
+        g_simple_action_set_enabled (G_SIMPLE_ACTION (statistics_action), TRUE);
         g_simple_action_set_enabled (G_SIMPLE_ACTION (hex_view_action), TRUE);
         g_simple_action_set_enabled (G_SIMPLE_ACTION (text_view_action), TRUE);
         g_simple_action_set_enabled (G_SIMPLE_ACTION (next_tab_action), TRUE);
@@ -402,6 +408,8 @@ toggle_view_actions (ChirurgienWindow *window,
         g_simple_action_set_enabled (G_SIMPLE_ACTION (save_as_action), FALSE);
         g_simple_action_set_enabled (G_SIMPLE_ACTION (close_tab_action), FALSE);
         g_simple_action_set_enabled (G_SIMPLE_ACTION (reanalyze_action), FALSE);
+        g_simple_action_set_enabled (G_SIMPLE_ACTION (carve_action), FALSE);
+        g_simple_action_set_enabled (G_SIMPLE_ACTION (statistics_action), FALSE);
         g_simple_action_set_enabled (G_SIMPLE_ACTION (hex_view_action), FALSE);
         g_simple_action_set_enabled (G_SIMPLE_ACTION (text_view_action), FALSE);
         g_simple_action_set_enabled (G_SIMPLE_ACTION (next_tab_action), FALSE);
@@ -652,6 +660,7 @@ chirurgien_window_init (ChirurgienWindow *window)
 
         g_free (color_string);
     }
+    pango_colors_generation++;
 }
 
 /*** Public API ***/
@@ -0,0 +1,35 @@
+/* chirurgien-formats-globals.h
+ *
+ * Copyright (C) 2021 - Daniel Léonard Schardijn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+#define CHIRURGIEN_TOTAL_COLORS 9
+
+extern const gchar * const hex_chars;
+
+/* Format definitions are read-only once validated,
+ * they can be shared by concurrent analyses */
+extern GSList    *chirurgien_system_format_definitions;
+
+extern GList     *chirurgien_user_format_definitions;
+
+G_END_DECLS
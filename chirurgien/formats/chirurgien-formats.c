@@ -16,106 +16,228 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
-#include <chirurgien-globals.h>
+#include <chirurgien-formats-globals.h>
 #include "chirurgien-formats.h"
 
 #include "chirurgien-types.h"
+#include "chirurgien-formats-resources.h"
 
 #include "validator/chirurgien-validator.h"
 #include "processor/chirurgien-processor.h"
 
 
+/* The format dispatch index, rebuilt when the format lists change */
+static ProcessorDispatch *format_dispatch = NULL;
+static GMutex format_dispatch_lock;
+
+
+/*
+ * Identifies the format of the file, returns NULL if the format is unrecognized
+ * The format definition remains valid while the file references it: until the file
+ * is identified or processed as another format, or destroyed
+ */
+const FormatDefinition *
+chirurgien_formats_identify (ProcessorFile *file)
+{
+    const FormatDefinition *format_definition;
+    ProcessorDispatch *dispatch;
+
+    g_mutex_lock (&format_dispatch_lock);
+    dispatch = format_dispatch ? processor_dispatch_ref (format_dispatch) : NULL;
+    g_mutex_unlock (&format_dispatch_lock);
+
+    format_definition = dispatch ? processor_dispatch_identify (dispatch, file) : NULL;
+
+    /* Referenced by the file before the dispatch is released */
+    processor_file_set_format (file, format_definition);
+
+    processor_dispatch_unref (dispatch);
+
+    return format_definition;
+}
+
+/*
+ * Processes the file as the format, into its field table and description
+ * A NULL format describes the file as unrecognized
+ */
 void
+chirurgien_formats_process (const FormatDefinition *format_definition,
+                            ProcessorFile          *file)
+{
+    if (format_definition)
+        format_complete ((FormatDefinition *) format_definition);
+
+    format_process (format_definition, file);
+}
+
+/*
+ * Analyzes the file, returns the name of the identified format,
+ * NULL if the format is unrecognized
+ */
+const gchar *
 chirurgien_formats_analyze (ProcessorFile *file)
 {
     const FormatDefinition *format_definition;
 
-    gboolean format_found;
+    format_definition = chirurgien_formats_identify (file);
+    chirurgien_formats_process (format_definition, file);
 
-    format_found = FALSE;
+    return chirurgien_formats_get_name (format_definition);
+}
 
-    for (GSList *format_iter = chirurgien_system_format_definitions;
-         format_iter && !format_found;
-         format_iter = format_iter->next)
-    {
-        format_definition = format_iter->data;
+const gchar *
+chirurgien_formats_get_name (const FormatDefinition *format_definition)
+{
+    return format_definition ? format_definition->format_name : NULL;
+}
 
-        if (!format_definition->disabled)
-            format_found = format_identify (format_definition, file);
-    }
+/*
+ * Finds the formats embedded in the contents of a file created with processor_file_create (),
+ * returns a GArray of EmbeddedFormats
+ */
+GArray *
+chirurgien_formats_carve (ProcessorFile *contents,
+                          GCancellable  *cancellable)
+{
+    ProcessorDispatch *dispatch;
+    GArray *embedded_formats;
 
-    if (!format_found)
-    {
-        for (GList *format_iter = chirurgien_user_format_definitions;
-             format_iter && !format_found;
-             format_iter = format_iter->next)
-        {
-            format_definition = format_iter->data;
+    g_mutex_lock (&format_dispatch_lock);
+    dispatch = format_dispatch ? processor_dispatch_ref (format_dispatch) : NULL;
+    g_mutex_unlock (&format_dispatch_lock);
 
-            format_found = format_identify (format_definition, file);
-        }
-    }
+    if (!dispatch)
+        return g_array_new (FALSE, FALSE, sizeof (EmbeddedFormat));
 
-    if (!format_found)
-        format_definition = NULL;
+    embedded_formats = processor_dispatch_carve (dispatch, contents, cancellable);
 
-    format_process (format_definition, file);
+    processor_dispatch_unref (dispatch);
+
+    return embedded_formats;
 }
 
+/*
+ * Rebuilds the format dispatch index, must be called after
+ * the system or user format lists change
+ */
 void
-chirurgien_formats_initialize (const gchar *format_definition_path)
+chirurgien_formats_update (void)
 {
-    FormatDefinition *format_definition;
+    ProcessorDispatch *dispatch, *previous_dispatch;
 
+    dispatch = processor_dispatch_new (chirurgien_system_format_definitions,
+                                       chirurgien_user_format_definitions);
+
+    g_mutex_lock (&format_dispatch_lock);
+    previous_dispatch = format_dispatch;
+    format_dispatch = dispatch;
+    g_mutex_unlock (&format_dispatch_lock);
+
+    processor_dispatch_unref (previous_dispatch);
+}
+
+/* The system format definitions, embedded as resources */
+static const gchar * const system_format_definitions[] =
+{
+    "/io/github/leonardschardijn/chirurgien/format-definitions/cpio-format.xml",
+    "/io/github/leonardschardijn/chirurgien/format-definitions/elf-format.xml",
+    "/io/github/leonardschardijn/chirurgien/format-definitions/gif-format.xml",
+    "/io/github/leonardschardijn/chirurgien/format-definitions/jpeg-format.xml",
+    "/io/github/leonardschardijn/chirurgien/format-definitions/pe-format.xml",
+    "/io/github/leonardschardijn/chirurgien/format-definitions/png-format.xml",
+    "/io/github/leonardschardijn/chirurgien/format-definitions/tar-format.xml",
+    "/io/github/leonardschardijn/chirurgien/format-definitions/tiff-format.xml",
+    "/io/github/leonardschardijn/chirurgien/format-definitions/webp-format.xml"
+};
+
+/* The system format definitions resource is registered when first needed */
+static void
+formats_register_resource (void)
+{
+    static gsize registered = 0;
+
+    if (g_once_init_enter (&registered))
+    {
+        chirurgien_formats_register_resource ();
+        g_once_init_leave (&registered, 1);
+    }
+}
+
+static void
+formats_add_system (const gchar *format_definition_path)
+{
+    FormatDefinition *format_definition;
     GBytes *format_definition_bytes;
-    const gchar *format_definition_text;
-    gsize format_definition_size;
+
+    formats_register_resource ();
 
     format_definition_bytes = g_resources_lookup_data (format_definition_path,
                                                        G_RESOURCE_LOOKUP_FLAGS_NONE,
                                                        NULL);
 
-    format_definition_text = g_bytes_get_data (format_definition_bytes,
-                                               &format_definition_size);
-
-    format_definition = format_validate (format_definition_text,
-                                         format_definition_size,
-                                         NULL);
+    format_definition = format_validate_header (format_definition_bytes, NULL);
     chirurgien_system_format_definitions = g_slist_append (chirurgien_system_format_definitions,
                                                            format_definition);
 
     g_bytes_unref (format_definition_bytes);
 }
 
+/*
+ * Loads a system format definition, only what identifies the format
+ * is validated until a file is identified as the format
+ */
+void
+chirurgien_formats_initialize (const gchar *format_definition_path)
+{
+    formats_add_system (format_definition_path);
+    chirurgien_formats_update ();
+}
+
+/* Loads all the system format definitions, the dispatch index is built once */
+void
+chirurgien_formats_initialize_system (void)
+{
+    for (guint i = 0; i < G_N_ELEMENTS (system_format_definitions); i++)
+        formats_add_system (system_format_definitions[i]);
+
+    chirurgien_formats_update ();
+}
+
+/*
+ * Loads a user format definition
+ * Returns the I/O or validation error message, or NULL if it was loaded
+ */
 gchar *
 chirurgien_formats_load (GFile *file)
 {
-    FormatDefinition *format_definition;
+    FormatDefinition *format_definition = NULL;
 
-    g_autoptr (GFileInputStream) file_input;
-    g_autoptr (GFileInfo) file_info;
+    g_autoptr (GFileInputStream) file_input = NULL;
+    g_autoptr (GFileInfo) file_info = NULL;
 
-    g_autofree gchar *format_definition_text;
-    gsize format_definition_size;
+    g_autofree gchar *format_definition_text = NULL;
+    gsize format_definition_size, bytes_read;
 
     GError *error = NULL;
     gchar *error_message = NULL;
 
-    file_input = g_file_read (file, NULL, NULL);
-    file_info = g_file_query_info (file, G_FILE_ATTRIBUTE_STANDARD_SIZE,
-                                   G_FILE_QUERY_INFO_NONE, NULL, NULL);
-
-    format_definition_size = g_file_info_get_size (file_info);
-    format_definition_text = g_malloc (format_definition_size);
-
-    g_input_stream_read_all (G_INPUT_STREAM (file_input),
-                             format_definition_text,
-                             format_definition_size,
-                             NULL, NULL, NULL);
+    if ((file_input = g_file_read (file, NULL, &error)) &&
+        (file_info = g_file_query_info (file, G_FILE_ATTRIBUTE_STANDARD_SIZE,
+                                        G_FILE_QUERY_INFO_NONE, NULL, &error)))
+    {
+        format_definition_size = g_file_info_get_size (file_info);
+        format_definition_text = g_malloc (format_definition_size);
 
-    format_definition = format_validate (format_definition_text,
-                                         format_definition_size,
-                                         &error);
+        if (g_input_stream_read_all (G_INPUT_STREAM (file_input),
+                                     format_definition_text,
+                                     format_definition_size,
+                                     &bytes_read, NULL, &error))
+        {
+            format_definition = format_validate (format_definition_text,
+                                                 bytes_read,
+                                                 &error);
+        }
+    }
 
     if (error)
     {
@@ -126,6 +248,7 @@ chirurgien_formats_load (GFile *file)
     {
         chirurgien_user_format_definitions = g_list_append (chirurgien_user_format_definitions,
                                                             format_definition);
+        chirurgien_formats_update ();
     }
 
     return error_message;
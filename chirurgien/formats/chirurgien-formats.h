@@ -20,14 +20,43 @@
 
 #include <glib.h>
 
+#include "chirurgien-types.h"
 #include "processor/processor-file.h"
 
 G_BEGIN_DECLS
 
-void    chirurgien_formats_analyze       (ProcessorFile *);
+/*
+ * The format engine API, GLib is its only dependency:
+ *  - Load the format definitions: chirurgien_formats_initialize_system (), chirurgien_formats_load ()
+ *  - Analyze a file created with processor_file_create (), its contents in a single buffer
+ *    or appended in chunks with processor_file_append_chunk ():
+ *    chirurgien_formats_identify () and chirurgien_formats_process (), or chirurgien_formats_analyze ()
+ *  - Iterate the results: processor_file_get_fields () and field_table_get_field (),
+ *    processor_file_get_description () and file_description_get_page ()
+ */
+
+const FormatDefinition *
+            chirurgien_formats_identify      (ProcessorFile *);
+
+void        chirurgien_formats_process       (const FormatDefinition *,
+                                              ProcessorFile *);
+
+const gchar *
+            chirurgien_formats_analyze       (ProcessorFile *);
+
+const gchar *
+            chirurgien_formats_get_name      (const FormatDefinition *);
+
+GArray *    chirurgien_formats_carve         (ProcessorFile *,
+                                              GCancellable *);
+
+void        chirurgien_formats_initialize    (const gchar *);
+
+void        chirurgien_formats_initialize_system
+                                             (void);
 
-void    chirurgien_formats_initialize    (const gchar *);
+void        chirurgien_formats_update        (void);
 
-gchar * chirurgien_formats_load          (GFile *);
+gchar *     chirurgien_formats_load          (GFile *);
 
 G_END_DECLS
@@ -54,10 +54,21 @@ typedef enum
     LOOP_END_STEP,
     PRINT_STEP,
     EXEC_STEP,
-    BLOCK_STEP
+    BLOCK_STEP,
+    END_STEP
 
 } RunStepType;
 
+/* Operand types */
+typedef enum
+{
+    OPERAND_NONE = 0,
+    OPERAND_IMMEDIATE,
+    OPERAND_VARIABLE,
+    OPERAND_INDEX
+
+} OperandType;
+
 /* Match step operations */
 typedef enum
 {
@@ -105,52 +116,22 @@ typedef enum
 
 /*** Structures ***/
 
-/* A format definition
- * The in-memory representation of an XML definition */
+/* A step operand, resolved by the validator
+ * Every stored variable name is interned into a slot, an index into the
+ * processor's variable array, any other value is parsed once as a number */
 typedef struct
 {
-    /* Format disabled, indicates that the format should not be used */
-    gboolean         disabled;
-
-    /* The format's name */
-    gchar           *format_name;
-    /* The format's short name */
-    gchar           *short_format_name;
-
-    /* Format description/details */
-    gchar           *details;
-
-    /* Format endianness */
-    Endianness       endianness;
-    /* Variable name of the variable holding the endianness value */
-    gchar           *endianness_var;
-    /* Value that indicates big-endian */
-    gpointer         be_value;
-    gsize            be_value_size;
-    /* Value that indicates little-endian */
-    gpointer         le_value;
-    gsize            le_value_size;
+    /* The operand's type */
+    OperandType      type;
 
-    /* List of Lists of MagicSteps
-     * Used to identify the file format */
-    GSList          *magic;
+    /* The variable's slot (OPERAND_VARIABLE) */
+    guint            slot;
 
-    /* Associative array of FormatColors
-     * A collection of all colors used by the format */
-    GHashTable      *colors;
-
-    /* List of RunSteps
-     * Used to analyze the file format */
-    GSList          *run;
-
-    /* Associative array of reusable blocks of RunSteps */
-    GHashTable      *blocks;
+    /* The operand's numeric value (OPERAND_IMMEDIATE),
+     * also used if the variable is undefined (OPERAND_VARIABLE) */
+    guint64          immediate;
 
-    /* Associative array of FieldDefinitions
-     * A collection of all possible fields in the format */
-    GHashTable      *fields;
-
-} FormatDefinition;
+} Operand;
 
 /* Possible MagicStep payloads */
 
@@ -164,6 +145,7 @@ typedef struct
 
     /* The step's offset */
     gchar           *offset;
+    Operand          offset_op;
 
 } MatchMStep;
 
@@ -177,6 +159,10 @@ typedef struct
 
     /* The step's offset */
     gchar           *offset;
+    Operand          offset_op;
+
+    /* The variable's slot */
+    guint            var_slot;
 
 } ReadMStep;
 
@@ -208,6 +194,77 @@ typedef struct
 
 } FormatColor;
 
+/* A field option definition */
+typedef struct
+{
+    /* The option's name */
+    gchar           *name;
+    /* The option's value */
+    gpointer         value;
+
+} FieldDefinitionOption;
+
+/* A field flag definition */
+typedef struct
+{
+    /* The flag's name */
+    gchar           *name;
+    /* The flag's mask */
+    guint64          mask;
+
+    /* The flag's meaning */
+    gchar           *meaning;
+
+} FieldDefinitionFlag;
+
+/* A field definition */
+typedef struct
+{
+    /* Field name */
+    gchar           *name;
+    /* Field tag
+     * Used in the Hex/Text view of a file
+     * If unset, the field's name is used */
+    gchar           *tag;
+
+    /* The field's tooltip
+     * Used if the field is printed to the description panel */
+    gchar           *tooltip;
+    /* Should the tooltip be automatically generated */
+    gboolean         auto_tooltip;
+
+    /* The field's color */
+    gchar           *color;
+    FormatColor     *color_def;
+
+    /* The field's size type */
+    FieldSizeType    size_type;
+    /* The field's fixed size */
+    gsize            size;
+    /* The byte value used to find the field's size */
+    guchar           value;
+
+    /* The field's mask, if the field covers only a selection of bits */
+    guint64          mask;
+    /* The field's left shift */
+    guint            shift;
+
+    /* How the field should be printed to the description panel
+     * (should this field be printed) */
+    FieldPrintType   print;
+    /* The string to print (PRINT_LITERAL) */
+    gchar           *print_literal;
+    /* Field encoding (only used in text fields, PRINT_TEXT) */
+    TextEncoding     encoding;
+
+    /* For fields with fixed values: a list of FieldDefinitionOptions
+     * For flags fields: a list of FieldDefinitionFlags */
+    GSList          *value_collection;
+    /* Format endianness should be taken into account when matching values */
+    gboolean         convert_endianness;
+
+} FieldDefinition;
+
 /* Possible RunStep payloads */
 
 /* A field RunStep */
@@ -215,10 +272,13 @@ typedef struct
 {
     /* Field ID */
     gchar           *field_id;
+    /* The field's definition, NULL if undefined */
+    FieldDefinition *field_def;
 
     /* The name of the variable
      * Store the value of the field, so it can be accessed later */
     gchar           *store_var;
+    guint            store_var_slot;
     /* The stored value should be converted to the format's endianness */
     gboolean         convert_endianness;
     /* The stored value is an ASCII-encoded number with the specified base (2..36) */
@@ -226,15 +286,18 @@ typedef struct
 
     /* The navigation label, if this field produces one */
     gchar           *navigation;
+    Operand          navigation_op;
     /* The navigation string max. size,
      * if the navigation label is a variable holding an offset */
     guint            navigation_limit;
 
     /* The field's offset value, a variable name with the field's offset */
     gchar           *offset;
+    Operand          offset_op;
     /* The field's additional color,
      * helps identify fields that were created with an offset */
     gchar           *additional_color;
+    FormatColor     *additional_color_def;
 
     /* The description tab, if this fields should be added to a tab */
     gchar           *tab;
@@ -246,6 +309,7 @@ typedef struct
 
     /* The limit value, a variable name with the field's limit */
     gchar           *limit;
+    Operand          limit_op;
 
     /* If the field accepts failed limits */
     gboolean         limit_failed;
@@ -264,6 +328,7 @@ typedef struct
 {
     /* The variable used for the match */
     gchar           *var_id;
+    Operand          var_op;
 
     /* The operation to perform */
     MatchOperation   op;
@@ -286,9 +351,11 @@ typedef struct
 {
     /* The variable used to control the loop */
     gchar           *until_set;
+    Operand          until_set_op;
 
     /* The variable value used for matching against the control variable */
     gchar           *var_value;
+    Operand          var_value_op;
 
     /* The numeric value used for matching against the control variable */
     guint64          num_value;
@@ -300,6 +367,7 @@ typedef struct
      * the loop should be aware of such a limit, in order to stop
      * looping on limit failure */
     gchar           *limit;
+    Operand          limit_op;
 
 } LoopStep;
 
@@ -318,6 +386,7 @@ typedef struct
 
     /* The variable value to be printed */
     gchar           *var_id;
+    Operand          var_op;
     /* The variable value is signed */
     gboolean         signed_val;
 
@@ -342,24 +411,31 @@ typedef struct
 {
     /* The variable to operate on */
     gchar           *var_id;
+    Operand          var_op;
 
     /* The value to set the variable to */
     gchar           *set;
+    Operand          set_op;
 
     /* The value to use as modulo */
     gchar           *modulo;
+    Operand          modulo_op;
 
     /* The value to add */
     gchar           *add;
+    Operand          add_op;
 
     /* The value to substract */
     gchar           *substract;
+    Operand          substract_op;
 
     /* The value to multiply by */
     gchar           *multiply;
+    Operand          multiply_op;
 
     /* The value to divide by */
     gchar           *divide;
+    Operand          divide_op;
 
     /* The operands are signed */
     gboolean         signed_op;
@@ -381,6 +457,13 @@ typedef struct
      * Used to identify the payload */
     RunStepType      step_type;
 
+    /* The index of the step this step jumps to, resolved by the validator
+     * MATCH_START_STEP, LOOP_START_STEP and SELECTION_START_STEP: the matching end step
+     * LOOP_END_STEP: the matching start step
+     * MATCH_END_STEP: the end step of the enclosing selection (or the sequence's END_STEP)
+     * BLOCK_STEP: the first step of the block (G_MAXUINT if the block is undefined) */
+    guint            jump;
+
     /* The RunStep's payload */
     union
     {
@@ -394,75 +477,73 @@ typedef struct
 
 } RunStep;
 
-/* A field option definition */
+/* A format definition
+ * The in-memory representation of an XML definition */
 typedef struct
 {
-    /* The option's name */
-    gchar           *name;
-    /* The option's value */
-    gpointer         value;
+    /* Format disabled, indicates that the format should not be used */
+    gboolean         disabled;
 
-} FieldDefinitionOption;
+    /* The format's name */
+    gchar           *format_name;
+    /* The format's short name */
+    gchar           *short_format_name;
 
-/* A field flag definition */
-typedef struct
-{
-    /* The flag's name */
-    gchar           *name;
-    /* The flag's mask */
-    guint64          mask;
+    /* Format description/details */
+    gchar           *details;
 
-    /* The flag's meaning */
-    gchar           *meaning;
+    /* Format endianness */
+    Endianness       endianness;
+    /* Variable name of the variable holding the endianness value */
+    gchar           *endianness_var;
+    guint            endianness_slot;
+    /* Value that indicates big-endian */
+    gpointer         be_value;
+    gsize            be_value_size;
+    /* Value that indicates little-endian */
+    gpointer         le_value;
+    gsize            le_value_size;
 
-} FieldDefinitionFlag;
+    /* List of Lists of MagicSteps
+     * Used to identify the file format */
+    GSList          *magic;
 
-/* A field definition */
-typedef struct
-{
-    /* Field name */
-    gchar           *name;
-    /* Field tag
-     * Used in the Hex/Text view of a file
-     * If unset, the field's name is used */
-    gchar           *tag;
+    /* Associative array of FormatColors
+     * A collection of all colors used by the format */
+    GHashTable      *colors;
 
-    /* The field's tooltip
-     * Used if the field is printed to the description panel */
-    gchar           *tooltip;
-    /* Should the tooltip be automatically generated */
-    gboolean         auto_tooltip;
+    /* Array of RunSteps, the compiled run section and blocks
+     * Used to analyze the file format
+     * The run section starts at index 0, every sequence of steps
+     * (the run section and each block) is terminated by an END_STEP */
+    RunStep         *run;
+    /* Number of RunSteps in the array */
+    guint            run_length;
 
-    /* The field's color */
-    gchar           *color;
+    /* Associative array of FieldDefinitions
+     * A collection of all possible fields in the format */
+    GHashTable      *fields;
 
-    /* The field's size type */
-    FieldSizeType    size_type;
-    /* The field's fixed size */
-    gsize            size;
-    /* The byte value used to find the field's size */
-    guchar           value;
+    /* Number of variable slots used by the format */
+    guint            variables_count;
 
-    /* The field's mask, if the field covers only a selection of bits */
-    guint64          mask;
-    /* The field's left shift */
-    guint            shift;
+    /* The magic's variables take the first slots, these are set by
+     * format_validate_header and never change: identification only uses these */
+    guint            magic_variables_count;
+    /* Slot of the endianness variable if the magic reads it, or G_MAXUINT */
+    guint            magic_endianness_slot;
 
-    /* How the field should be printed to the description panel
-     * (should this field be printed) */
-    FieldPrintType   print;
-    /* The string to print (PRINT_LITERAL) */
-    gchar           *print_literal;
-    /* Field encoding (only used in text fields, PRINT_TEXT) */
-    TextEncoding     encoding;
+    /* The definition text, until the sections other than the header,
+     * endianness and magic are validated (see format_complete) */
+    GBytes          *source;
 
-    /* For fields with fixed values: a list of FieldDefinitionOptions
-     * For flags fields: a list of FieldDefinitionFlags */
-    GSList          *value_collection;
-    /* Format endianness should be taken into account when matching values */
-    gboolean         convert_endianness;
+    /* Held by the format lists, the dispatch indexes and the analyzed files */
+    gint             ref_count;
 
-} FieldDefinition;
+    /* Unique to each definition created */
+    guint            serial;
+
+} FormatDefinition;
 
 
 /* Processor definitions */
@@ -479,6 +560,9 @@ typedef struct
 /* Processor variable */
 typedef struct
 {
+    /* The variable has been set */
+    gboolean         defined;
+
     /* If the variable failed when used as a limit */
     gboolean         failed;
 
@@ -507,15 +591,24 @@ typedef struct
 
 typedef struct
 {
-    GQueue           loop_stack;
-    GQueue           selection_stack;
-    GQueue           block_stack;
+    /* Step indices of the running loops, and the block return steps */
+    GArray          *loop_stack;
+    GArray          *block_stack;
+    /* Stack of SelectionScopes */
+    GArray          *selection_stack;
 
     guint            match_depth;
 
-    GHashTable      *variables;
+    /* Array of ProcessorVariables, indexed by variable slot */
+    ProcessorVariable *variables;
+    /* Slot of the endianness variable, or G_MAXUINT */
+    guint            endianness_slot;
     GHashTable      *tabs;
 
+    /* Reusable buffers for generated strings */
+    GString         *tooltip_buffer;
+    GString         *text_buffer;
+
     gboolean         file_end_reached;
 
 } ProcessorState;
@@ -20,6 +20,8 @@
 
 #include <chirurgien-types.h>
 
+#include "processor-file.h"
+
 G_BEGIN_DECLS
 
 /*** Public API ***/
@@ -30,4 +32,25 @@ gboolean    format_identify    (const FormatDefinition *,
 void        format_process     (const FormatDefinition *,
                                 ProcessorFile *);
 
+void        processor_file_set_format
+                               (ProcessorFile *,
+                                const FormatDefinition *);
+
+/*
+ * An index of the formats by the bytes their files begin with,
+ * shared by concurrent analyses
+ */
+typedef struct _ProcessorDispatch ProcessorDispatch;
+
+ProcessorDispatch *         processor_dispatch_new         (GSList *,
+                                                            GList *);
+ProcessorDispatch *         processor_dispatch_ref         (ProcessorDispatch *);
+void                        processor_dispatch_unref       (ProcessorDispatch *);
+
+const FormatDefinition *    processor_dispatch_identify    (ProcessorDispatch *,
+                                                            ProcessorFile *);
+GArray *                    processor_dispatch_carve       (ProcessorDispatch *,
+                                                            ProcessorFile *,
+                                                            GCancellable *);
+
 G_END_DECLS
@@ -19,25 +19,21 @@
 #include "processor.h"
 
 
-GSList *
-process_block_step (const FormatDefinition *format_definition,
-                    RunStep                *run_step,
-                    ProcessorState         *state,
-                    GSList                 *run_iter)
+guint
+process_block_step (const RunStep  *run_step,
+                    ProcessorState *state,
+                    guint           step_index)
 {
-    GSList *run_block;
-
-    run_block = g_hash_table_lookup (format_definition->blocks,
-                                     run_step->block.block_id);
-    if (run_block)
+    if (run_step->jump != G_MAXUINT)
     {
-        g_queue_push_tail (&state->block_stack, run_iter->next);
-        run_iter = run_block;
+        step_index++;
+        g_array_append_val (state->block_stack, step_index);
+        step_index = run_step->jump;
     }
     else
     {
-        run_iter = run_iter->next;
+        step_index++;
     }
 
-    return run_iter;
+    return step_index;
 }
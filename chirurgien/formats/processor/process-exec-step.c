@@ -21,7 +21,7 @@
 
 void
 process_exec_step (ProcessorFile  *file,
-                   RunStep        *run_step,
+                   const RunStep  *run_step,
                    ProcessorState *state)
 {
     ProcessorVariable *processor_var;
@@ -38,28 +38,27 @@ process_exec_step (ProcessorFile  *file,
 
     selec_ptr = run_step->exec.signed_op ? (gpointer) &signed_op_value : (gpointer) &op_value;
 
-    if (!g_strcmp0 (run_step->exec.var_id, "index"))
+    if (run_step->exec.var_op.type == OPERAND_INDEX)
     {
         index_used = TRUE;
         op_value = file->file_contents_index;
     }
     else
     {
-        processor_utils_read_value (state,
-                                    run_step->exec.var_id,
-                                    READ_VARIABLE,
-                                    &processor_var,
-                                    selec_ptr,
-                                    run_step->exec.signed_op);
+        processor_utils_read_operand (state,
+                                      &run_step->exec.var_op,
+                                      READ_VARIABLE,
+                                      &processor_var,
+                                      selec_ptr,
+                                      run_step->exec.signed_op);
         /* Doesn't existing, create it */
         if (!processor_var)
         {
-            processor_var = g_slice_new0 (ProcessorVariable);
+            processor_var = &state->variables[run_step->exec.var_op.slot];
+            *processor_var = (ProcessorVariable) { 0 };
+            processor_var->defined = TRUE;
             processor_var->size = 8;
             op_value = signed_op_value = processor_var->eight = 0;
-            g_hash_table_insert (state->variables,
-                                 run_step->exec.var_id,
-                                 processor_var);
         }
     }
 
@@ -67,18 +66,18 @@ process_exec_step (ProcessorFile  *file,
 
     if (run_step->exec.set)
     {
-        if (!g_strcmp0 (run_step->exec.set, "index"))
+        if (run_step->exec.set_op.type == OPERAND_INDEX)
         {
             op_value = file->file_contents_index;
         }
         else
         {
-            processor_utils_read_value (state,
-                                        run_step->exec.set,
-                                        READ_VARIABLE | READ_NUMERIC,
-                                        NULL,
-                                        selec_ptr,
-                                        run_step->exec.signed_op);
+            processor_utils_read_operand (state,
+                                          &run_step->exec.set_op,
+                                          READ_VARIABLE | READ_NUMERIC,
+                                          NULL,
+                                          selec_ptr,
+                                          run_step->exec.signed_op);
         }
     }
 
@@ -86,12 +85,12 @@ process_exec_step (ProcessorFile  *file,
 
     if (run_step->exec.modulo)
     {
-        processor_utils_read_value (state,
-                                    run_step->exec.modulo,
-                                    READ_VARIABLE | READ_NUMERIC,
-                                    NULL,
-                                    selec_ptr,
-                                    run_step->exec.signed_op);
+        processor_utils_read_operand (state,
+                                      &run_step->exec.modulo_op,
+                                      READ_VARIABLE | READ_NUMERIC,
+                                      NULL,
+                                      selec_ptr,
+                                      run_step->exec.signed_op);
         if (run_step->exec.signed_op)
             signed_op_value = signed_op_value % signed_exec_value;
         else
@@ -99,12 +98,12 @@ process_exec_step (ProcessorFile  *file,
     }
     if (run_step->exec.add)
     {
-        processor_utils_read_value (state,
-                                    run_step->exec.add,
-                                    READ_VARIABLE | READ_NUMERIC,
-                                    NULL,
-                                    selec_ptr,
-                                    run_step->exec.signed_op);
+        processor_utils_read_operand (state,
+                                      &run_step->exec.add_op,
+                                      READ_VARIABLE | READ_NUMERIC,
+                                      NULL,
+                                      selec_ptr,
+                                      run_step->exec.signed_op);
         if (run_step->exec.signed_op)
             signed_op_value += signed_exec_value;
         else
@@ -112,12 +111,12 @@ process_exec_step (ProcessorFile  *file,
     }
     if (run_step->exec.substract)
     {
-        processor_utils_read_value (state,
-                                    run_step->exec.substract,
-                                    READ_VARIABLE | READ_NUMERIC,
-                                    NULL,
-                                    selec_ptr,
-                                    run_step->exec.signed_op);
+        processor_utils_read_operand (state,
+                                      &run_step->exec.substract_op,
+                                      READ_VARIABLE | READ_NUMERIC,
+                                      NULL,
+                                      selec_ptr,
+                                      run_step->exec.signed_op);
         if (run_step->exec.signed_op)
             signed_op_value -= signed_exec_value;
         else
@@ -125,12 +124,12 @@ process_exec_step (ProcessorFile  *file,
     }
     if (run_step->exec.multiply)
     {
-        processor_utils_read_value (state,
-                                    run_step->exec.multiply,
-                                    READ_VARIABLE | READ_NUMERIC,
-                                    NULL,
-                                    selec_ptr,
-                                    run_step->exec.signed_op);
+        processor_utils_read_operand (state,
+                                      &run_step->exec.multiply_op,
+                                      READ_VARIABLE | READ_NUMERIC,
+                                      NULL,
+                                      selec_ptr,
+                                      run_step->exec.signed_op);
         if (run_step->exec.signed_op)
             signed_op_value *= signed_exec_value;
         else
@@ -138,12 +137,12 @@ process_exec_step (ProcessorFile  *file,
     }
     if (run_step->exec.divide)
     {
-        processor_utils_read_value (state,
-                                    run_step->exec.divide,
-                                    READ_VARIABLE | READ_NUMERIC,
-                                    NULL,
-                                    selec_ptr,
-                                    run_step->exec.signed_op);
+        processor_utils_read_operand (state,
+                                      &run_step->exec.divide_op,
+                                      READ_VARIABLE | READ_NUMERIC,
+                                      NULL,
+                                      selec_ptr,
+                                      run_step->exec.signed_op);
         if (run_step->exec.signed_op)
         {
             rational = signed_exec_value ? (gdouble) signed_op_value / signed_exec_value : 0.0;
@@ -18,27 +18,27 @@
 
 #include "processor.h"
 
-#include <chirurgien-globals.h>
+#include <chirurgien-formats-globals.h>
 
 
 void
 process_field_step (const FormatDefinition *format_definition,
                     ProcessorFile          *file,
-                    RunStep                *run_step,
+                    const RunStep          *run_step,
                     ProcessorState         *state)
 {
-    FieldDefinition *field_def;
+    const FieldDefinition *field_def;
     FieldDefinitionOption *option;
     FieldDefinitionFlag *flag;
     FormatColor *color, *additional_color;
 
-    ProcessorVariable *processor_var;
+    ProcessorVariable *processor_var, stored_var;
     guint64 op_value;
 
     DescriptionTab *tab;
 
     gsize available_data, field_size;
-    const guchar *file_contents;
+    const guchar *navigation_contents;
 
     union
     {
@@ -48,6 +48,7 @@ process_field_step (const FormatDefinition *format_definition,
         guint64 eight;
         guchar  value[8];
     } raw_field_value;
+    gchar number_value[24];
     gchar *field_value;
 
     GSList *option_i;
@@ -61,25 +62,26 @@ process_field_step (const FormatDefinition *format_definition,
     if (state->file_end_reached && !run_step->field.limit_failed)
         return;
 
-    field_def = g_hash_table_lookup (format_definition->fields,
-                                     run_step->field.field_id);
+    field_def = run_step->field.field_def;
     /* The field doesn't exist, skip */
     if (!field_def)
         return;
 
-    /* Clear 'available' size fields */
+    /* The field's size in this execution, 'available' size fields start empty */
     if (field_def->size_type == AVAILABLE_SIZE || field_def->size_type == VALUE_SIZE)
-        field_def->size = 0;
+        field_size = 0;
+    else
+        field_size = field_def->size;
 
     /* The field has an explicit offset */
     if (run_step->field.offset)
     {
-        processor_utils_read_value (state,
-                                    run_step->field.offset,
-                                    READ_VARIABLE | READ_NUMERIC,
-                                    &processor_var,
-                                    &op_value,
-                                    FALSE);
+        processor_utils_read_operand (state,
+                                      &run_step->field.offset_op,
+                                      READ_VARIABLE | READ_NUMERIC,
+                                      &processor_var,
+                                      &op_value,
+                                      FALSE);
         index_saved = TRUE;
         save_index = file->file_contents_index;
 
@@ -91,9 +93,8 @@ process_field_step (const FormatDefinition *format_definition,
     }
 
     tab = NULL;
-    available_data = FILE_AVAILABLE_DATA (file);
 
-    if (!index_saved && (field_def->size > available_data))
+    if (!index_saved && field_size && !FILE_HAS_DATA_N (file, field_size))
     {
         state->file_end_reached = TRUE;
         return;
@@ -102,25 +103,30 @@ process_field_step (const FormatDefinition *format_definition,
     /* The field's size is determinted by a byte value */
     if (field_def->size_type == VALUE_SIZE)
     {
-        for (file_contents = GET_CONTENT_POINTER (file), field_size = 0;
-             field_size < available_data;
-             file_contents++, field_size++)
-        {
-            if (*file_contents == field_def->value)
-                break;
-        }
-        field_def->size = field_size;
+        available_data = file->file_contents_index < file->file_size ?
+                         file->file_size - file->file_contents_index : 0;
+
+        field_size = processor_utils_find_byte (file,
+                                                file->file_contents_index,
+                                                available_data,
+                                                field_def->value);
+
+        /* Without the value, the field depends on the file size */
+        processor_utils_depend (file,
+                                file->file_contents_index,
+                                field_size < available_data ?
+                                file->file_contents_index + field_size + 1 : G_MAXSIZE);
     }
 
     /* The field has a limit */
     if (run_step->field.limit)
     {
-        processor_utils_read_value (state,
-                                    run_step->field.limit,
-                                    READ_VARIABLE | READ_NUMERIC,
-                                    &processor_var,
-                                    &op_value,
-                                    FALSE);
+        processor_utils_read_operand (state,
+                                      &run_step->field.limit_op,
+                                      READ_VARIABLE | READ_NUMERIC,
+                                      &processor_var,
+                                      &op_value,
+                                      FALSE);
         if (processor_var)
         {
             if (processor_var->failed && !run_step->field.limit_failed)
@@ -128,14 +134,13 @@ process_field_step (const FormatDefinition *format_definition,
 
             if (field_def->size_type == AVAILABLE_SIZE)
             {
-                field_def->size = MIN (op_value, available_data);
+                field_size = processor_utils_available_data (file, op_value);
             }
             else if (field_def->size_type == VALUE_SIZE)
             {
-                field_def->size = MIN (op_value, field_def->size);
-                field_def->size = MIN (available_data, field_def->size);
+                field_size = MIN (op_value, field_size);
             }
-            else if (op_value < field_def->size)
+            else if (op_value < field_size)
             {
                 processor_var->failed = TRUE;
                 return;
@@ -146,23 +151,23 @@ process_field_step (const FormatDefinition *format_definition,
                 switch (processor_var->size)
                 {
                     case 1:
-                    processor_var->one -= field_def->size;
+                    processor_var->one -= field_size;
 
                     break;
                     case 2:
-                    processor_var->two -= field_def->size;
+                    processor_var->two -= field_size;
 
                     break;
                     case 3:
                     case 4:
-                    processor_var->four -= field_def->size;
+                    processor_var->four -= field_size;
 
                     break;
                     case 5:
                     case 6:
                     case 7:
                     case 8:
-                    processor_var->eight -= field_def->size;
+                    processor_var->eight -= field_size;
 
                     break;
                 }
@@ -172,55 +177,59 @@ process_field_step (const FormatDefinition *format_definition,
         {
             if (field_def->size_type == AVAILABLE_SIZE)
             {
-                field_def->size = MIN (op_value, available_data);
+                field_size = processor_utils_available_data (file, op_value);
             }
             else if (field_def->size_type == VALUE_SIZE)
             {
-                field_def->size = MIN (op_value, field_def->size);
-                field_def->size = MIN (available_data, field_def->size);
+                field_size = MIN (op_value, field_size);
             }
         }
     }
     /* No limit, but the field has dynamic size */
     else if (field_def->size_type == AVAILABLE_SIZE)
     {
-        field_def->size = available_data;
+        field_size = processor_utils_available_data (file, G_MAXSIZE);
     }
 
     /* The field's value should be stored */
     if (run_step->field.store_var)
     {
-        if (field_def->size)
+        if (field_size)
         {
-            processor_var = g_slice_new0 (ProcessorVariable);
+            stored_var = (ProcessorVariable) { 0 };
 
             store_var = FALSE;
 
             /* The field is an ASCII-encoded number */
             if (run_step->field.ascii_base)
             {
-                if (field_def->size)
+                if (field_size)
                 {
-                    processor_var->size = 8;
+                    stored_var.size = 8;
+
+                    processor_utils_depend (file,
+                                            file->file_contents_index,
+                                            file->file_contents_index + field_size);
 
-                    field_value = g_strndup (GET_CONTENT_POINTER (file), field_def->size);
-                    processor_var->eight = g_ascii_strtoull (field_value, NULL, run_step->field.ascii_base);
-                    g_free (field_value);
+                    string_obj = g_string_truncate (state->text_buffer, 0);
+                    g_string_append_len (string_obj, GET_CONTENT_POINTER (file, field_size), field_size);
+                    stored_var.eight = g_ascii_strtoull (string_obj->str, NULL, run_step->field.ascii_base);
 
                     store_var = TRUE;
                 }
             }
             /* The field is a binary number or raw data */
-            else if (field_def->size <= 8)
+            else if (field_size <= 8)
             {
-                processor_var->size = field_def->size;
+                stored_var.size = field_size;
 
                 if (processor_utils_read (format_definition,
                                           state,
                                           file,
                                           field_def,
+                                          field_size,
                                           run_step->field.convert_endianness,
-                                          processor_var->value))
+                                          stored_var.value))
                 {
                     store_var = TRUE;
                 }
@@ -228,13 +237,8 @@ process_field_step (const FormatDefinition *format_definition,
 
             if (store_var)
             {
-                g_hash_table_insert (state->variables,
-                                     run_step->field.store_var,
-                                     processor_var);
-            }
-            else
-            {
-                g_slice_free (ProcessorVariable, processor_var);
+                stored_var.defined = TRUE;
+                state->variables[run_step->field.store_var_slot] = stored_var;
             }
         }
     }
@@ -246,7 +250,7 @@ process_field_step (const FormatDefinition *format_definition,
                                    run_step->field.tab);
         if (!tab)
         {
-            tab = processor_utils_new_tab (run_step->field.section);
+            tab = processor_utils_new_tab (file, run_step->field.section);
             g_hash_table_insert (state->tabs,
                                  run_step->field.tab,
                                  tab);
@@ -286,48 +290,50 @@ process_field_step (const FormatDefinition *format_definition,
         /* Field value: text */
         else if (field_def->print == PRINT_TEXT)
         {
+            processor_utils_depend (file,
+                                    file->file_contents_index,
+                                    file->file_contents_index + field_size);
             processor_utils_add_text_tab (tab,
                                           field_def->name,
-                                          GET_CONTENT_POINTER (file),
-                                          field_def->size,
+                                          GET_CONTENT_POINTER (file, field_size),
+                                          field_size,
                                           field_def->encoding);
         }
         /* Other value types are limited to 8 bytes */
-        else if (field_def->size && field_def->size <= 8 &&
+        else if (field_size && field_size <= 8 &&
                  processor_utils_read (format_definition,
                                        state,
                                        file,
                                        field_def,
+                                       field_size,
                                        run_step->field.convert_endianness,
                                        raw_field_value.value))
         {
             /* Field value: int/uint */
             if (field_def->print == PRINT_INT || field_def->print == PRINT_UINT)
             {
-                field_value = NULL;
-
-                switch (field_def->size)
+                switch (field_size)
                 {
                     case 1:
                     if (field_def->print == PRINT_INT)
-                        field_value = g_strdup_printf ("%hhd", raw_field_value.one);
+                        g_snprintf (number_value, sizeof (number_value), "%hhd", raw_field_value.one);
                     else
-                        field_value = g_strdup_printf ("%hhu", raw_field_value.one);
+                        g_snprintf (number_value, sizeof (number_value), "%hhu", raw_field_value.one);
 
                     break;
                     case 2:
                     if (field_def->print == PRINT_INT)
-                        field_value = g_strdup_printf ("%hd", raw_field_value.two);
+                        g_snprintf (number_value, sizeof (number_value), "%hd", raw_field_value.two);
                     else
-                        field_value = g_strdup_printf ("%hu", raw_field_value.two);
+                        g_snprintf (number_value, sizeof (number_value), "%hu", raw_field_value.two);
 
                     break;
                     case 3:
                     case 4:
                     if (field_def->print == PRINT_INT)
-                        field_value = g_strdup_printf ("%d", raw_field_value.four);
+                        g_snprintf (number_value, sizeof (number_value), "%d", raw_field_value.four);
                     else
-                        field_value = g_strdup_printf ("%u", raw_field_value.four);
+                        g_snprintf (number_value, sizeof (number_value), "%u", raw_field_value.four);
 
                     break;
                     case 5:
@@ -335,31 +341,27 @@ process_field_step (const FormatDefinition *format_definition,
                     case 7:
                     case 8:
                     if (field_def->print == PRINT_INT)
-                        field_value = g_strdup_printf ("%ld", raw_field_value.eight);
+                        g_snprintf (number_value, sizeof (number_value), "%ld", raw_field_value.eight);
                     else
-                        field_value = g_strdup_printf ("%lu", raw_field_value.eight);
+                        g_snprintf (number_value, sizeof (number_value), "%lu", raw_field_value.eight);
 
                     break;
                 }
 
-                if (field_value)
-                {
-                    if (tab)
-                        processor_utils_add_line_tab (tab,
-                                                      field_def->name,
-                                                      field_value,
-                                                      field_def->tooltip,
-                                                      run_step->field.margin_top,
-                                                      run_step->field.margin_bottom);
-                    else
-                        processor_utils_add_line (file,
+                if (tab)
+                    processor_utils_add_line_tab (tab,
                                                   field_def->name,
-                                                  field_value,
+                                                  number_value,
                                                   field_def->tooltip,
                                                   run_step->field.margin_top,
                                                   run_step->field.margin_bottom);
-                    g_free (field_value);
-                }
+                else
+                    processor_utils_add_line (file,
+                                              field_def->name,
+                                              number_value,
+                                              field_def->tooltip,
+                                              run_step->field.margin_top,
+                                              run_step->field.margin_bottom);
             }
             /* Field value: one of a set of options */
             else if (field_def->print == PRINT_OPTION)
@@ -367,9 +369,10 @@ process_field_step (const FormatDefinition *format_definition,
                 /* The field has an automatically generated tooltip */
                 if (field_def->auto_tooltip)
                 {
-                    auto_tooltip = g_string_new (field_def->tooltip ?
-                                                 field_def->tooltip :
-                                                 field_def->name);
+                    auto_tooltip = g_string_assign (state->tooltip_buffer,
+                                                    field_def->tooltip ?
+                                                    field_def->tooltip :
+                                                    field_def->name);
                     auto_tooltip = g_string_append_c (auto_tooltip, '\n');
 
                     for (option_i = field_def->value_collection;
@@ -380,7 +383,7 @@ process_field_step (const FormatDefinition *format_definition,
                         field_value = option->value;
 
                         g_string_append (auto_tooltip, "<tt>");
-                        for (gsize i = 0; i < field_def->size; i++)
+                        for (gsize i = 0; i < field_size; i++)
                         {
                             g_string_append_c (auto_tooltip,
                                                hex_chars[((guchar) field_value[i]) >> 4]);
@@ -404,7 +407,7 @@ process_field_step (const FormatDefinition *format_definition,
                  * Convert variable endianness fields to big-endian */
                 if (field_def->convert_endianness)
                 {
-                    switch (field_def->size)
+                    switch (field_size)
                     {
                         case 2:
                         raw_field_value.two = GUINT16_TO_BE (raw_field_value.two);
@@ -435,7 +438,7 @@ process_field_step (const FormatDefinition *format_definition,
 
                     if (!memcmp (raw_field_value.value,
                                  option->value,
-                                 field_def->size))
+                                 field_size))
                     {
                         field_value = option->name;
                         break;
@@ -443,7 +446,10 @@ process_field_step (const FormatDefinition *format_definition,
                 }
 
                 if (!field_value)
+                {
                     field_value = "<span foreground=\"red\">INVALID</span>";
+                    file->invalid_values++;
+                }
 
                 if (tab)
                     processor_utils_add_line_tab (tab,
@@ -459,8 +465,6 @@ process_field_step (const FormatDefinition *format_definition,
                                               auto_tooltip ? auto_tooltip->str : field_def->tooltip,
                                               run_step->field.margin_top,
                                               run_step->field.margin_bottom);
-                if (auto_tooltip)
-                    g_string_free (auto_tooltip, TRUE);
             }
             /* Field value: a set of flags */
             else if (field_def->print == PRINT_FLAGS)
@@ -468,9 +472,10 @@ process_field_step (const FormatDefinition *format_definition,
                 /* The field has an automatically generated tooltip */
                 if (field_def->auto_tooltip)
                 {
-                    auto_tooltip = g_string_new (field_def->tooltip ?
-                                                 field_def->tooltip :
-                                                 field_def->name);
+                    auto_tooltip = g_string_assign (state->tooltip_buffer,
+                                                    field_def->tooltip ?
+                                                    field_def->tooltip :
+                                                    field_def->name);
                     auto_tooltip = g_string_append_c (auto_tooltip, '\n');
 
                     for (option_i = field_def->value_collection;
@@ -492,7 +497,7 @@ process_field_step (const FormatDefinition *format_definition,
                     auto_tooltip = NULL;
                 }
 
-                switch (field_def->size)
+                switch (field_size)
                 {
                     case 1:
                     op_value = raw_field_value.one;
@@ -517,7 +522,7 @@ process_field_step (const FormatDefinition *format_definition,
                 }
 
                 /* Look for the set flags */
-                string_obj = g_string_new (NULL);
+                string_obj = g_string_truncate (state->text_buffer, 0);
                 for (option_i = field_def->value_collection;
                      option_i;
                      option_i = option_i->next)
@@ -545,46 +550,45 @@ process_field_step (const FormatDefinition *format_definition,
                                               run_step->field.margin_top,
                                               run_step->field.margin_bottom);
 
-                g_string_free (string_obj, TRUE);
-
-                if (auto_tooltip)
-                    g_string_free (auto_tooltip, TRUE);
             }
         }
     }
 
     /* Get the field's color */
-    color = field_def->color ? g_hash_table_lookup (format_definition->colors,
-                                                    field_def->color) :
-                               NULL;
+    color = field_def->color_def;
     /* Get the field's additional color */
-    additional_color = run_step->field.additional_color ?
-                       g_hash_table_lookup (format_definition->colors,
-                                            run_step->field.additional_color) :
-                       NULL;
+    additional_color = run_step->field.additional_color_def;
 
-    string_obj = g_string_new (run_step->field.navigation);
+    string_obj = g_string_assign (state->text_buffer,
+                                  run_step->field.navigation ? run_step->field.navigation : "");
     /* Get the navigation tag */
     if (run_step->field.navigation)
     {
-        processor_utils_read_value (state,
-                                    run_step->field.navigation,
-                                    READ_VARIABLE,
-                                    &processor_var,
-                                    &op_value,
-                                    FALSE);
+        processor_utils_read_operand (state,
+                                      &run_step->field.navigation_op,
+                                      READ_VARIABLE,
+                                      &processor_var,
+                                      &op_value,
+                                      FALSE);
         if (processor_var && file->file_size > op_value)
         {
-            if (strnlen (file->file_contents + op_value, file->file_size - op_value) > 15)
+            /* Labels are read up to 16 bytes */
+            processor_utils_depend (file, op_value, op_value + 16);
+
+            navigation_contents = processor_utils_get_contents (file, op_value, 16);
+
+            if (strnlen ((const gchar *) navigation_contents, MIN (file->file_size - op_value, 16)) > 15)
             {
                 g_string_append_len (g_string_truncate (string_obj, 0),
-                                     file->file_contents + op_value, 10);
+                                     (const gchar *) navigation_contents, 10);
                 g_string_append (string_obj, " [...]");
             }
             else
             {
-                g_string_append (g_string_truncate (string_obj, 0),
-                                 file->file_contents + op_value);
+                g_string_append_len (g_string_truncate (string_obj, 0),
+                                     (const gchar *) navigation_contents,
+                                     strnlen ((const gchar *) navigation_contents,
+                                              MIN (file->file_size - op_value, 16)));
             }
 
             if (run_step->field.navigation_limit && string_obj->len > run_step->field.navigation_limit)
@@ -604,7 +608,7 @@ process_field_step (const FormatDefinition *format_definition,
     }
 
     /* Masked or shifted fields do not emit file fields */
-    if (!field_def->mask && !field_def->shift && color && field_def->size)
+    if (!field_def->mask && !field_def->shift && color && field_size)
     {
         /* Get the field tag */
         if (field_def->tag && !g_strcmp0 (field_def->tag, "navigation"))
@@ -618,12 +622,11 @@ process_field_step (const FormatDefinition *format_definition,
         processor_utils_add_field (file,
                                    color ? color->color_index : G_MAXUINT,
                                    color ? color->background : TRUE,
-                                   field_def->size,
+                                   field_size,
                                    field_tag,
                                    string_obj->len ? string_obj->str : NULL,
                                    additional_color ? additional_color->color_index : G_MAXUINT);
     }
-    g_string_free (string_obj, TRUE);
 
     /* Insert tab */
     if (tab && run_step->field.insert_tab)
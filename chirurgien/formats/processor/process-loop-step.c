@@ -19,11 +19,11 @@
 #include "processor.h"
 
 
-GSList *
+guint
 process_loop_start_step (ProcessorFile  *file,
-                         RunStep        *run_step,
+                         const RunStep  *run_step,
                          ProcessorState *state,
-                         GSList         *run_iter)
+                         guint           step_index)
 {
     ProcessorVariable *processor_var;
     guint64 op_value, compare_value;
@@ -39,12 +39,12 @@ process_loop_start_step (ProcessorFile  *file,
     }
     else if (run_step->loop.limit)
     {
-        processor_utils_read_value (state,
-                                    run_step->loop.limit,
-                                    READ_VARIABLE,
-                                    &processor_var,
-                                    &op_value,
-                                    FALSE);
+        processor_utils_read_operand (state,
+                                      &run_step->loop.limit_op,
+                                      READ_VARIABLE,
+                                      &processor_var,
+                                      &op_value,
+                                      FALSE);
         if (processor_var && (!op_value || processor_var->failed))
             break_loop = TRUE;
     }
@@ -55,22 +55,22 @@ process_loop_start_step (ProcessorFile  *file,
         /* Get control variable */
         if (run_step->loop.until_set)
         {
-            processor_utils_read_value (state,
-                                        run_step->loop.until_set,
-                                        READ_VARIABLE,
-                                        &processor_var,
-                                        &op_value,
-                                        FALSE);
+            processor_utils_read_operand (state,
+                                          &run_step->loop.until_set_op,
+                                          READ_VARIABLE,
+                                          &processor_var,
+                                          &op_value,
+                                          FALSE);
             if (processor_var)
             {
                 if (run_step->loop.var_value)
                 {
-                    processor_utils_read_value (state,
-                                                run_step->loop.var_value,
-                                                READ_VARIABLE,
-                                                NULL,
-                                                &compare_value,
-                                                FALSE);
+                    processor_utils_read_operand (state,
+                                                  &run_step->loop.var_value_op,
+                                                  READ_VARIABLE,
+                                                  NULL,
+                                                  &compare_value,
+                                                  FALSE);
                     if (op_value == compare_value)
                         break_loop = TRUE;
                 }
@@ -94,27 +94,28 @@ process_loop_start_step (ProcessorFile  *file,
     if (break_loop)
     {
         /* Skip all steps inside the loop */
-        run_iter = processor_utils_skip_steps (run_iter->next,
-                                               LOOP_START_STEP,
-                                               LOOP_END_STEP);
+        step_index = run_step->jump;
     }
     else
     {
-        g_queue_push_tail (&state->loop_stack, run_iter);
+        g_array_append_val (state->loop_stack, step_index);
     }
 
-    return run_iter->next;
+    return step_index + 1;
 }
 
-GSList *
+guint
 process_loop_end_step (ProcessorState *state,
-                       GSList         *run_iter)
+                       guint           step_index)
 {
     /* Continue loop */
-    if (state->loop_stack.length)
-        run_iter = g_queue_pop_tail (&state->loop_stack);
+    if (state->loop_stack->len)
+    {
+        step_index = g_array_index (state->loop_stack, guint, state->loop_stack->len - 1);
+        g_array_set_size (state->loop_stack, state->loop_stack->len - 1);
+    }
     else
-        run_iter = run_iter->next;
+        step_index++;
 
-    return run_iter;
+    return step_index;
 }
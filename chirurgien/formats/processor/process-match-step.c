@@ -19,12 +19,12 @@
 #include "processor.h"
 
 
-GSList *
+guint
 process_match_start_step (const FormatDefinition *format_definition,
                           ProcessorFile          *file,
-                          RunStep                *run_step,
+                          const RunStep          *run_step,
                           ProcessorState         *state,
-                          GSList                 *run_iter)
+                          guint                   step_index)
 {
     ProcessorVariable *processor_var;
     guint64 op_value;
@@ -43,12 +43,12 @@ process_match_start_step (const FormatDefinition *format_definition,
     /* Match uses a variable */
     if (run_step->match.var_id)
     {
-        processor_utils_read_value (state,
-                                    run_step->match.var_id,
-                                    READ_VARIABLE,
-                                    &processor_var,
-                                    &op_value,
-                                    FALSE);
+        processor_utils_read_operand (state,
+                                      &run_step->match.var_op,
+                                      READ_VARIABLE,
+                                      &processor_var,
+                                      &op_value,
+                                      FALSE);
         if (processor_var)
             execute_match = TRUE;
     }
@@ -111,12 +111,16 @@ process_match_start_step (const FormatDefinition *format_definition,
             {
                 match_size = processor_var->size;
 
-                if (FILE_HAS_DATA_N (file, match_size) &&
-                    !memcmp (processor_var->value,
-                             GET_CONTENT_POINTER (file),
-                             match_size))
+                if (FILE_HAS_DATA_N (file, match_size))
                 {
-                    match_success = TRUE;
+                    processor_utils_depend (file,
+                                            file->file_contents_index,
+                                            file->file_contents_index + match_size);
+
+                    if (!memcmp (processor_var->value,
+                                 GET_CONTENT_POINTER (file, match_size),
+                                 match_size))
+                        match_success = TRUE;
                 }
             }
         }
@@ -136,22 +140,30 @@ process_match_start_step (const FormatDefinition *format_definition,
             }
 
             /* No matching value or value actually matches = match success */
-            if (!run_step->match.value ||
-                (FILE_HAS_DATA_N (file, match_size) &&
-                !memcmp (run_step->match.convert_endianness ? match_data : run_step->match.value,
-                         GET_CONTENT_POINTER (file),
-                         match_size)))
+            if (!run_step->match.value)
             {
                 match_success = TRUE;
             }
+            else if (FILE_HAS_DATA_N (file, match_size))
+            {
+                processor_utils_depend (file,
+                                        file->file_contents_index,
+                                        file->file_contents_index + match_size);
+
+                if (!memcmp (run_step->match.convert_endianness ? match_data : run_step->match.value,
+                             GET_CONTENT_POINTER (file, match_size),
+                             match_size))
+                    match_success = TRUE;
+            }
         }
     }
 
-    if (match_success && state->selection_stack.length)
+    if (match_success && state->selection_stack->len)
     {
         state->match_depth++;
 
-        scope = g_queue_peek_tail (&state->selection_stack);
+        scope = &g_array_index (state->selection_stack, SelectionScope,
+                                state->selection_stack->len - 1);
 
         /* If matching within the scope of a selection, update selection state */
         if (!scope->used)
@@ -163,41 +175,40 @@ process_match_start_step (const FormatDefinition *format_definition,
     else if (!match_success)
     {
         /* Skip all steps inside the match section */
-        run_iter = processor_utils_skip_steps (run_iter->next,
-                                               MATCH_START_STEP,
-                                               MATCH_END_STEP);
+        step_index = run_step->jump;
     }
 
-    return run_iter->next;
+    return step_index + 1;
 }
 
-GSList *
-process_match_end_step (ProcessorState *state,
-                        GSList         *run_iter)
+guint
+process_match_end_step (const RunStep  *run_step,
+                        ProcessorState *state,
+                        guint           step_index)
 {
     SelectionScope *scope;
 
-    if (state->selection_stack.length)
+    if (state->selection_stack->len)
     {
-        scope = g_queue_peek_tail (&state->selection_stack);
+        scope = &g_array_index (state->selection_stack, SelectionScope,
+                                state->selection_stack->len - 1);
 
         if (scope->used && scope->match_depth == state->match_depth)
         {
-           run_iter = processor_utils_skip_steps (run_iter,
-                                                  SELECTION_START_STEP,
-                                                  SELECTION_END_STEP);
+            /* Skip to the end of the selection */
+            step_index = run_step->jump;
         }
         else
         {
-            run_iter = run_iter->next;
+            step_index++;
         }
 
         state->match_depth--;
     }
     else
     {
-        run_iter = run_iter->next;
+        step_index++;
     }
 
-    return run_iter;
+    return step_index;
 }
@@ -21,7 +21,7 @@
 
 void
 process_print_step (ProcessorFile  *file,
-                    RunStep        *run_step,
+                    const RunStep  *run_step,
                     ProcessorState *state)
 {
     DescriptionTab *tab;
@@ -29,14 +29,14 @@ process_print_step (ProcessorFile  *file,
     ProcessorVariable *processor_var;
     guint64 op_value;
 
-    g_autofree gchar *print_value = NULL;
+    const gchar *print_value = NULL;
 
-    processor_utils_read_value (state,
-                                run_step->print.var_id,
-                                READ_VARIABLE,
-                                &processor_var,
-                                &op_value,
-                                FALSE);
+    processor_utils_read_operand (state,
+                                  &run_step->print.var_op,
+                                  READ_VARIABLE,
+                                  &processor_var,
+                                  &op_value,
+                                  FALSE);
 
     tab = NULL;
 
@@ -46,7 +46,7 @@ process_print_step (ProcessorFile  *file,
                                    run_step->print.tab);
         if (!tab)
         {
-            tab = processor_utils_new_tab (run_step->print.section);
+            tab = processor_utils_new_tab (file, run_step->print.section);
             g_hash_table_insert (state->tabs,
                                  run_step->print.tab,
                                  tab);
@@ -64,11 +64,13 @@ process_print_step (ProcessorFile  *file,
     if (processor_var)
     {
         if (processor_var->rational_value)
-            print_value = g_strdup_printf ("%f", processor_var->rational);
+            g_string_printf (state->text_buffer, "%f", processor_var->rational);
         else if (run_step->print.signed_val)
-            print_value = g_strdup_printf ("%ld", op_value);
+            g_string_printf (state->text_buffer, "%ld", op_value);
         else
-            print_value = g_strdup_printf ("%lu", op_value);
+            g_string_printf (state->text_buffer, "%lu", op_value);
+
+        print_value = state->text_buffer->str;
     }
 
     if (print_value || !run_step->print.omit_undefined)
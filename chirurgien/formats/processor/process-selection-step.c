@@ -22,18 +22,14 @@
 void
 process_selection_start_step (ProcessorState *state)
 {
-    SelectionScope *scope;
-
-    scope = g_slice_new0 (SelectionScope);
-
-    /* Start selection scope */
-    g_queue_push_tail (&state->selection_stack, scope);
+    /* Start selection scope, new scopes are zero-initialized */
+    g_array_set_size (state->selection_stack, state->selection_stack->len + 1);
 }
 
 void
 process_selection_end_step (ProcessorState *state)
 {
     /* End selection scope */
-    if (state->selection_stack.length)
-        selection_scope_destroy (g_queue_pop_tail (&state->selection_stack));
+    if (state->selection_stack->len)
+        g_array_set_size (state->selection_stack, state->selection_stack->len - 1);
 }
@@ -0,0 +1,208 @@
+/* processor-arena.c
+ *
+ * Copyright (C) 2021 - Daniel Léonard Schardijn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "processor-arena.h"
+
+#include <string.h>
+
+#define ARENA_BLOCK_SIZE 65536
+#define ARENA_ALIGNMENT  16
+
+typedef struct _ArenaBlock ArenaBlock;
+
+struct _ArenaBlock
+{
+    /* The previously filled block */
+    ArenaBlock     *previous;
+
+    /* Block size, excluding this header */
+    gsize           size;
+
+};
+
+struct _ProcessorArena
+{
+    /* The block being filled, blocks are chained to the previous one */
+    ArenaBlock     *block;
+
+    /* Next free byte and end of the block being filled */
+    guint8         *next;
+    guint8         *end;
+
+    gint            ref_count;
+
+};
+
+/* Block data starts after the (aligned) block header */
+#define ARENA_BLOCK_HEADER (((sizeof (ArenaBlock) + ARENA_ALIGNMENT - 1) / ARENA_ALIGNMENT) * ARENA_ALIGNMENT)
+
+
+ProcessorArena *
+processor_arena_new (void)
+{
+    ProcessorArena *arena;
+
+    arena = g_slice_new0 (ProcessorArena);
+    arena->ref_count = 1;
+
+    return arena;
+}
+
+ProcessorArena *
+processor_arena_ref (ProcessorArena *arena)
+{
+    g_atomic_int_inc (&arena->ref_count);
+
+    return arena;
+}
+
+void
+processor_arena_unref (gpointer data)
+{
+    ProcessorArena *arena;
+    ArenaBlock *block;
+
+    arena = data;
+
+    if (!arena || !g_atomic_int_dec_and_test (&arena->ref_count))
+        return;
+
+    while (arena->block)
+    {
+        block = arena->block;
+        arena->block = block->previous;
+
+        g_free (block);
+    }
+
+    g_slice_free (ProcessorArena, arena);
+}
+
+/*
+ * Releases everything allocated from the arena, keeping its last block
+ * Only valid while the arena's allocations are no longer referenced
+ */
+void
+processor_arena_reset (ProcessorArena *arena)
+{
+    ArenaBlock *block;
+
+    if (!arena->block)
+        return;
+
+    while (arena->block->previous)
+    {
+        block = arena->block->previous;
+        arena->block->previous = block->previous;
+
+        g_free (block);
+    }
+
+    arena->next = (guint8 *) arena->block + ARENA_BLOCK_HEADER;
+    arena->end = arena->next + arena->block->size;
+}
+
+static void
+processor_arena_add_block (ProcessorArena *arena,
+                           gsize           size)
+{
+    ArenaBlock *block;
+
+    block = g_malloc (ARENA_BLOCK_HEADER + size);
+    block->previous = arena->block;
+    block->size = size;
+
+    arena->block = block;
+    arena->next = (guint8 *) block + ARENA_BLOCK_HEADER;
+    arena->end = arena->next + size;
+}
+
+gpointer
+processor_arena_alloc (ProcessorArena *arena,
+                       gsize           size)
+{
+    gpointer allocation;
+
+    size = (size + ARENA_ALIGNMENT - 1) & ~((gsize) ARENA_ALIGNMENT - 1);
+
+    if ((gsize) (arena->end - arena->next) < size)
+        processor_arena_add_block (arena, MAX (size, ARENA_BLOCK_SIZE));
+
+    allocation = arena->next;
+    arena->next += size;
+
+    return allocation;
+}
+
+gpointer
+processor_arena_alloc0 (ProcessorArena *arena,
+                        gsize           size)
+{
+    return memset (processor_arena_alloc (arena, size), 0, size);
+}
+
+gchar *
+processor_arena_strndup (ProcessorArena *arena,
+                         const gchar    *string,
+                         gsize           length)
+{
+    gchar *copy;
+
+    if (!string)
+        return NULL;
+
+    length = strnlen (string, length);
+
+    copy = processor_arena_alloc (arena, length + 1);
+    memcpy (copy, string, length);
+    copy[length] = '\0';
+
+    return copy;
+}
+
+gchar *
+processor_arena_strdup (ProcessorArena *arena,
+                        const gchar    *string)
+{
+    if (!string)
+        return NULL;
+
+    return processor_arena_strndup (arena, string, strlen (string));
+}
+
+gchar *
+processor_arena_strdup_printf (ProcessorArena *arena,
+                               const gchar    *format,
+                               ...)
+{
+    va_list args;
+    gchar *string;
+    gint length;
+
+    va_start (args, format);
+    length = g_vsnprintf (NULL, 0, format, args);
+    va_end (args);
+
+    string = processor_arena_alloc (arena, length + 1);
+
+    va_start (args, format);
+    g_vsnprintf (string, length + 1, format, args);
+    va_end (args);
+
+    return string;
+}
@@ -0,0 +1,53 @@
+/* processor-arena.h
+ *
+ * Copyright (C) 2021 - Daniel Léonard Schardijn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/*
+ * A bump allocator owned by an analysis
+ * Everything allocated from the arena is released at once, when its last
+ * reference is dropped, it is not thread-safe
+ */
+typedef struct _ProcessorArena ProcessorArena;
+
+ProcessorArena *    processor_arena_new              (void);
+ProcessorArena *    processor_arena_ref              (ProcessorArena *);
+void                processor_arena_unref            (gpointer);
+void                processor_arena_reset            (ProcessorArena *);
+
+gpointer            processor_arena_alloc            (ProcessorArena *,
+                                                      gsize);
+gpointer            processor_arena_alloc0           (ProcessorArena *,
+                                                      gsize);
+gchar *             processor_arena_strdup           (ProcessorArena *,
+                                                      const gchar *);
+gchar *             processor_arena_strndup          (ProcessorArena *,
+                                                      const gchar *,
+                                                      gsize);
+gchar *             processor_arena_strdup_printf    (ProcessorArena *,
+                                                      const gchar *,
+                                                      ...) G_GNUC_PRINTF (2, 3);
+
+#define processor_arena_new0(arena, struct_type, n_structs) \
+    ((struct_type *) processor_arena_alloc0 (arena, sizeof (struct_type) * (n_structs)))
+
+G_END_DECLS
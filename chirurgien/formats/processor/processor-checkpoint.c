@@ -0,0 +1,683 @@
+/* processor-checkpoint.c
+ *
+ * Copyright (C) 2021 - Daniel Léonard Schardijn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "processor-checkpoint.h"
+
+
+/* A description tab, as seen by a checkpoint */
+typedef struct
+{
+    /* The running tab key, or the inserted tab name */
+    const gchar    *name;
+
+    /* The tab's records, shared with the tab: later records do not
+     * belong to the checkpoint */
+    GArray         *records;
+    guint           n_records;
+
+    gboolean        section_started;
+    gboolean        used;
+
+} CheckpointTab;
+
+/* The processor state, and the output produced, at a step of the analysis */
+typedef struct
+{
+    guint           step_index;
+    guint           steps_executed;
+
+    gsize           file_contents_index;
+    guint           match_depth;
+    gboolean        file_end_reached;
+    gboolean        section_started;
+
+    ProcessorVariable *variables;
+    GArray         *loop_stack;
+    GArray         *block_stack;
+    GArray         *selection_stack;
+
+    /* Running tabs, CheckpointTabs */
+    GArray         *tabs;
+    /* Storage of the tab record strings */
+    ProcessorArena *arena;
+
+    /* Output produced up to the checkpoint */
+    guint           n_fields;
+    gsize           fields_size;
+    guint           n_records;
+    guint           n_inserted_tabs;
+
+    /* File contents checked up to the checkpoint, and if the file size was */
+    gsize           read_end;
+    gboolean        size_read;
+    /* Lowest offset read until the next checkpoint */
+    gsize           next_read_start;
+    /* Lowest offset read until the end of the analysis,
+     * set on the checkpoints of the analysis being resumed */
+    gsize           suffix_read_start;
+
+} Checkpoint;
+
+struct _ProcessorCheckpoints
+{
+    /* The analyzed format, its definition can be gone by the next analysis
+     * and another one allocated in its place: identified by its serial */
+    guint           serial;
+    guint           run_length;
+    guint           variables_count;
+
+    /* Checkpoint i is taken after i * CHECKPOINT_STEPS steps */
+    GPtrArray      *checkpoints;
+
+    /* The inserted tabs, CheckpointTabs, and the storage of their names */
+    GArray         *inserted_tabs;
+    ProcessorArena *arena;
+
+    /* Output of the whole analysis */
+    guint           steps_executed;
+    guint           n_fields;
+    gsize           fields_size;
+    guint           n_records;
+
+    /* The analysis was cut short by the step limit */
+    gboolean        truncated;
+
+};
+
+
+static void
+checkpoint_tab_clear (gpointer data)
+{
+    CheckpointTab *tab;
+
+    tab = data;
+
+    g_array_unref (tab->records);
+}
+
+static GArray *
+checkpoint_tabs_new (void)
+{
+    GArray *tabs;
+
+    tabs = g_array_new (FALSE, FALSE, sizeof (CheckpointTab));
+    g_array_set_clear_func (tabs, checkpoint_tab_clear);
+
+    return tabs;
+}
+
+static void
+checkpoint_tabs_add (GArray         *tabs,
+                     const gchar    *name,
+                     DescriptionTab *tab)
+{
+    CheckpointTab checkpoint_tab;
+
+    checkpoint_tab.name = name;
+    checkpoint_tab.records = g_array_ref (tab->records);
+    checkpoint_tab.n_records = tab->records->len;
+    checkpoint_tab.section_started = tab->section_started;
+    checkpoint_tab.used = tab->used;
+
+    g_array_append_val (tabs, checkpoint_tab);
+}
+
+static void
+checkpoint_free (gpointer data)
+{
+    Checkpoint *checkpoint;
+
+    checkpoint = data;
+
+    if (checkpoint)
+    {
+        g_free (checkpoint->variables);
+        g_array_unref (checkpoint->loop_stack);
+        g_array_unref (checkpoint->block_stack);
+        g_array_unref (checkpoint->selection_stack);
+        g_array_unref (checkpoint->tabs);
+        processor_arena_unref (checkpoint->arena);
+
+        g_slice_free (Checkpoint, checkpoint);
+    }
+}
+
+static GArray *
+checkpoint_copy_stack (const GArray *stack,
+                       guint         element_size)
+{
+    GArray *copy;
+
+    copy = g_array_sized_new (FALSE, FALSE, element_size, stack->len);
+    g_array_append_vals (copy, stack->data, stack->len);
+
+    return copy;
+}
+
+static void
+checkpoint_restore_stack (GArray       *stack,
+                          const GArray *saved_stack)
+{
+    g_array_set_size (stack, 0);
+    g_array_append_vals (stack, saved_stack->data, saved_stack->len);
+}
+
+static gboolean
+checkpoint_stacks_equal (const GArray *stack,
+                         const GArray *saved_stack,
+                         guint         element_size)
+{
+    return stack->len == saved_stack->len &&
+           !memcmp (stack->data, saved_stack->data, stack->len * element_size);
+}
+
+static gboolean
+checkpoint_variables_equal (const ProcessorVariable *variables,
+                            const ProcessorVariable *saved_variables,
+                            guint                    variables_count)
+{
+    for (guint i = 0; i < variables_count; i++)
+    {
+        if (variables[i].defined != saved_variables[i].defined ||
+            variables[i].failed != saved_variables[i].failed ||
+            variables[i].size != saved_variables[i].size ||
+            variables[i].rational_value != saved_variables[i].rational_value ||
+            memcmp (variables[i].value, saved_variables[i].value, sizeof (variables[i].value)))
+            return FALSE;
+    }
+
+    return TRUE;
+}
+
+/* Running tabs are compared by name and flags, their records are not part of the state */
+static gboolean
+checkpoint_tabs_equal (GHashTable   *tabs,
+                       const GArray *saved_tabs)
+{
+    const CheckpointTab *saved_tab;
+    DescriptionTab *tab;
+
+    if (g_hash_table_size (tabs) != saved_tabs->len)
+        return FALSE;
+
+    for (guint i = 0; i < saved_tabs->len; i++)
+    {
+        saved_tab = &g_array_index (saved_tabs, CheckpointTab, i);
+        tab = g_hash_table_lookup (tabs, saved_tab->name);
+
+        if (!tab ||
+            tab->section_started != saved_tab->section_started ||
+            tab->used != saved_tab->used)
+            return FALSE;
+    }
+
+    return TRUE;
+}
+
+/* Creates a tab holding the first n_records of a saved tab */
+static DescriptionTab *
+checkpoint_restore_tab (ProcessorFile       *file,
+                        const CheckpointTab *saved_tab,
+                        guint                n_records)
+{
+    DescriptionTab *tab;
+
+    tab = processor_utils_new_tab (file, NULL);
+
+    processor_utils_copy_records (tab->records, tab->arena, saved_tab->records, 0, n_records);
+    tab->section_started = saved_tab->section_started;
+    tab->used = saved_tab->used;
+
+    return tab;
+}
+
+/*
+ * Returns the records replacing those of the previous analysis,
+ * records only seen after the convergence are copied to this analysis
+ */
+static GArray *
+checkpoint_move_records (ProcessorFile *file,
+                         GHashTable    *moved_records,
+                         GArray        *records)
+{
+    GArray *new_records;
+
+    new_records = g_hash_table_lookup (moved_records, records);
+
+    if (!new_records)
+    {
+        new_records = g_array_sized_new (FALSE, FALSE, sizeof (DescriptionRecord), records->len);
+        processor_utils_copy_records (new_records, file->description->arena, records, 0, records->len);
+
+        g_hash_table_insert (moved_records, records, new_records);
+    }
+
+    return new_records;
+}
+
+static ProcessorCheckpoints *
+checkpoints_new (const FormatDefinition *format_definition)
+{
+    ProcessorCheckpoints *checkpoints;
+
+    checkpoints = g_slice_new0 (ProcessorCheckpoints);
+
+    checkpoints->serial = format_definition->serial;
+    checkpoints->run_length = format_definition->run_length;
+    checkpoints->variables_count = format_definition->variables_count;
+
+    checkpoints->checkpoints = g_ptr_array_new_with_free_func (checkpoint_free);
+    checkpoints->inserted_tabs = checkpoint_tabs_new ();
+
+    return checkpoints;
+}
+
+void
+processor_checkpoints_free (gpointer data)
+{
+    ProcessorCheckpoints *checkpoints;
+
+    checkpoints = data;
+
+    if (checkpoints)
+    {
+        g_ptr_array_unref (checkpoints->checkpoints);
+        g_array_unref (checkpoints->inserted_tabs);
+        processor_arena_unref (checkpoints->arena);
+
+        g_slice_free (ProcessorCheckpoints, checkpoints);
+    }
+}
+
+/*
+ * Restores the state and output of the previous analysis, at its last checkpoint
+ * that does not depend on the edited contents
+ * Returns FALSE if the analysis must start from the first step
+ */
+gboolean
+processor_checkpoint_resume (const FormatDefinition *format_definition,
+                             ProcessorFile          *file,
+                             ProcessorState         *state,
+                             guint                  *step_index,
+                             guint                  *steps_executed)
+{
+    ProcessorCheckpoints *previous;
+    Checkpoint *checkpoint;
+    CheckpointTab *saved_tab;
+    DescriptionTab *tab;
+
+    guint resume;
+    gsize suffix_read_start;
+
+    file->checkpoints = checkpoints_new (format_definition);
+
+    file->read_start = G_MAXSIZE;
+    file->read_end = 0;
+    file->size_read = FALSE;
+
+    previous = file->previous;
+
+    /* The format must be the same, and its definition unchanged */
+    if (!previous ||
+        previous->serial != format_definition->serial ||
+        previous->run_length != format_definition->run_length ||
+        previous->variables_count != format_definition->variables_count)
+    {
+        g_clear_pointer (&file->previous, processor_checkpoints_free);
+        return FALSE;
+    }
+
+    /* Dependencies only grow, the last valid checkpoint is the one to resume from */
+    for (resume = previous->checkpoints->len; resume; resume--)
+    {
+        checkpoint = g_ptr_array_index (previous->checkpoints, resume - 1);
+
+        if (checkpoint->read_end <= file->edited_start &&
+            (!checkpoint->size_read || !file->edited_resize))
+            break;
+    }
+
+    if (!resume)
+    {
+        g_clear_pointer (&file->previous, processor_checkpoints_free);
+        return FALSE;
+    }
+
+    checkpoint = g_ptr_array_index (previous->checkpoints, --resume);
+
+    /* Restore the output */
+    field_table_append_from (file->file_fields, file->previous_fields, 0, checkpoint->n_fields);
+    file->file_fields_size = checkpoint->fields_size;
+
+    processor_utils_copy_records (file->description->records, file->description->arena,
+                                  file->previous_description->records, 0, checkpoint->n_records);
+    file->section_started = checkpoint->section_started;
+
+    for (guint i = 0; i < checkpoint->n_inserted_tabs; i++)
+    {
+        saved_tab = &g_array_index (previous->inserted_tabs, CheckpointTab, i);
+
+        tab = checkpoint_restore_tab (file, saved_tab, saved_tab->records->len);
+        tab->name = processor_arena_strdup (file->arena, saved_tab->name);
+
+        g_ptr_array_add (file->tabs, tab);
+    }
+
+    /* Restore the state */
+    for (guint i = 0; i < checkpoint->tabs->len; i++)
+    {
+        saved_tab = &g_array_index (checkpoint->tabs, CheckpointTab, i);
+
+        g_hash_table_insert (state->tabs,
+                             (gpointer) saved_tab->name,
+                             checkpoint_restore_tab (file, saved_tab, saved_tab->n_records));
+    }
+
+    memcpy (state->variables, checkpoint->variables,
+            format_definition->variables_count * sizeof (ProcessorVariable));
+
+    checkpoint_restore_stack (state->loop_stack, checkpoint->loop_stack);
+    checkpoint_restore_stack (state->block_stack, checkpoint->block_stack);
+    checkpoint_restore_stack (state->selection_stack, checkpoint->selection_stack);
+
+    state->match_depth = checkpoint->match_depth;
+    state->file_end_reached = checkpoint->file_end_reached;
+
+    file->file_contents_index = checkpoint->file_contents_index;
+    file->read_end = checkpoint->read_end;
+    file->size_read = checkpoint->size_read;
+
+    *step_index = checkpoint->step_index;
+    *steps_executed = checkpoint->steps_executed;
+
+    /* Later checkpoints of the previous analysis are kept to detect convergence */
+    suffix_read_start = G_MAXSIZE;
+    for (guint i = previous->checkpoints->len; i-- > resume + 1;)
+    {
+        checkpoint = g_ptr_array_index (previous->checkpoints, i);
+
+        suffix_read_start = MIN (suffix_read_start, checkpoint->next_read_start);
+        checkpoint->suffix_read_start = suffix_read_start;
+    }
+
+    /* The checkpoints up to the resumed one remain valid */
+    for (guint i = 0; i <= resume; i++)
+    {
+        g_ptr_array_add (file->checkpoints->checkpoints,
+                         g_steal_pointer (&g_ptr_array_index (previous->checkpoints, i)));
+    }
+
+    checkpoint = g_ptr_array_index (file->checkpoints->checkpoints, resume);
+    checkpoint->next_read_start = G_MAXSIZE;
+
+    return TRUE;
+}
+
+/*
+ * Takes a checkpoint, if not already taken
+ */
+void
+processor_checkpoint_save (ProcessorFile        *file,
+                           const ProcessorState *state,
+                           guint                 step_index,
+                           guint                 steps_executed)
+{
+    GPtrArray *checkpoints;
+    Checkpoint *checkpoint, *last_checkpoint;
+
+    GHashTableIter iter;
+    gpointer tab_name, tab;
+
+    checkpoints = file->checkpoints->checkpoints;
+
+    if (steps_executed / CHECKPOINT_STEPS < checkpoints->len)
+        return;
+
+    if (checkpoints->len)
+    {
+        last_checkpoint = g_ptr_array_index (checkpoints, checkpoints->len - 1);
+        last_checkpoint->next_read_start = MIN (last_checkpoint->next_read_start, file->read_start);
+    }
+    file->read_start = G_MAXSIZE;
+
+    checkpoint = g_slice_new (Checkpoint);
+
+    checkpoint->step_index = step_index;
+    checkpoint->steps_executed = steps_executed;
+
+    checkpoint->file_contents_index = file->file_contents_index;
+    checkpoint->match_depth = state->match_depth;
+    checkpoint->file_end_reached = state->file_end_reached;
+    checkpoint->section_started = file->section_started;
+
+    checkpoint->variables = g_new (ProcessorVariable, file->checkpoints->variables_count);
+    memcpy (checkpoint->variables, state->variables,
+            file->checkpoints->variables_count * sizeof (ProcessorVariable));
+
+    checkpoint->loop_stack = checkpoint_copy_stack (state->loop_stack, sizeof (guint));
+    checkpoint->block_stack = checkpoint_copy_stack (state->block_stack, sizeof (guint));
+    checkpoint->selection_stack = checkpoint_copy_stack (state->selection_stack, sizeof (SelectionScope));
+
+    checkpoint->tabs = checkpoint_tabs_new ();
+    checkpoint->arena = processor_arena_ref (file->arena);
+
+    g_hash_table_iter_init (&iter, state->tabs);
+    while (g_hash_table_iter_next (&iter, &tab_name, &tab))
+        checkpoint_tabs_add (checkpoint->tabs, tab_name, tab);
+
+    checkpoint->n_fields = file->file_fields->n_fields;
+    checkpoint->fields_size = file->file_fields_size;
+    checkpoint->n_records = file->description->records->len;
+    checkpoint->n_inserted_tabs = file->tabs->len;
+
+    checkpoint->read_end = file->read_end;
+    checkpoint->size_read = file->size_read;
+    checkpoint->next_read_start = G_MAXSIZE;
+    checkpoint->suffix_read_start = G_MAXSIZE;
+
+    g_ptr_array_add (checkpoints, checkpoint);
+}
+
+/*
+ * Checks if the analysis has reached the state of the previous analysis at
+ * the same step: if the rest of the previous analysis did not read the
+ * edited contents, its output is appended and the analysis is done
+ * Only edits that keep the file size can converge
+ */
+gboolean
+processor_checkpoint_converge (ProcessorFile  *file,
+                               ProcessorState *state,
+                               guint           step_index,
+                               guint          *steps_executed)
+{
+    ProcessorCheckpoints *previous;
+    Checkpoint *checkpoint, *converged, *last_checkpoint;
+    CheckpointTab *saved_tab;
+    DescriptionTab *tab;
+
+    GHashTable *moved_records;
+    GArray *records;
+
+    guint checkpoint_index;
+    guint n_fields, n_records, n_inserted_tabs;
+    guint previous_n_fields, previous_n_records, previous_n_inserted_tabs;
+    gsize fields_size, previous_fields_size;
+
+    previous = file->previous;
+    checkpoint_index = *steps_executed / CHECKPOINT_STEPS;
+
+    if (!previous ||
+        previous->truncated ||
+        file->edited_resize ||
+        checkpoint_index < file->checkpoints->checkpoints->len ||
+        checkpoint_index >= previous->checkpoints->len)
+        return FALSE;
+
+    converged = g_ptr_array_index (previous->checkpoints, checkpoint_index);
+
+    if (converged->suffix_read_start < file->edited_end ||
+        converged->step_index != step_index ||
+        converged->file_contents_index != file->file_contents_index ||
+        converged->match_depth != state->match_depth ||
+        converged->file_end_reached != state->file_end_reached ||
+        converged->section_started != file->section_started ||
+        !checkpoint_stacks_equal (state->loop_stack, converged->loop_stack, sizeof (guint)) ||
+        !checkpoint_stacks_equal (state->block_stack, converged->block_stack, sizeof (guint)) ||
+        !checkpoint_stacks_equal (state->selection_stack, converged->selection_stack,
+                                  sizeof (SelectionScope)) ||
+        !checkpoint_variables_equal (state->variables, converged->variables,
+                                     previous->variables_count) ||
+        !checkpoint_tabs_equal (state->tabs, converged->tabs))
+        return FALSE;
+
+    n_fields = file->file_fields->n_fields;
+    fields_size = file->file_fields_size;
+    n_records = file->description->records->len;
+    n_inserted_tabs = file->tabs->len;
+
+    previous_n_fields = converged->n_fields;
+    previous_fields_size = converged->fields_size;
+    previous_n_records = converged->n_records;
+    previous_n_inserted_tabs = converged->n_inserted_tabs;
+
+    /* Append the output of the rest of the previous analysis */
+    field_table_append_from (file->file_fields, file->previous_fields,
+                             converged->n_fields, previous->n_fields);
+    file->file_fields_size += previous->fields_size - converged->fields_size;
+
+    processor_utils_copy_records (file->description->records, file->description->arena,
+                                  file->previous_description->records,
+                                  converged->n_records, previous->n_records);
+
+    /* The running tabs continue with the records of the previous analysis */
+    moved_records = g_hash_table_new_full (NULL, NULL, NULL, (GDestroyNotify) g_array_unref);
+
+    for (guint i = 0; i < converged->tabs->len; i++)
+    {
+        saved_tab = &g_array_index (converged->tabs, CheckpointTab, i);
+        tab = g_hash_table_lookup (state->tabs, saved_tab->name);
+
+        processor_utils_copy_records (tab->records, tab->arena, saved_tab->records,
+                                      saved_tab->n_records, saved_tab->records->len);
+
+        g_hash_table_insert (moved_records, saved_tab->records, g_array_ref (tab->records));
+    }
+
+    for (guint i = converged->n_inserted_tabs; i < previous->inserted_tabs->len; i++)
+    {
+        saved_tab = &g_array_index (previous->inserted_tabs, CheckpointTab, i);
+
+        tab = processor_arena_new0 (file->arena, DescriptionTab, 1);
+        tab->records = g_array_ref (checkpoint_move_records (file, moved_records, saved_tab->records));
+        tab->arena = file->description->arena;
+        tab->name = processor_arena_strdup (file->arena, saved_tab->name);
+        tab->used = TRUE;
+
+        g_ptr_array_add (file->tabs, tab);
+    }
+
+    /* The rest of the previous checkpoints now describe this analysis */
+    if (file->checkpoints->checkpoints->len)
+    {
+        last_checkpoint = g_ptr_array_index (file->checkpoints->checkpoints,
+                                             file->checkpoints->checkpoints->len - 1);
+        last_checkpoint->next_read_start = MIN (last_checkpoint->next_read_start, file->read_start);
+    }
+    file->read_start = G_MAXSIZE;
+
+    for (guint i = checkpoint_index; i < previous->checkpoints->len; i++)
+    {
+        checkpoint = g_ptr_array_index (previous->checkpoints, i);
+
+        checkpoint->n_fields = checkpoint->n_fields - previous_n_fields + n_fields;
+        checkpoint->fields_size = checkpoint->fields_size - previous_fields_size + fields_size;
+        checkpoint->n_records = checkpoint->n_records - previous_n_records + n_records;
+        checkpoint->n_inserted_tabs = checkpoint->n_inserted_tabs - previous_n_inserted_tabs +
+                                      n_inserted_tabs;
+
+        checkpoint->read_end = MAX (checkpoint->read_end, file->read_end);
+        checkpoint->size_read = checkpoint->size_read || file->size_read;
+
+        for (guint j = 0; j < checkpoint->tabs->len; j++)
+        {
+            saved_tab = &g_array_index (checkpoint->tabs, CheckpointTab, j);
+            records = checkpoint_move_records (file, moved_records, saved_tab->records);
+
+            saved_tab->n_records = saved_tab->n_records + records->len - saved_tab->records->len;
+
+            g_array_unref (saved_tab->records);
+            saved_tab->records = g_array_ref (records);
+        }
+
+        processor_arena_unref (checkpoint->arena);
+        checkpoint->arena = processor_arena_ref (file->arena);
+    }
+
+    for (guint i = checkpoint_index; i < previous->checkpoints->len; i++)
+    {
+        g_ptr_array_add (file->checkpoints->checkpoints,
+                         g_steal_pointer (&g_ptr_array_index (previous->checkpoints, i)));
+    }
+
+    g_hash_table_destroy (moved_records);
+
+    *steps_executed = previous->steps_executed;
+
+    return TRUE;
+}
+
+/*
+ * Completes the checkpoints once the analysis finishes, before the
+ * inserted tabs are moved to the description
+ * The previous analysis is no longer needed
+ */
+void
+processor_checkpoint_finish (ProcessorFile *file,
+                             guint          steps_executed,
+                             gboolean       truncated)
+{
+    ProcessorCheckpoints *checkpoints;
+    Checkpoint *last_checkpoint;
+    DescriptionTab *tab;
+
+    checkpoints = file->checkpoints;
+
+    if (checkpoints->checkpoints->len)
+    {
+        last_checkpoint = g_ptr_array_index (checkpoints->checkpoints,
+                                             checkpoints->checkpoints->len - 1);
+        last_checkpoint->next_read_start = MIN (last_checkpoint->next_read_start, file->read_start);
+    }
+
+    for (guint i = 0; i < file->tabs->len; i++)
+    {
+        tab = g_ptr_array_index (file->tabs, i);
+        checkpoint_tabs_add (checkpoints->inserted_tabs, tab->name, tab);
+    }
+    checkpoints->arena = processor_arena_ref (file->arena);
+
+    checkpoints->steps_executed = steps_executed;
+    checkpoints->n_fields = file->file_fields->n_fields;
+    checkpoints->fields_size = file->file_fields_size;
+    checkpoints->n_records = file->description->records->len;
+    checkpoints->truncated = truncated;
+
+    g_clear_pointer (&file->previous, processor_checkpoints_free);
+    g_clear_pointer (&file->previous_fields, field_table_free);
+    g_clear_pointer (&file->previous_description, file_description_destroy);
+}
@@ -0,0 +1,45 @@
+/* processor-checkpoint.h
+ *
+ * Copyright (C) 2021 - Daniel Léonard Schardijn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "processor-utils.h"
+
+G_BEGIN_DECLS
+
+/* Steps between checkpoints */
+#define CHECKPOINT_STEPS 4096
+
+gboolean    processor_checkpoint_resume     (const FormatDefinition *,
+                                             ProcessorFile *,
+                                             ProcessorState *,
+                                             guint *,
+                                             guint *);
+void        processor_checkpoint_save       (ProcessorFile *,
+                                             const ProcessorState *,
+                                             guint,
+                                             guint);
+gboolean    processor_checkpoint_converge   (ProcessorFile *,
+                                             ProcessorState *,
+                                             guint,
+                                             guint *);
+void        processor_checkpoint_finish     (ProcessorFile *,
+                                             guint,
+                                             gboolean);
+
+G_END_DECLS
@@ -0,0 +1,678 @@
+/* processor-dispatch.c
+ *
+ * Copyright (C) 2021 - Daniel Léonard Schardijn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "processor-utils.h"
+#include "chirurgien-processor.h"
+
+#include <validator/chirurgien-validator.h>
+
+
+/* A format that may be identified, and one of its offset 0 signatures */
+typedef struct
+{
+    const FormatDefinition *format_definition;
+
+    /* Formats are identified in priority order */
+    guint           priority;
+
+    /* The signature, NULL if the format can't be dispatched by it */
+    const guchar   *signature;
+    gsize           signature_size;
+
+} DispatchCandidate;
+
+/* A signature searched for across the whole file, to carve embedded formats */
+typedef struct
+{
+    const FormatDefinition *format_definition;
+    guint           priority;
+
+    /* The offset of the signature from the start of the format */
+    gsize           offset;
+    gsize           size;
+
+    /* The next signature ending at the same automaton state */
+    guint32         next;
+
+} CarvePattern;
+
+#define NO_STATE G_MAXUINT32
+
+/* Bytes scanned between cancellation checks */
+#define CARVE_CHECK_BYTES 0x100000
+
+struct _ProcessorDispatch
+{
+    gint            ref_count;
+
+    /* The indexed formats, kept alive for the analyses using the dispatch */
+    GPtrArray      *formats;
+
+    /* Candidates by the first byte of their signature, in priority order */
+    GArray         *buckets[256];
+
+    /* Candidates that must be identified regardless of the file contents */
+    GArray         *generic;
+
+    /* Carving signatures, and the Aho-Corasick automaton matching them all:
+     * 256 transitions per state, the first signature ending at each state
+     * and the closest state along the failure links where one ends */
+    GArray         *carve_patterns;
+    GArray         *transitions;
+    GArray         *state_patterns;
+    GArray         *output_links;
+
+    /* Greatest distance from the start of a format to the end of its carving signature */
+    gsize           carve_reach;
+
+};
+
+
+/*
+ * Finds the signature every file identified by a magic alternative begins with
+ * Returns FALSE if the alternative can never succeed
+ */
+static gboolean
+dispatch_alternative_signature (GSList     *alternative,
+                                MatchMStep **signature)
+{
+    MagicStep *magic_step;
+
+    *signature = NULL;
+
+    for (GSList *magic_iter = alternative;
+         magic_iter;
+         magic_iter = magic_iter->next)
+    {
+        magic_step = magic_iter->data;
+
+        if (magic_step->step_type != MATCH_STEP)
+            continue;
+
+        /* A match against an empty value always fails */
+        if (!magic_step->match.value || !magic_step->match.value_size)
+            return FALSE;
+
+        /* Offsets read from variables depend on the file */
+        if (!*signature &&
+            (!magic_step->match.offset ||
+             (magic_step->match.offset_op.type == OPERAND_IMMEDIATE &&
+              !magic_step->match.offset_op.immediate)))
+        {
+            *signature = &magic_step->match;
+        }
+    }
+
+    return TRUE;
+}
+
+/*
+ * Finds the longest signature of a magic alternative at a fixed offset,
+ * every file identified by the alternative has it
+ */
+static MatchMStep *
+dispatch_alternative_carve_signature (GSList *alternative)
+{
+    MagicStep *magic_step;
+    MatchMStep *signature = NULL;
+
+    for (GSList *magic_iter = alternative;
+         magic_iter;
+         magic_iter = magic_iter->next)
+    {
+        magic_step = magic_iter->data;
+
+        if (magic_step->step_type != MATCH_STEP ||
+            (magic_step->match.offset &&
+             magic_step->match.offset_op.type != OPERAND_IMMEDIATE))
+            continue;
+
+        if (!magic_step->match.value || !magic_step->match.value_size)
+            return NULL;
+
+        if (!signature || magic_step->match.value_size > signature->value_size)
+            signature = &magic_step->match;
+    }
+
+    return signature;
+}
+
+static guint32
+dispatch_new_state (ProcessorDispatch *dispatch)
+{
+    guint32 state, no_state = NO_STATE;
+
+    state = dispatch->state_patterns->len;
+
+    g_array_set_size (dispatch->transitions, (state + 1) * 256);
+    memset (&g_array_index (dispatch->transitions, guint32, state * 256),
+            0xFF, 256 * sizeof (guint32));
+
+    g_array_append_val (dispatch->state_patterns, no_state);
+    g_array_append_val (dispatch->output_links, no_state);
+
+    return state;
+}
+
+/* Adds a signature to the automaton trie, failure links are resolved afterwards */
+static void
+dispatch_add_carve_pattern (ProcessorDispatch      *dispatch,
+                            const FormatDefinition *format_definition,
+                            guint                   priority,
+                            const MatchMStep       *signature)
+{
+    CarvePattern pattern;
+    const guchar *value;
+
+    guint32 state, next_state, *transition;
+
+    value = signature->value;
+    state = 0;
+
+    for (gsize i = 0; i < signature->value_size; i++)
+    {
+        transition = &g_array_index (dispatch->transitions, guint32, state * 256 + value[i]);
+
+        if (*transition == NO_STATE)
+        {
+            next_state = dispatch_new_state (dispatch);
+
+            /* The array may have been reallocated */
+            g_array_index (dispatch->transitions, guint32, state * 256 + value[i]) = next_state;
+            state = next_state;
+        }
+        else
+        {
+            state = *transition;
+        }
+    }
+
+    pattern.format_definition = format_definition;
+    pattern.priority = priority;
+    pattern.offset = signature->offset ? signature->offset_op.immediate : 0;
+    pattern.size = signature->value_size;
+    pattern.next = g_array_index (dispatch->state_patterns, guint32, state);
+
+    g_array_index (dispatch->state_patterns, guint32, state) = dispatch->carve_patterns->len;
+    g_array_append_val (dispatch->carve_patterns, pattern);
+
+    dispatch->carve_reach = MAX (dispatch->carve_reach, pattern.offset + pattern.size);
+}
+
+/*
+ * Completes the automaton: every missing transition follows the failure link,
+ * resolved breadth-first so that shorter suffixes are always complete
+ */
+static void
+dispatch_build_automaton (ProcessorDispatch *dispatch)
+{
+    GQueue queue = G_QUEUE_INIT;
+
+    guint32 *transitions, *state_patterns, *output_links, *failure_links;
+    guint32 state, child, failure;
+
+    transitions = (guint32 *) dispatch->transitions->data;
+    state_patterns = (guint32 *) dispatch->state_patterns->data;
+    output_links = (guint32 *) dispatch->output_links->data;
+    failure_links = g_new0 (guint32, dispatch->state_patterns->len);
+
+    for (guint c = 0; c < 256; c++)
+    {
+        if (transitions[c] == NO_STATE)
+        {
+            transitions[c] = 0;
+        }
+        else
+        {
+            failure_links[transitions[c]] = 0;
+            g_queue_push_tail (&queue, GUINT_TO_POINTER (transitions[c]));
+        }
+    }
+
+    while (!g_queue_is_empty (&queue))
+    {
+        state = GPOINTER_TO_UINT (g_queue_pop_head (&queue));
+
+        for (guint c = 0; c < 256; c++)
+        {
+            child = transitions[state * 256 + c];
+            failure = transitions[failure_links[state] * 256 + c];
+
+            if (child == NO_STATE)
+            {
+                transitions[state * 256 + c] = failure;
+                continue;
+            }
+
+            failure_links[child] = failure;
+            output_links[child] = state_patterns[failure] != NO_STATE ?
+                                  failure : output_links[failure];
+
+            g_queue_push_tail (&queue, GUINT_TO_POINTER (child));
+        }
+    }
+
+    g_free (failure_links);
+}
+
+static void
+dispatch_add_format (ProcessorDispatch      *dispatch,
+                     const FormatDefinition *format_definition,
+                     guint                   priority)
+{
+    DispatchCandidate candidate;
+    MatchMStep *signature, *carve_signature;
+
+    GSList *signatures = NULL;
+    GArray *bucket;
+    gboolean generic = FALSE;
+
+    candidate = (DispatchCandidate) { .format_definition = format_definition,
+                                      .priority = priority };
+
+    g_ptr_array_add (dispatch->formats, format_definition_ref ((FormatDefinition *) format_definition));
+
+    for (GSList *magic = format_definition->magic;
+         magic;
+         magic = magic->next)
+    {
+        if (!dispatch_alternative_signature (magic->data, &signature))
+            continue;
+
+        if ((carve_signature = dispatch_alternative_carve_signature (magic->data)))
+            dispatch_add_carve_pattern (dispatch, format_definition, priority, carve_signature);
+
+        /* One alternative without a signature makes the whole format generic */
+        if (!signature)
+            generic = TRUE;
+        else
+            signatures = g_slist_prepend (signatures, signature);
+    }
+
+    if (generic)
+    {
+        g_array_append_val (dispatch->generic, candidate);
+        g_slist_free (signatures);
+
+        return;
+    }
+
+    for (GSList *signature_iter = signatures;
+         signature_iter;
+         signature_iter = signature_iter->next)
+    {
+        signature = signature_iter->data;
+
+        candidate.signature = signature->value;
+        candidate.signature_size = signature->value_size;
+
+        bucket = dispatch->buckets[candidate.signature[0]];
+
+        if (!bucket)
+        {
+            bucket = g_array_new (FALSE, FALSE, sizeof (DispatchCandidate));
+            dispatch->buckets[candidate.signature[0]] = bucket;
+        }
+
+        g_array_append_val (bucket, candidate);
+    }
+
+    g_slist_free (signatures);
+}
+
+/*
+ * Builds the dispatch index of the system formats followed by the user formats,
+ * the formats are identified in that order
+ */
+ProcessorDispatch *
+processor_dispatch_new (GSList *system_formats,
+                        GList  *user_formats)
+{
+    ProcessorDispatch *dispatch;
+    guint priority;
+
+    dispatch = g_slice_new0 (ProcessorDispatch);
+    dispatch->ref_count = 1;
+    dispatch->formats = g_ptr_array_new_with_free_func ((GDestroyNotify) format_definition_unref);
+    dispatch->generic = g_array_new (FALSE, FALSE, sizeof (DispatchCandidate));
+
+    dispatch->carve_patterns = g_array_new (FALSE, FALSE, sizeof (CarvePattern));
+    dispatch->transitions = g_array_new (FALSE, FALSE, sizeof (guint32));
+    dispatch->state_patterns = g_array_new (FALSE, FALSE, sizeof (guint32));
+    dispatch->output_links = g_array_new (FALSE, FALSE, sizeof (guint32));
+
+    /* The root state */
+    dispatch_new_state (dispatch);
+
+    priority = 0;
+
+    for (GSList *format_iter = system_formats;
+         format_iter;
+         format_iter = format_iter->next)
+    {
+        dispatch_add_format (dispatch, format_iter->data, priority++);
+    }
+
+    for (GList *format_iter = user_formats;
+         format_iter;
+         format_iter = format_iter->next)
+    {
+        dispatch_add_format (dispatch, format_iter->data, priority++);
+    }
+
+    dispatch_build_automaton (dispatch);
+
+    return dispatch;
+}
+
+ProcessorDispatch *
+processor_dispatch_ref (ProcessorDispatch *dispatch)
+{
+    g_atomic_int_inc (&dispatch->ref_count);
+
+    return dispatch;
+}
+
+void
+processor_dispatch_unref (ProcessorDispatch *dispatch)
+{
+    if (!dispatch || !g_atomic_int_dec_and_test (&dispatch->ref_count))
+        return;
+
+    for (guint i = 0; i < G_N_ELEMENTS (dispatch->buckets); i++)
+    {
+        if (dispatch->buckets[i])
+            g_array_free (dispatch->buckets[i], TRUE);
+    }
+
+    g_array_free (dispatch->generic, TRUE);
+
+    g_array_free (dispatch->carve_patterns, TRUE);
+    g_array_free (dispatch->transitions, TRUE);
+    g_array_free (dispatch->state_patterns, TRUE);
+    g_array_free (dispatch->output_links, TRUE);
+
+    g_ptr_array_unref (dispatch->formats);
+
+    g_slice_free (ProcessorDispatch, dispatch);
+}
+
+/*
+ * Identifies the file, only evaluating the formats whose signature
+ * the file begins with, and the generic formats
+ * Returns NULL if the file format is not recognized
+ */
+const FormatDefinition *
+processor_dispatch_identify (ProcessorDispatch *dispatch,
+                             ProcessorFile     *file)
+{
+    const DispatchCandidate *candidate;
+    const guchar *first_byte;
+
+    GArray *bucket;
+    gsize first_length;
+    guint bucket_index, generic_index, last_priority;
+
+    first_byte = processor_utils_get_chunk (file, 0, &first_length);
+
+    bucket = first_length ? dispatch->buckets[*first_byte] : NULL;
+    bucket_index = generic_index = 0;
+    last_priority = G_MAXUINT;
+
+    /* Merge the file's bucket with the generic candidates, both in priority order */
+    while ((bucket && bucket_index < bucket->len) ||
+           generic_index < dispatch->generic->len)
+    {
+        if (generic_index == dispatch->generic->len ||
+            (bucket && bucket_index < bucket->len &&
+             g_array_index (bucket, DispatchCandidate, bucket_index).priority <
+             g_array_index (dispatch->generic, DispatchCandidate, generic_index).priority))
+        {
+            candidate = &g_array_index (bucket, DispatchCandidate, bucket_index++);
+        }
+        else
+        {
+            candidate = &g_array_index (dispatch->generic, DispatchCandidate, generic_index++);
+        }
+
+        /* A format with several matching signatures is only identified once */
+        if (candidate->priority == last_priority ||
+            candidate->format_definition->disabled)
+            continue;
+
+        if (candidate->signature &&
+            (file->file_size < candidate->signature_size ||
+             memcmp (processor_utils_get_contents (file, 0, candidate->signature_size),
+                     candidate->signature, candidate->signature_size)))
+            continue;
+
+        last_priority = candidate->priority;
+
+        if (format_identify (candidate->format_definition, file))
+            return candidate->format_definition;
+    }
+
+    return NULL;
+}
+
+/* A signature found in the file, and the offset its format would start at */
+typedef struct
+{
+    gsize           offset;
+    guint32         pattern;
+
+} CarveMatch;
+
+/* The state of a carving */
+typedef struct
+{
+    const CarvePattern *patterns;
+
+    /* Signatures found but not verified yet, CarveMatches sorted by offset and priority
+     * Matches before pending_start are already verified */
+    GArray         *pending;
+    guint           pending_start;
+
+    /* The contents, and the file identifying them from each match */
+    ProcessorFile  *contents;
+    ProcessorFile  *file;
+
+    /* EmbeddedFormats */
+    GArray         *embedded_formats;
+
+} CarveState;
+
+static gint
+compare_carve_matches (const CarvePattern *patterns,
+                       const CarveMatch   *match_a,
+                       const CarveMatch   *match_b)
+{
+    if (match_a->offset != match_b->offset)
+        return match_a->offset < match_b->offset ? -1 : 1;
+
+    return (gint) patterns[match_a->pattern].priority - (gint) patterns[match_b->pattern].priority;
+}
+
+static void
+embedded_format_clear (gpointer data)
+{
+    EmbeddedFormat *embedded_format = data;
+
+    g_free (embedded_format->format_name);
+}
+
+/*
+ * Adds a match to the pending ones, keeping them sorted
+ * A format with several signatures found at the same offset is only added once
+ */
+static void
+carve_add_match (CarveState       *carve,
+                 const CarveMatch *match)
+{
+    const CarveMatch *pending;
+    guint low, high, middle;
+    gint comparison;
+
+    pending = (const CarveMatch *) carve->pending->data;
+
+    /* Matches are found in almost increasing offset order, most are appended */
+    low = carve->pending_start;
+    high = carve->pending->len;
+
+    while (low < high)
+    {
+        middle = low + (high - low) / 2;
+        comparison = compare_carve_matches (carve->patterns, &pending[middle], match);
+
+        if (!comparison)
+            return;
+
+        if (comparison < 0)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+
+    g_array_insert_val (carve->pending, low, *match);
+}
+
+/* Identifies the contents from each pending match starting before offset, in offset order */
+static void
+carve_verify_matches (CarveState *carve,
+                      gsize       offset)
+{
+    const CarvePattern *pattern;
+    const CarveMatch *match;
+    EmbeddedFormat embedded_format;
+
+    for (; carve->pending_start < carve->pending->len; carve->pending_start++)
+    {
+        match = &g_array_index (carve->pending, CarveMatch, carve->pending_start);
+
+        if (match->offset >= offset)
+            break;
+
+        pattern = &carve->patterns[match->pattern];
+
+        if (pattern->format_definition->disabled)
+            continue;
+
+        processor_file_set_window (carve->file, carve->contents, match->offset);
+
+        if (format_identify (pattern->format_definition, carve->file))
+        {
+            embedded_format.offset = match->offset;
+            embedded_format.format_name = g_strdup (pattern->format_definition->format_name);
+
+            g_array_append_val (carve->embedded_formats, embedded_format);
+        }
+    }
+
+    /* Verified matches are dropped once they are half of the array */
+    if (carve->pending_start > carve->pending->len / 2)
+    {
+        g_array_remove_range (carve->pending, 0, carve->pending_start);
+        carve->pending_start = 0;
+    }
+}
+
+/*
+ * Carves the formats embedded in the contents: a single pass of the automaton
+ * finds every signature, and each format found is confirmed by identifying
+ * the contents from its offset
+ * Matches are verified during the pass, once no later signature can start before them,
+ * so only the matches within the reach of the longest signature are kept
+ * The contents are scanned a chunk at a time, without copying them
+ * Returns a GArray of EmbeddedFormats sorted by offset, the contents themselves
+ * (offset 0) are not included
+ */
+GArray *
+processor_dispatch_carve (ProcessorDispatch *dispatch,
+                          ProcessorFile     *contents,
+                          GCancellable      *cancellable)
+{
+    CarveState carve;
+    const CarvePattern *pattern;
+    CarveMatch new_match;
+
+    const guint32 *transitions, *state_patterns, *output_links;
+    const guchar *bytes = NULL;
+
+    gsize i, chunk_offset, chunk_length;
+    guint32 state, output_state;
+
+    transitions = (const guint32 *) dispatch->transitions->data;
+    state_patterns = (const guint32 *) dispatch->state_patterns->data;
+    output_links = (const guint32 *) dispatch->output_links->data;
+
+    carve.patterns = (const CarvePattern *) dispatch->carve_patterns->data;
+    carve.pending = g_array_new (FALSE, FALSE, sizeof (CarveMatch));
+    carve.pending_start = 0;
+    carve.contents = contents;
+    /* A single file, to identify the contents from each offset */
+    carve.file = processor_file_create (NULL, 0, NULL);
+    carve.embedded_formats = g_array_new (FALSE, FALSE, sizeof (EmbeddedFormat));
+    g_array_set_clear_func (carve.embedded_formats, embedded_format_clear);
+
+    state = 0;
+
+    for (i = 0, chunk_offset = 0, chunk_length = 0; i < contents->file_size; i++)
+    {
+        if (!(i % CARVE_CHECK_BYTES) && g_cancellable_is_cancelled (cancellable))
+            break;
+
+        if (i - chunk_offset == chunk_length)
+        {
+            chunk_offset = i;
+            bytes = processor_utils_get_chunk (contents, i, &chunk_length);
+        }
+
+        state = transitions[state * 256 + bytes[i - chunk_offset]];
+
+        output_state = state_patterns[state] != NO_STATE ? state : output_links[state];
+
+        for (; output_state != NO_STATE; output_state = output_links[output_state])
+        {
+            for (guint32 p = state_patterns[output_state]; p != NO_STATE; p = carve.patterns[p].next)
+            {
+                pattern = &carve.patterns[p];
+
+                /* The signature ends at i, the format starts before it */
+                if (i + 1 - pattern->size <= pattern->offset)
+                    continue;
+
+                new_match.offset = i + 1 - pattern->size - pattern->offset;
+                new_match.pattern = p;
+
+                carve_add_match (&carve, &new_match);
+            }
+        }
+
+        /* Signatures ending past i start after i + 1 - carve_reach */
+        if (carve.pending_start < carve.pending->len && i + 2 > dispatch->carve_reach)
+            carve_verify_matches (&carve, i + 2 - dispatch->carve_reach);
+    }
+
+    if (!g_cancellable_is_cancelled (cancellable))
+        carve_verify_matches (&carve, G_MAXSIZE);
+
+    processor_file_destroy (carve.file);
+    g_array_free (carve.pending, TRUE);
+
+    return carve.embedded_formats;
+}
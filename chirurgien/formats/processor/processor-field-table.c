@@ -0,0 +1,332 @@
+/* processor-field-table.c
+ *
+ * Copyright (C) 2021 - Daniel Léonard Schardijn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "processor-field-table.h"
+
+
+FieldTable *
+field_table_new (ProcessorArena *arena)
+{
+    FieldTable *table;
+
+    table = g_slice_new0 (FieldTable);
+    table->unused_from = G_MAXUINT;
+
+    table->strings = g_ptr_array_new ();
+    table->string_ids = g_hash_table_new (g_str_hash, g_str_equal);
+    table->arena = processor_arena_ref (arena);
+
+    /* Id 0 is no string */
+    g_ptr_array_add (table->strings, NULL);
+
+    return table;
+}
+
+static guint32
+field_table_intern (FieldTable  *table,
+                    const gchar *string)
+{
+    gpointer id;
+    gchar *interned_string;
+
+    if (!string)
+        return 0;
+
+    if (g_hash_table_lookup_extended (table->string_ids, string, NULL, &id))
+        return GPOINTER_TO_UINT (id);
+
+    interned_string = processor_arena_strdup (table->arena, string);
+
+    g_hash_table_insert (table->string_ids,
+                         interned_string,
+                         GUINT_TO_POINTER (table->strings->len));
+    g_ptr_array_add (table->strings, interned_string);
+
+    return table->strings->len - 1;
+}
+
+static guint8
+field_table_color (guint color_index)
+{
+    return color_index < FIELD_TABLE_NO_COLOR ? color_index : FIELD_TABLE_NO_COLOR;
+}
+
+void
+field_table_append (FieldTable  *table,
+                    gsize        field_offset,
+                    gsize        field_size,
+                    const gchar *field_name,
+                    const gchar *navigation_label,
+                    guint        color_index,
+                    gboolean     background,
+                    guint        additional_color_index)
+{
+    guint field;
+
+    if (table->n_fields == table->allocated)
+    {
+        table->allocated = table->allocated ? table->allocated * 2 : 1024;
+
+        table->offsets = g_renew (guint64, table->offsets, table->allocated);
+        table->sizes = g_renew (guint64, table->sizes, table->allocated);
+        table->names = g_renew (guint32, table->names, table->allocated);
+        table->navigation_labels = g_renew (guint32, table->navigation_labels, table->allocated);
+        table->colors = g_renew (guint8, table->colors, table->allocated);
+        table->additional_colors = g_renew (guint8, table->additional_colors, table->allocated);
+        table->sequences = g_renew (guint32, table->sequences, table->allocated);
+    }
+
+    field = table->n_fields++;
+
+    table->offsets[field] = field_offset;
+    table->sizes[field] = field_size;
+    table->names[field] = field_table_intern (table, field_name);
+    table->navigation_labels[field] = field_table_intern (table, navigation_label);
+    table->colors[field] = field_table_color (color_index) |
+                           (background ? FIELD_TABLE_BACKGROUND : 0);
+    table->additional_colors[field] = field_table_color (additional_color_index);
+    table->sequences[field] = field;
+}
+
+/*
+ * Appends the fields of another table that were appended to it from
+ * first_sequence up to (not including) last_sequence, in their append order
+ */
+void
+field_table_append_from (FieldTable       *table,
+                         const FieldTable *source,
+                         guint             first_sequence,
+                         guint             last_sequence)
+{
+    FileField file_field;
+    guint *rows;
+
+    if (first_sequence >= last_sequence)
+        return;
+
+    rows = g_new (guint, last_sequence - first_sequence);
+
+    for (guint i = 0; i < source->n_fields; i++)
+    {
+        if (source->sequences[i] >= first_sequence &&
+            source->sequences[i] < last_sequence)
+            rows[source->sequences[i] - first_sequence] = i;
+    }
+
+    for (guint i = 0; i < last_sequence - first_sequence; i++)
+    {
+        field_table_get_field (source, rows[i], &file_field);
+
+        field_table_append (table,
+                            file_field.field_offset,
+                            file_field.field_size,
+                            file_field.field_name,
+                            file_field.navigation_label,
+                            file_field.color_index,
+                            file_field.background,
+                            file_field.additional_color_index);
+    }
+
+    g_free (rows);
+}
+
+static gpointer
+field_table_permute (gpointer     column,
+                     gsize        element_size,
+                     const guint *order,
+                     guint        n_fields,
+                     guint        allocated)
+{
+    guint8 *permuted_column;
+
+    permuted_column = g_malloc (element_size * allocated);
+
+    for (guint i = 0; i < n_fields; i++)
+        memcpy (permuted_column + i * element_size,
+                (guint8 *) column + order[i] * element_size,
+                element_size);
+
+    g_free (column);
+
+    return permuted_column;
+}
+
+/*
+ * Sorts the table by offset, fields with the same offset keep their append order
+ * Fields are appended in mostly sorted order, so the table is sorted by
+ * merging its already sorted runs: a sorted table takes a single pass
+ */
+void
+field_table_sort (FieldTable *table)
+{
+    GArray *runs, *merged_runs, *swap_runs;
+    guint *order, *buffer, *swap;
+    guint run_start, middle, run_end, a, b, k;
+
+    runs = g_array_new (FALSE, FALSE, sizeof (guint));
+
+    for (guint i = 0; i < table->n_fields; i++)
+    {
+        if (!i || table->offsets[i] < table->offsets[i - 1])
+            g_array_append_val (runs, i);
+    }
+
+    if (runs->len <= 1)
+    {
+        g_array_free (runs, TRUE);
+        return;
+    }
+
+    order = g_new (guint, table->n_fields);
+    buffer = g_new (guint, table->n_fields);
+    merged_runs = g_array_new (FALSE, FALSE, sizeof (guint));
+
+    for (guint i = 0; i < table->n_fields; i++)
+        order[i] = i;
+
+    /* Merge adjacent runs until a single run is left */
+    while (runs->len > 1)
+    {
+        g_array_set_size (merged_runs, 0);
+
+        for (guint r = 0; r < runs->len; r += 2)
+        {
+            run_start = g_array_index (runs, guint, r);
+            middle = r + 1 < runs->len ? g_array_index (runs, guint, r + 1) : table->n_fields;
+            run_end = r + 2 < runs->len ? g_array_index (runs, guint, r + 2) : table->n_fields;
+
+            g_array_append_val (merged_runs, run_start);
+
+            a = run_start;
+            b = middle;
+            k = run_start;
+
+            while (a < middle && b < run_end)
+            {
+                if (table->offsets[order[b]] < table->offsets[order[a]])
+                    buffer[k++] = order[b++];
+                else
+                    buffer[k++] = order[a++];
+            }
+
+            while (a < middle)
+                buffer[k++] = order[a++];
+            while (b < run_end)
+                buffer[k++] = order[b++];
+        }
+
+        swap = order;
+        order = buffer;
+        buffer = swap;
+
+        swap_runs = runs;
+        runs = merged_runs;
+        merged_runs = swap_runs;
+    }
+
+    table->offsets = field_table_permute (table->offsets, sizeof (guint64),
+                                          order, table->n_fields, table->allocated);
+    table->sizes = field_table_permute (table->sizes, sizeof (guint64),
+                                        order, table->n_fields, table->allocated);
+    table->names = field_table_permute (table->names, sizeof (guint32),
+                                        order, table->n_fields, table->allocated);
+    table->navigation_labels = field_table_permute (table->navigation_labels, sizeof (guint32),
+                                                    order, table->n_fields, table->allocated);
+    table->colors = field_table_permute (table->colors, sizeof (guint8),
+                                         order, table->n_fields, table->allocated);
+    table->additional_colors = field_table_permute (table->additional_colors, sizeof (guint8),
+                                                    order, table->n_fields, table->allocated);
+    table->sequences = field_table_permute (table->sequences, sizeof (guint32),
+                                            order, table->n_fields, table->allocated);
+
+    g_free (order);
+    g_free (buffer);
+    g_array_free (runs, TRUE);
+    g_array_free (merged_runs, TRUE);
+}
+
+/*
+ * Moves every field by offset, the fields of an analysis of
+ * the contents starting at offset are placed in the file
+ */
+void
+field_table_rebase (FieldTable *table,
+                    gsize       offset)
+{
+    for (guint i = 0; i < table->n_fields; i++)
+        table->offsets[i] += offset;
+}
+
+void
+field_table_get_field (const FieldTable *table,
+                       guint             field,
+                       FileField        *file_field)
+{
+    guint8 color;
+
+    color = table->colors[field] & ~FIELD_TABLE_BACKGROUND;
+
+    file_field->field_name = g_ptr_array_index (table->strings, table->names[field]);
+    file_field->field_offset = table->offsets[field];
+    file_field->field_size = table->sizes[field];
+    file_field->color_index = color != FIELD_TABLE_NO_COLOR ? color : G_MAXUINT;
+    file_field->background = table->colors[field] & FIELD_TABLE_BACKGROUND ? TRUE : FALSE;
+    file_field->navigation_label = g_ptr_array_index (table->strings,
+                                                      table->navigation_labels[field]);
+
+    color = table->additional_colors[field];
+    file_field->additional_color_index = color != FIELD_TABLE_NO_COLOR ? color : G_MAXUINT;
+
+    file_field->unused = table->sequences[field] >= table->unused_from;
+}
+
+/* Removes all the fields, keeping the allocated columns */
+void
+field_table_clear (FieldTable *table)
+{
+    table->n_fields = 0;
+    table->unused_from = G_MAXUINT;
+
+    g_ptr_array_set_size (table->strings, 1);
+    g_hash_table_remove_all (table->string_ids);
+}
+
+void
+field_table_free (gpointer data)
+{
+    FieldTable *table;
+
+    table = data;
+
+    if (table)
+    {
+        g_free (table->offsets);
+        g_free (table->sizes);
+        g_free (table->names);
+        g_free (table->navigation_labels);
+        g_free (table->colors);
+        g_free (table->additional_colors);
+        g_free (table->sequences);
+
+        g_ptr_array_unref (table->strings);
+        g_hash_table_destroy (table->string_ids);
+        processor_arena_unref (table->arena);
+
+        g_slice_free (FieldTable, table);
+    }
+}
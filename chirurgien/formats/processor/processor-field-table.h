@@ -0,0 +1,121 @@
+/* processor-field-table.h
+ *
+ * Copyright (C) 2021 - Daniel Léonard Schardijn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <glib.h>
+
+#include "processor-arena.h"
+
+G_BEGIN_DECLS
+
+/* A field of the processor's output, read from a FieldTable
+ * The strings belong to the FieldTable */
+typedef struct
+{
+    /* The name of the field */
+    const gchar   *field_name;
+
+    /* Field offset */
+    gsize          field_offset;
+
+    /* Field size */
+    gsize          field_size;
+
+    /* Field color */
+    guint          color_index;
+
+    /* Color is background or foreground color */
+    gboolean       background; /* TRUE = background, FALSE = foregound*/
+
+    /* Navigation label */
+    const gchar   *navigation_label;
+
+    /* Additional color
+     * If defined, it is used to color the first byte of the field
+     * This helps identify fields when the same color is used to color
+     * many adjacent fields, something that happens often in file formats
+     * that use offset to point to values somewhere else in the file */
+    guint          additional_color_index;
+
+    /* The field covers data no other field covers,
+     * appended by processor_utils_sort_find_unused */
+    gboolean       unused;
+
+} FileField;
+
+/* The processor's output: a struct-of-arrays table of fields,
+ * sorted by offset once the analysis finishes */
+typedef struct
+{
+    /* Field columns */
+    guint64       *offsets;
+    guint64       *sizes;
+    /* Interned string ids, 0 is no string */
+    guint32       *names;
+    guint32       *navigation_labels;
+    /* Color index, FIELD_TABLE_BACKGROUND flags background colors */
+    guint8        *colors;
+    guint8        *additional_colors;
+    /* Append order, kept through sorting */
+    guint32       *sequences;
+    /* Sequence of the first unused data field, G_MAXUINT if none */
+    guint          unused_from;
+
+    guint          n_fields;
+    guint          allocated;
+
+    /* Interned strings, indexed by id */
+    GPtrArray     *strings;
+    GHashTable    *string_ids;
+    /* Storage of the interned strings */
+    ProcessorArena *arena;
+
+} FieldTable;
+
+/* Color column values */
+#define FIELD_TABLE_NO_COLOR   0x7F
+#define FIELD_TABLE_BACKGROUND 0x80
+
+FieldTable *    field_table_new               (ProcessorArena *);
+
+void            field_table_append            (FieldTable *,
+                                               gsize,
+                                               gsize,
+                                               const gchar *,
+                                               const gchar *,
+                                               guint,
+                                               gboolean,
+                                               guint);
+void            field_table_append_from       (FieldTable *,
+                                               const FieldTable *,
+                                               guint,
+                                               guint);
+void            field_table_sort              (FieldTable *);
+void            field_table_rebase            (FieldTable *,
+                                               gsize);
+
+void            field_table_get_field         (const FieldTable *,
+                                               guint,
+                                               FileField *);
+
+void            field_table_clear             (FieldTable *);
+
+void            field_table_free              (gpointer);
+
+G_END_DECLS
@@ -18,31 +18,99 @@
 
 #pragma once
 
-#include <gtk/gtk.h>
+#include <gio/gio.h>
+
+#include <chirurgien-types.h>
 
 G_BEGIN_DECLS
 
+/* A contiguous part of the file contents */
+typedef struct
+{
+    /* Offset of the chunk in the contents */
+    gsize           offset;
+
+    const guchar   *data;
+    gsize           size;
+
+} ProcessorChunk;
+
 struct _ProcessorFile
 {
-    /* File contents and size */
+    /* Allocator of the analysis state and output */
+    ProcessorArena *arena;
+
+    /* File contents and size
+     * The contents are NULL if they are split in chunks */
     gconstpointer   file_contents;
     gsize           file_size;
 
+    /* The chunks of the contents, ProcessorChunks in offset order, shared between files
+     * The file starts at chunks_origin, an offset in the chunks */
+    GArray         *chunks;
+    gsize           chunks_origin;
+    /* Chunk of the last access, accesses are mostly sequential */
+    guint           last_chunk;
+    /* Copy of the last access spanning several chunks */
+    guchar         *chunk_buffer;
+    gsize           chunk_buffer_size;
+
     /* Current file contents index */
     gsize           file_contents_index;
 
-    /* File fields */
-    GSList         *file_fields;
+    /* The format the file was last identified or processed as, referenced:
+     * a format removed meanwhile stays valid for the file's output */
+    FormatDefinition *format_definition;
+
+    /* File fields, and the sum of their sizes */
+    FieldTable     *file_fields;
+    gsize           file_fields_size;
+
+    /* The description, the 'Overview' page records until
+     * the tabs are appended when the analysis finishes */
+    FileDescription *description;
+    /* A description section has been started in the 'Overview' page */
+    gboolean        section_started;
+
+    /* Inserted description tabs, in insertion order */
+    GPtrArray      *tabs;
+
+    /* Dependencies of the analysis on the file contents: the lowest offset
+     * read since the last checkpoint, the end of the contents checked,
+     * and if the file size was */
+    gsize           read_start;
+    gsize           read_end;
+    gboolean        size_read;
+
+    /* The previous analysis of the file, and the range edited since */
+    ProcessorCheckpoints *previous;
+    FieldTable     *previous_fields;
+    FileDescription *previous_description;
+    gsize           edited_start;
+    gsize           edited_end;
+    gboolean        edited_resize;
+
+    /* Processor state containers, reused by every analysis of the file,
+     * and the variables of its identifications */
+    ProcessorState  state;
+    ProcessorVariable *identify_variables;
+    guint           identify_variables_count;
+
+    /* Checkpoints of this analysis, only taken if the next one may resume from them */
+    gboolean        checkpointed;
+    ProcessorCheckpoints *checkpoints;
 
-    /* Description panel container */
-    GtkNotebook    *description;
+    /* Cancels the analysis */
+    GCancellable   *cancellable;
 
-    /* Main description page: 'Overview' page */
-    GtkBox         *overview;
+    /* Analysis progress, read from other threads */
+    gsize           bytes_covered;
+    guint           steps_executed;
 
-    /* Current description section grid and lines count */
-    GtkGrid        *section;
-    guint           description_lines_count;
+    /* Values not matching any of their field's possible values,
+     * and fields that extended past the end of the file */
+    guint           invalid_values;
+    guint           missing_fields;
 
 };
 
@@ -18,33 +18,332 @@
 
 #include "processor-file.h"
 #include "processor-file-private.h"
+#include "processor-utils.h"
+#include "chirurgien-processor.h"
+
+#include <validator/chirurgien-validator.h>
 
 
 ProcessorFile *
 processor_file_create (gconstpointer file_contents,
                        gsize         file_size,
-                       GtkNotebook  *description,
-                       GtkBox       *overview)
+                       GCancellable *cancellable)
 {
     ProcessorFile *processor_file;
 
     processor_file = g_slice_new0 (ProcessorFile);
     processor_file->file_contents = file_contents;
     processor_file->file_size = file_size;
-    processor_file->description = description;
-    processor_file->overview = overview;
+
+    processor_file->arena = processor_arena_new ();
+
+    processor_file->file_fields = field_table_new (processor_file->arena);
+
+    processor_file->description = g_slice_new (FileDescription);
+    processor_file->description->records = g_array_new (FALSE, FALSE, sizeof (DescriptionRecord));
+    processor_file->description->arena = processor_arena_ref (processor_file->arena);
+    processor_file->description->pages = g_array_new (FALSE, TRUE, sizeof (guint));
+    g_array_set_size (processor_file->description->pages, 1);
+
+    processor_file->tabs = g_ptr_array_new_with_free_func (description_tab_destroy);
+
+    processor_file->state.tabs = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                                        NULL, description_tab_destroy);
+    processor_file->state.loop_stack = g_array_new (FALSE, FALSE, sizeof (guint));
+    processor_file->state.block_stack = g_array_new (FALSE, FALSE, sizeof (guint));
+    processor_file->state.selection_stack = g_array_new (FALSE, TRUE, sizeof (SelectionScope));
+    processor_file->state.tooltip_buffer = g_string_new (NULL);
+    processor_file->state.text_buffer = g_string_new (NULL);
+
+    if (cancellable)
+        processor_file->cancellable = g_object_ref (cancellable);
 
     return processor_file;
 }
 
-GSList *
-processor_file_get_field_list (ProcessorFile *processor_file)
+/* Sets the contents to analyze, for files created before their contents are available */
+void
+processor_file_set_contents (ProcessorFile *processor_file,
+                             gconstpointer  file_contents,
+                             gsize          file_size)
+{
+    g_clear_pointer (&processor_file->chunks, g_array_unref);
+
+    processor_file->file_contents = file_contents;
+    processor_file->file_size = file_size;
+}
+
+/*
+ * Appends a contiguous part to the contents, for contents not held in a single buffer
+ * The chunks are not copied, they must outlive the file
+ */
+void
+processor_file_append_chunk (ProcessorFile *processor_file,
+                             gconstpointer  chunk,
+                             gsize          chunk_size)
 {
-    return processor_file->file_fields;
+    ProcessorChunk new_chunk;
+
+    if (!chunk_size)
+        return;
+
+    /* A single chunk is a single buffer */
+    if (!processor_file->file_size && !processor_file->chunks)
+    {
+        processor_file->file_contents = chunk;
+        processor_file->file_size = chunk_size;
+
+        return;
+    }
+
+    if (!processor_file->chunks)
+    {
+        processor_file->chunks = g_array_new (FALSE, FALSE, sizeof (ProcessorChunk));
+
+        new_chunk.offset = 0;
+        new_chunk.data = processor_file->file_contents;
+        new_chunk.size = processor_file->file_size;
+        g_array_append_val (processor_file->chunks, new_chunk);
+
+        processor_file->file_contents = NULL;
+        processor_file->chunks_origin = 0;
+        processor_file->last_chunk = 0;
+    }
+
+    new_chunk.offset = processor_file->chunks_origin + processor_file->file_size;
+    new_chunk.data = chunk;
+    new_chunk.size = chunk_size;
+    g_array_append_val (processor_file->chunks, new_chunk);
+
+    processor_file->file_size += chunk_size;
+}
+
+/* Sets the contents to those of source, from offset on, sharing its buffer or chunks */
+void
+processor_file_set_window (ProcessorFile       *processor_file,
+                           const ProcessorFile *source,
+                           gsize                offset)
+{
+    offset = MIN (offset, source->file_size);
+
+    if (!source->chunks)
+    {
+        processor_file_set_contents (processor_file,
+                                     (const guchar *) source->file_contents + offset,
+                                     source->file_size - offset);
+        return;
+    }
+
+    if (processor_file->chunks != source->chunks)
+    {
+        g_clear_pointer (&processor_file->chunks, g_array_unref);
+        processor_file->chunks = g_array_ref (source->chunks);
+        processor_file->last_chunk = 0;
+    }
+
+    processor_file->file_contents = NULL;
+    processor_file->chunks_origin = source->chunks_origin + offset;
+    processor_file->file_size = source->file_size - offset;
+}
+
+/*
+ * Prepares the file for the analysis of other contents, reusing the allocated output
+ * Only valid if the output of the previous analysis was not transferred
+ */
+void
+processor_file_reset (ProcessorFile *processor_file,
+                      gconstpointer  file_contents,
+                      gsize          file_size)
+{
+    processor_file_set_contents (processor_file, file_contents, file_size);
+    processor_file->file_contents_index = 0;
+
+    field_table_clear (processor_file->file_fields);
+    processor_file->file_fields_size = 0;
+
+    g_array_set_size (processor_file->description->records, 0);
+    g_array_set_size (processor_file->description->pages, 1);
+    processor_file->section_started = FALSE;
+    g_ptr_array_set_size (processor_file->tabs, 0);
+
+    g_clear_pointer (&processor_file->checkpoints, processor_checkpoints_free);
+
+    processor_file->bytes_covered = 0;
+    processor_file->steps_executed = 0;
+    processor_file->invalid_values = 0;
+    processor_file->missing_fields = 0;
+
+    /* The strings of the fields, records and checkpoints are all gone */
+    processor_arena_reset (processor_file->arena);
+}
+
+/*
+ * Resumes the previous analysis of the file, taking ownership of its output
+ * The file was edited from edited_start up to (not including) edited_end,
+ * edited_resize if bytes were inserted or deleted
+ */
+void
+processor_file_resume (ProcessorFile        *processor_file,
+                       ProcessorCheckpoints *checkpoints,
+                       FieldTable           *fields,
+                       FileDescription      *description,
+                       gsize                 edited_start,
+                       gsize                 edited_end,
+                       gboolean              edited_resize)
+{
+    processor_file->previous = checkpoints;
+    processor_file->previous_fields = fields;
+    processor_file->previous_description = description;
+
+    processor_file->edited_start = edited_start;
+    processor_file->edited_end = edited_end;
+    processor_file->edited_resize = edited_resize;
+}
+
+/*
+ * Takes checkpoints during the analyses of the file, for a later analysis
+ * to resume from with processor_file_resume ()
+ * Off by default, the checkpoints are copies of the processor state
+ */
+void
+processor_file_set_checkpointed (ProcessorFile *processor_file,
+                                 gboolean       checkpointed)
+{
+    processor_file->checkpointed = checkpointed;
+}
+
+FieldTable *
+processor_file_get_fields (ProcessorFile *processor_file)
+{
+    return g_steal_pointer (&processor_file->file_fields);
+}
+
+FileDescription *
+processor_file_get_description (ProcessorFile *processor_file)
+{
+    return g_steal_pointer (&processor_file->description);
+}
+
+ProcessorCheckpoints *
+processor_file_get_checkpoints (ProcessorFile *processor_file)
+{
+    return g_steal_pointer (&processor_file->checkpoints);
+}
+
+void
+processor_file_get_progress (ProcessorFile *processor_file,
+                             gsize         *bytes_covered,
+                             guint         *steps_executed)
+{
+    if (bytes_covered)
+        *bytes_covered = (gsize) g_atomic_pointer_get (&processor_file->bytes_covered);
+    if (steps_executed)
+        *steps_executed = g_atomic_int_get (&processor_file->steps_executed);
+}
+
+/* The number of fields of the analysis output, while it has not been transferred */
+guint
+processor_file_get_n_fields (ProcessorFile *processor_file)
+{
+    return processor_file->file_fields->n_fields;
+}
+
+/* Counts of the errors found by the analysis */
+void
+processor_file_get_errors (ProcessorFile *processor_file,
+                           guint         *invalid_values,
+                           guint         *missing_fields)
+{
+    if (invalid_values)
+        *invalid_values = processor_file->invalid_values;
+    if (missing_fields)
+        *missing_fields = processor_file->missing_fields;
 }
 
 void
 processor_file_destroy (ProcessorFile *processor_file)
 {
+    field_table_free (processor_file->file_fields);
+
+    file_description_destroy (processor_file->description);
+    g_ptr_array_unref (processor_file->tabs);
+
+    processor_checkpoints_free (processor_file->checkpoints);
+    processor_checkpoints_free (processor_file->previous);
+    field_table_free (processor_file->previous_fields);
+    file_description_destroy (processor_file->previous_description);
+
+    g_clear_object (&processor_file->cancellable);
+
+    if (processor_file->chunks)
+        g_array_unref (processor_file->chunks);
+    g_free (processor_file->chunk_buffer);
+
+    format_definition_unref (processor_file->format_definition);
+
+    g_hash_table_destroy (processor_file->state.tabs);
+    g_array_free (processor_file->state.loop_stack, TRUE);
+    g_array_free (processor_file->state.block_stack, TRUE);
+    g_array_free (processor_file->state.selection_stack, TRUE);
+    g_string_free (processor_file->state.tooltip_buffer, TRUE);
+    g_string_free (processor_file->state.text_buffer, TRUE);
+    g_free (processor_file->identify_variables);
+
+    processor_arena_unref (processor_file->arena);
+
     g_slice_free (ProcessorFile, processor_file);
 }
+
+/* References the format the file is analyzed as, NULL if unrecognized */
+void
+processor_file_set_format (ProcessorFile          *processor_file,
+                           const FormatDefinition *format_definition)
+{
+    if (processor_file->format_definition == format_definition)
+        return;
+
+    format_definition_unref (processor_file->format_definition);
+    processor_file->format_definition = format_definition ?
+                                        format_definition_ref ((FormatDefinition *) format_definition) :
+                                        NULL;
+}
+
+void
+file_description_destroy (gpointer data)
+{
+    FileDescription *description;
+
+    description = data;
+
+    if (description)
+    {
+        g_array_unref (description->records);
+        processor_arena_unref (description->arena);
+        g_array_unref (description->pages);
+
+        g_slice_free (FileDescription, description);
+    }
+}
+
+guint
+file_description_get_n_pages (const FileDescription *description)
+{
+    return description->pages->len;
+}
+
+/*
+ * Gets the records of a page, from first_record up to (not including) last_record
+ */
+void
+file_description_get_page (const FileDescription *description,
+                           guint                  page,
+                           guint                 *first_record,
+                           guint                 *last_record)
+{
+    *first_record = g_array_index (description->pages, guint, page);
+
+    if (page + 1 < description->pages->len)
+        *last_record = g_array_index (description->pages, guint, page + 1);
+    else
+        *last_record = description->records->len;
+}
@@ -18,47 +18,127 @@
 
 #pragma once
 
-#include <gtk/gtk.h>
+#include <gio/gio.h>
+
+#include "processor-field-table.h"
 
 G_BEGIN_DECLS
 
-/* The processor's output: a list of FileFields */
+/* Description record types */
+typedef enum
+{
+    DESCRIPTION_TITLE,
+    DESCRIPTION_SECTION,
+    DESCRIPTION_LINE,
+    DESCRIPTION_NOTE,
+    DESCRIPTION_TEXT,
+    DESCRIPTION_TAB
+
+} DescriptionRecordType;
+
+/* A description record, its strings belong to the FileDescription */
 typedef struct
 {
-    /* The name of the field */
-    gchar         *field_name;
+    /* Title, section name, line name, note, text field name or tab name */
+    const gchar   *name;
+
+    /* Line value or text field contents
+     * The text is NULL if it has an invalid encoding */
+    const gchar   *value;
+
+    /* Line tooltip */
+    const gchar   *tooltip;
+
+    /* The record's type, a DescriptionRecordType */
+    guint8         type;
+
+    /* Line margins */
+    guint16        margin_top;
+    guint16        margin_bottom;
+
+} DescriptionRecord;
 
-    /* Field offset */
-    gsize          field_offset;
+/* The processor's description output: a stream of DescriptionRecords
+ * Records are added to the 'Overview' page, until a DESCRIPTION_TAB record
+ * starts a new page */
+typedef struct
+{
+    /* DescriptionRecords, stored by value */
+    GArray        *records;
 
-    /* Field size */
-    gsize          field_size;
+    /* Storage of all the record strings */
+    ProcessorArena *arena;
 
-    /* Field color */
-    guint          color_index;
+    /* Index of the first record of each page, the 'Overview' page is page 0 */
+    GArray        *pages;
 
-    /* Color is background or foreground color */
-    gboolean       background; /* TRUE = background, FALSE = foregound*/
+} FileDescription;
 
-    /* Navigation label */
-    gchar         *navigation_label;
+/* A format found embedded in the file, when carving */
+typedef struct
+{
+    /* Offset of the embedded format */
+    gsize          offset;
 
-    /* Additional color
-     * If defined, it is used to color the first byte of the field
-     * This helps identify fields when the same color is used to color
-     * many adjacent fields, something that happens often in file formats
-     * that use offset to point to values somewhere else in the file */
-    guint          additional_color_index;
+    /* The format's name */
+    gchar         *format_name;
 
-} FileField;
+} EmbeddedFormat;
 
 typedef struct _ProcessorFile ProcessorFile;
 
-ProcessorFile *    processor_file_create            (gconstpointer,
-                                                     gsize,
-                                                     GtkNotebook *,
-                                                     GtkBox *);
-GSList *           processor_file_get_field_list    (ProcessorFile *);
-void               processor_file_destroy           (ProcessorFile *);
+/* Snapshots of the processor state taken during an analysis,
+ * used to resume the next analysis of the file after an edit */
+typedef struct _ProcessorCheckpoints ProcessorCheckpoints;
+
+ProcessorFile *    processor_file_create             (gconstpointer,
+                                                      gsize,
+                                                      GCancellable *);
+void               processor_file_set_contents       (ProcessorFile *,
+                                                      gconstpointer,
+                                                      gsize);
+void               processor_file_append_chunk       (ProcessorFile *,
+                                                      gconstpointer,
+                                                      gsize);
+void               processor_file_set_window         (ProcessorFile *,
+                                                      const ProcessorFile *,
+                                                      gsize);
+void               processor_file_reset              (ProcessorFile *,
+                                                      gconstpointer,
+                                                      gsize);
+void               processor_file_resume             (ProcessorFile *,
+                                                      ProcessorCheckpoints *,
+                                                      FieldTable *,
+                                                      FileDescription *,
+                                                      gsize,
+                                                      gsize,
+                                                      gboolean);
+void               processor_file_set_checkpointed   (ProcessorFile *,
+                                                      gboolean);
+
+/* Transfer the processor's output to the caller */
+FieldTable *       processor_file_get_fields         (ProcessorFile *);
+FileDescription *  processor_file_get_description    (ProcessorFile *);
+ProcessorCheckpoints *
+                   processor_file_get_checkpoints    (ProcessorFile *);
+
+void               processor_file_get_progress       (ProcessorFile *,
+                                                      gsize *,
+                                                      guint *);
+guint              processor_file_get_n_fields       (ProcessorFile *);
+void               processor_file_get_errors         (ProcessorFile *,
+                                                      guint *,
+                                                      guint *);
+void               processor_file_destroy            (ProcessorFile *);
+
+void               file_description_destroy          (gpointer);
+void               processor_checkpoints_free        (gpointer);
+
+/* FileDescription page access */
+guint              file_description_get_n_pages      (const FileDescription *);
+void               file_description_get_page         (const FileDescription *,
+                                                      guint,
+                                                      guint *,
+                                                      guint *);
 
 G_END_DECLS
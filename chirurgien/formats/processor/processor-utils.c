@@ -20,92 +20,43 @@
 
 
 static void
-create_section (GtkWidget  **expander,
-                GtkWidget  **grid,
-                const gchar *section_name)
+add_record (GArray         *records,
+            ProcessorArena *arena,
+            guint8          type,
+            const gchar    *name,
+            const gchar    *value,
+            const gchar    *tooltip,
+            gint            margin_top,
+            gint            margin_bottom)
 {
-    *grid = gtk_grid_new ();
-    gtk_grid_set_column_spacing (GTK_GRID (*grid), 10);
-    gtk_widget_set_margin_start (*grid, 10);
-    gtk_widget_set_margin_end (*grid, 10);
-    gtk_widget_set_margin_top (*grid, 10);
-    gtk_widget_set_margin_bottom (*grid, 10);
-    gtk_widget_set_halign (*grid, GTK_ALIGN_CENTER);
-
-    *expander = gtk_expander_new (section_name);
-    gtk_expander_set_child (GTK_EXPANDER (*expander), *grid);
-    gtk_expander_set_expanded (GTK_EXPANDER (*expander), TRUE);
-}
+    DescriptionRecord record;
 
-static void
-create_line_labels (GtkWidget  **left_label,
-                    GtkWidget  **right_label,
-                    const gchar *field_name,
-                    const gchar *field_value,
-                    const gchar *field_tooltip,
-                    gint         margin_top,
-                    gint         margin_bottom)
-{
-    *left_label = gtk_label_new (NULL);
-    gtk_label_set_markup (GTK_LABEL (*left_label), field_name);
-    gtk_label_set_wrap (GTK_LABEL (*left_label), TRUE);
-    gtk_label_set_xalign (GTK_LABEL (*left_label), 1.0f);
-    gtk_widget_set_halign (*left_label, GTK_ALIGN_END);
-    gtk_widget_set_margin_top (*left_label, margin_top);
-    gtk_widget_set_margin_bottom (*left_label, margin_bottom);
-    gtk_widget_add_css_class (*left_label, "dim-label");
-
-    if (field_tooltip)
-        gtk_widget_set_tooltip_markup (GTK_WIDGET (*left_label), field_tooltip);
-
-    *right_label = gtk_label_new (NULL);
-    gtk_label_set_markup (GTK_LABEL (*right_label), field_value);
-    gtk_label_set_wrap (GTK_LABEL (*right_label), TRUE);
-    gtk_label_set_xalign (GTK_LABEL (*right_label), 0.0f);
-    gtk_widget_set_halign (*right_label, GTK_ALIGN_START);
-    gtk_widget_set_margin_top (*right_label, margin_top);
-    gtk_widget_set_margin_bottom (*right_label, margin_bottom);
+    record.name = processor_arena_strdup (arena, name);
+    record.value = processor_arena_strdup (arena, value);
+    record.tooltip = processor_arena_strdup (arena, tooltip);
+    record.type = type;
+    record.margin_top = CLAMP (margin_top, 0, G_MAXUINT16);
+    record.margin_bottom = CLAMP (margin_bottom, 0, G_MAXUINT16);
+
+    g_array_append_val (records, record);
 }
 
 void
 processor_utils_set_title (ProcessorFile *file,
                            const char    *title)
 {
-    GtkWidget *label;
-    PangoAttrList *attribute_list;
-    PangoAttribute *size, *weight;
-
-    attribute_list = pango_attr_list_new ();
-
-    weight = pango_attr_weight_new (PANGO_WEIGHT_BOLD);
-    size = pango_attr_scale_new (PANGO_SCALE_LARGE);
-
-    weight->start_index = size->start_index = PANGO_ATTR_INDEX_FROM_TEXT_BEGINNING;
-    weight->end_index = size->end_index = PANGO_ATTR_INDEX_TO_TEXT_END;
-
-    pango_attr_list_insert (attribute_list, weight);
-    pango_attr_list_insert (attribute_list, size);
-
-    label = gtk_label_new (title);
-    gtk_label_set_attributes (GTK_LABEL (label), attribute_list);
-
-    pango_attr_list_unref (attribute_list);
-
-    gtk_box_append (file->overview, label);
+    add_record (file->description->records, file->description->arena,
+                DESCRIPTION_TITLE, title, NULL, NULL, 0, 0);
 }
 
 void
 processor_utils_start_section (ProcessorFile *file,
                                const gchar   *section_name)
 {
-    GtkWidget *expander, *grid;
-
-    create_section (&expander, &grid, section_name);
-
-    gtk_box_append (file->overview, expander);
+    add_record (file->description->records, file->description->arena,
+                DESCRIPTION_SECTION, section_name, NULL, NULL, 0, 0);
 
-    file->section = GTK_GRID (grid);
-    file->description_lines_count = 0;
+    file->section_started = TRUE;
 }
 
 void
@@ -116,35 +67,27 @@ processor_utils_add_line (ProcessorFile *file,
                           gint           margin_top,
                           gint           margin_bottom)
 {
-    GtkWidget *left_label, *right_label;
-
     if (!field_name)
         return;
 
-    if (!file->section)
+    if (!file->section_started)
         processor_utils_start_section (file, "[UNNAMED SECTION]");
 
-    create_line_labels (&left_label, &right_label,
-                        field_name, field_value, field_tooltip,
-                        margin_top, margin_bottom);
-
-    gtk_grid_attach (GTK_GRID (file->section), left_label, 0, file->description_lines_count++, 1, 1);
-    gtk_grid_attach_next_to (GTK_GRID (file->section), right_label, left_label, GTK_POS_RIGHT, 1, 1);
+    add_record (file->description->records, file->description->arena,
+                DESCRIPTION_LINE, field_name, field_value, field_tooltip,
+                margin_top, margin_bottom);
 }
 
 DescriptionTab *
-processor_utils_new_tab (const gchar *section_name)
+processor_utils_new_tab (ProcessorFile *file,
+                         const gchar   *section_name)
 {
     DescriptionTab *tab;
 
-    tab = g_slice_new0 (DescriptionTab);
+    tab = processor_arena_new0 (file->arena, DescriptionTab, 1);
 
-    tab->contents = GTK_BOX (gtk_box_new (GTK_ORIENTATION_VERTICAL, 10));
-    gtk_widget_set_can_focus (GTK_WIDGET (tab->contents), FALSE);
-    gtk_widget_set_margin_start (GTK_WIDGET (tab->contents), 10);
-    gtk_widget_set_margin_end (GTK_WIDGET (tab->contents), 10);
-    gtk_widget_set_margin_top (GTK_WIDGET (tab->contents), 10);
-    gtk_widget_set_margin_bottom (GTK_WIDGET (tab->contents), 10);
+    tab->records = g_array_new (FALSE, FALSE, sizeof (DescriptionRecord));
+    tab->arena = file->description->arena;
 
     if (section_name)
         processor_utils_start_section_tab (tab, section_name);
@@ -158,14 +101,10 @@ void
 processor_utils_start_section_tab (DescriptionTab *tab,
                                    const gchar    *section_name)
 {
-    GtkWidget *expander, *grid;
+    add_record (tab->records, tab->arena,
+                DESCRIPTION_SECTION, section_name, NULL, NULL, 0, 0);
 
-    create_section (&expander, &grid, section_name);
-
-    gtk_box_append (tab->contents, expander);
-
-    tab->section = GTK_GRID (grid);
-    tab->description_lines_count = 0;
+    tab->section_started = TRUE;
 }
 
 void
@@ -176,20 +115,15 @@ processor_utils_add_line_tab (DescriptionTab *tab,
                               gint            margin_top,
                               gint            margin_bottom)
 {
-    GtkWidget *left_label, *right_label;
-
     if (!field_name)
         return;
 
-    if (!tab->section)
+    if (!tab->section_started)
         processor_utils_start_section_tab (tab, "[UNNAMED SECTION]");
 
-    create_line_labels (&left_label, &right_label,
-                        field_name, field_value, field_tooltip,
-                        margin_top, margin_bottom);
-
-    gtk_grid_attach (GTK_GRID (tab->section), left_label, 0, tab->description_lines_count++, 1, 1);
-    gtk_grid_attach_next_to (GTK_GRID (tab->section), right_label, left_label, GTK_POS_RIGHT, 1, 1);
+    add_record (tab->records, tab->arena,
+                DESCRIPTION_LINE, field_name, field_value, field_tooltip,
+                margin_top, margin_bottom);
 
     tab->used = TRUE;
 }
@@ -198,44 +132,15 @@ void
 processor_utils_add_note_tab (DescriptionTab *tab,
                               const gchar    *line)
 {
-    GtkWidget *label;
-
     if (!line)
         return;
 
-    label = gtk_label_new (NULL);
-    gtk_label_set_markup (GTK_LABEL (label), line);
-    gtk_label_set_wrap (GTK_LABEL (label), TRUE);
-    gtk_label_set_xalign (GTK_LABEL (label), 0.0f);
-    gtk_widget_set_halign (label, GTK_ALIGN_START);
-    gtk_widget_add_css_class (label, "dim-label");
-
-    gtk_box_append (tab->contents, label);
+    add_record (tab->records, tab->arena,
+                DESCRIPTION_NOTE, line, NULL, NULL, 0, 0);
 
     tab->used = TRUE;
 }
 
-static void
-validate_insert_text (GtkTextBuffer *buffer,
-                      const gchar   *text,
-                      gsize          text_size)
-{
-    GtkTextIter start;
-
-    text_size = strnlen (text, text_size);
-
-    if (g_utf8_validate_len (text, text_size, NULL))
-    {
-        gtk_text_buffer_set_text (buffer, text, text_size);
-    }
-    else
-    {
-        gtk_text_buffer_get_start_iter (buffer, &start);
-        gtk_text_buffer_insert_markup (buffer, &start,
-                     "<span foreground=\"red\">[INVALID ENCODING]</span>", -1);
-    }
-}
-
 void
 processor_utils_add_text_tab (DescriptionTab *tab,
                               const gchar    *field_name,
@@ -243,26 +148,17 @@ processor_utils_add_text_tab (DescriptionTab *tab,
                               gsize           text_size,
                               TextEncoding    encoding)
 {
-    GtkWidget *textview, *expander;
-    GtkTextBuffer *buffer;
+    DescriptionRecord *record;
 
     gsize print_text_size;
     gchar *converted_text, *truncated_message;
+    const gchar *print_text;
 
     gsize utf8_size;
 
     if (!tab || !text_size)
         return;
 
-    textview = gtk_text_view_new ();
-    gtk_widget_set_margin_start (textview, 10);
-    gtk_widget_set_margin_end (textview, 10);
-    gtk_widget_set_margin_bottom (textview, 10);
-    gtk_widget_set_margin_top (textview, 10);
-    gtk_text_view_set_editable (GTK_TEXT_VIEW (textview), FALSE);
-    gtk_text_view_set_cursor_visible (GTK_TEXT_VIEW (textview), FALSE);
-    buffer = gtk_text_view_get_buffer (GTK_TEXT_VIEW (textview));
-
     switch (encoding)
     {
         case ENCODING_UTF8:
@@ -297,17 +193,20 @@ processor_utils_add_text_tab (DescriptionTab *tab,
         break;
     }
 
+    print_text = converted_text ? converted_text : text;
     print_text_size = utf8_size > 4096 ? 4096 : utf8_size;
-    validate_insert_text (buffer,
-                          converted_text ? converted_text : text,
-                          print_text_size);
-    g_free (converted_text);
+    print_text_size = strnlen (print_text, print_text_size);
 
-    expander = gtk_expander_new (field_name);
-    gtk_expander_set_child (GTK_EXPANDER (expander), textview);
-    gtk_expander_set_expanded (GTK_EXPANDER (expander), TRUE);
+    add_record (tab->records, tab->arena,
+                DESCRIPTION_TEXT, field_name, NULL, NULL, 0, 0);
 
-    gtk_box_append (GTK_BOX (tab->contents), expander);
+    /* Invalid text is left as NULL */
+    if (g_utf8_validate_len (print_text, print_text_size, NULL))
+    {
+        record = &g_array_index (tab->records, DescriptionRecord, tab->records->len - 1);
+        record->value = processor_arena_strndup (tab->arena, print_text, print_text_size);
+    }
+    g_free (converted_text);
 
     if (utf8_size > 4096)
     {
@@ -320,23 +219,70 @@ processor_utils_add_text_tab (DescriptionTab *tab,
     tab->used = TRUE;
 }
 
+/* Copies the records from first up to (not including) last, with their strings */
+void
+processor_utils_copy_records (GArray         *records,
+                              ProcessorArena *arena,
+                              const GArray   *source,
+                              guint           first,
+                              guint           last)
+{
+    const DescriptionRecord *record;
+
+    for (guint i = first; i < last; i++)
+    {
+        record = &g_array_index (source, DescriptionRecord, i);
+
+        add_record (records, arena, record->type,
+                    record->name, record->value, record->tooltip,
+                    record->margin_top, record->margin_bottom);
+    }
+}
+
 void
 processor_utils_insert_tab (ProcessorFile  *file,
                             DescriptionTab *tab,
                             const gchar    *tab_name)
 {
-    GtkWidget *scrolled, *label;
+    DescriptionTab *inserted_tab;
 
-    if (!tab->used)
+    if (!tab->used || !tab->records)
         return;
 
-    scrolled = gtk_scrolled_window_new ();
-    gtk_scrolled_window_set_child (GTK_SCROLLED_WINDOW (scrolled),
-                                   GTK_WIDGET (tab->contents));
+    /* The tab itself is destroyed when removed from the running tabs,
+     * its records are moved to the inserted tab */
+    inserted_tab = processor_arena_new0 (file->arena, DescriptionTab, 1);
+    inserted_tab->records = g_steal_pointer (&tab->records);
+    inserted_tab->arena = tab->arena;
+    inserted_tab->name = processor_arena_strdup (tab->arena, tab_name);
+    inserted_tab->used = TRUE;
+
+    g_ptr_array_add (file->tabs, inserted_tab);
+}
+
+void
+processor_utils_finish_description (ProcessorFile *file)
+{
+    FileDescription *description;
+    DescriptionTab *tab;
+
+    description = file->description;
+
+    /* Tabs are appended after the 'Overview' page, in insertion order */
+    for (guint i = 0; i < file->tabs->len; i++)
+    {
+        tab = g_ptr_array_index (file->tabs, i);
+
+        g_array_append_val (description->pages, description->records->len);
 
-    label = gtk_label_new (tab_name);
+        add_record (description->records, description->arena,
+                    DESCRIPTION_TAB, tab->name, NULL, NULL, 0, 0);
 
-    gtk_notebook_insert_page (file->description, scrolled, label, -1);
+        g_array_append_vals (description->records,
+                             tab->records->data, tab->records->len);
+    }
+
+    g_ptr_array_set_size (file->tabs, 0);
 }
 
 void
@@ -348,30 +294,27 @@ processor_utils_add_field (ProcessorFile *file,
                            const gchar   *navigation_label,
                            guint          additional_color_index)
 {
-    FileField *new_field;
-    gsize available_data;
-
-    available_data = file->file_size - file->file_contents_index;
-
     if (!field_size ||
-        !field_name ||
-        field_size > available_data ||
-        file->file_size <= file->file_contents_index)
+        !field_name)
     {
         return;
     }
 
-    new_field = g_slice_new (FileField);
-
-    new_field->field_name = g_strdup (field_name);
-    new_field->field_offset = file->file_contents_index;
-    new_field->field_size = field_size;
-    new_field->color_index = color_index;
-    new_field->background = background;
-    new_field->navigation_label = g_strdup (navigation_label);
-    new_field->additional_color_index = additional_color_index;
+    if (!FILE_HAS_DATA_N (file, field_size))
+    {
+        file->missing_fields++;
+        return;
+    }
 
-    file->file_fields = g_slist_prepend (file->file_fields, new_field);
+    field_table_append (file->file_fields,
+                        file->file_contents_index,
+                        field_size,
+                        field_name,
+                        navigation_label,
+                        color_index,
+                        background,
+                        additional_color_index);
+    file->file_fields_size += field_size;
 
     file->file_contents_index += field_size;
 }
@@ -391,11 +334,10 @@ get_format_endianness (const FormatDefinition *format_definition,
         return TRUE;
     }
     else if (format_definition->endianness == VARIABLE_ENDIANNESS &&
-             format_definition->endianness_var)
+             state->endianness_slot != G_MAXUINT)
     {
-        endianness = g_hash_table_lookup (state->variables,
-                                          format_definition->endianness_var);
-        if (endianness)
+        endianness = &state->variables[state->endianness_slot];
+        if (endianness->defined)
         {
             if (!memcmp (endianness->value,
                          format_definition->be_value,
@@ -418,20 +360,28 @@ get_format_endianness (const FormatDefinition *format_definition,
 gboolean
 processor_utils_read (const FormatDefinition *format_definition,
                       const ProcessorState   *state,
-                      const ProcessorFile    *file,
+                      ProcessorFile          *file,
                       const FieldDefinition  *field_def,
+                      gsize                   field_size,
                       gboolean                convert_endianness,
                       gpointer                buffer)
 {
     gboolean little_endian;
 
-    if (!field_def->size)
+    if (!field_size)
         return TRUE;
 
-    if (FILE_HAS_DATA_N (file, field_def->size))
-        memcpy (buffer, GET_CONTENT_POINTER (file), field_def->size);
+    if (FILE_HAS_DATA_N (file, field_size))
+    {
+        processor_utils_depend (file,
+                                file->file_contents_index,
+                                file->file_contents_index + field_size);
+        memcpy (buffer, GET_CONTENT_POINTER (file, field_size), field_size);
+    }
     else
+    {
         return FALSE;
+    }
 
     if (convert_endianness ||
         field_def->convert_endianness ||
@@ -440,7 +390,7 @@ processor_utils_read (const FormatDefinition *format_definition,
     {
         little_endian = get_format_endianness (format_definition, state);
 
-        switch (field_def->size)
+        switch (field_size)
         {
             case 2:
             if (little_endian)
@@ -472,7 +422,7 @@ processor_utils_read (const FormatDefinition *format_definition,
 
     if (field_def->shift || field_def->mask)
     {
-        switch (field_def->size)
+        switch (field_size)
         {
             case 1:
             if (field_def->shift)
@@ -547,12 +497,12 @@ processor_utils_format_byte_order (const FormatDefinition *format_definition,
 }
 
 void
-processor_utils_read_value (const ProcessorState *state,
-                            const gchar          *value,
-                            ReadValueType         read_type,
-                            ProcessorVariable   **return_var,
-                            gpointer              return_value,
-                            gboolean              signed_value)
+processor_utils_read_operand (const ProcessorState *state,
+                              const Operand        *operand,
+                              ReadValueType         read_type,
+                              ProcessorVariable   **return_var,
+                              gpointer              return_value,
+                              gboolean              signed_value)
 {
     ProcessorVariable *processor_var;
 
@@ -561,14 +511,13 @@ processor_utils_read_value (const ProcessorState *state,
     if (return_value)
         *(guint64 *) return_value = 0;
 
-    if (value)
+    if (operand->type != OPERAND_NONE)
     {
         /* Look for the processor variable */
-        if (read_type & READ_VARIABLE)
+        if ((read_type & READ_VARIABLE) && operand->type == OPERAND_VARIABLE)
         {
-            processor_var = g_hash_table_lookup (state->variables,
-                                                 value);
-            if (processor_var)
+            processor_var = &state->variables[operand->slot];
+            if (processor_var->defined)
             {
                 switch (processor_var->size)
                 {
@@ -656,47 +605,11 @@ processor_utils_read_value (const ProcessorState *state,
         /* Read value as a decimal number */
         if ((read_type & READ_NUMERIC) && return_value)
         {
-             *(guint64 *) return_value = g_ascii_strtoull (value, NULL, 10);
+             *(guint64 *) return_value = operand->immediate;
         }
     }
 }
 
-GSList *
-processor_utils_skip_steps (GSList     *run_iter,
-                            RunStepType skip_to_nesting,
-                            RunStepType skip_to)
-{
-    const RunStep *run_step;
-    guint step_nesting;
-
-    for (step_nesting = 1; run_iter; run_iter = run_iter->next)
-    {
-        run_step = run_iter->data;
-
-        if (run_step->step_type == skip_to_nesting)
-            step_nesting++;
-        else if (run_step->step_type == skip_to)
-            step_nesting--;
-
-        if (!step_nesting)
-            break;
-    }
-
-    return run_iter;
-}
-
-static gint
-sort_file_fields (gconstpointer a,
-                  gconstpointer b)
-{
-    const FileField *field_a, *field_b;
-
-    field_a = a;
-    field_b = b;
-
-    return field_a->field_offset - field_b->field_offset;
-}
-
 void
 processor_utils_sort_find_unused (const FormatDefinition *format_definition,
                                   ProcessorFile          *file)
@@ -704,14 +617,15 @@ processor_utils_sort_find_unused (const FormatDefinition *format_definition,
     const FieldDefinition *field_def;
     const FormatColor *format_color;
 
-    FileField *file_field, *unused_data;
-    GSList *new_fields;
+    FieldTable *file_fields;
+    const gchar *unused_data;
     gsize tagged_up_to, field_end;
+    guint n_fields;
 
-    new_fields = NULL;
+    file_fields = file->file_fields;
     tagged_up_to = 0;
 
-    file->file_fields = g_slist_sort (file->file_fields, sort_file_fields);
+    field_table_sort (file_fields);
 
     field_def = g_hash_table_lookup (format_definition->fields,
                                      "unused-data");
@@ -723,25 +637,27 @@ processor_utils_sort_find_unused (const FormatDefinition *format_definition,
     if (!format_color)
         return;
 
-    for (GSList *i = file->file_fields; i; i = i->next)
-    {
-        file_field = i->data;
-        if (tagged_up_to < file_field->field_offset)
-        {
-            unused_data = g_slice_new (FileField);
+    unused_data = field_def->tag ? field_def->tag : field_def->name;
+    n_fields = file_fields->n_fields;
 
-            unused_data->field_name = g_strdup (field_def->tag ? field_def->tag : field_def->name);
-            unused_data->field_offset = tagged_up_to;
-            unused_data->field_size = file_field->field_offset - tagged_up_to;
-            unused_data->color_index = format_color->color_index;
-            unused_data->background = format_color->background;
-            unused_data->navigation_label = NULL;
-            unused_data->additional_color_index = -1;
+    /* Unused data fields are appended as a second sorted run */
+    file_fields->unused_from = n_fields;
 
-            new_fields = g_slist_prepend (new_fields, unused_data);
+    for (guint i = 0; i < n_fields; i++)
+    {
+        if (tagged_up_to < file_fields->offsets[i])
+        {
+            field_table_append (file_fields,
+                                tagged_up_to,
+                                file_fields->offsets[i] - tagged_up_to,
+                                unused_data,
+                                NULL,
+                                format_color->color_index,
+                                format_color->background,
+                                G_MAXUINT);
         }
 
-        field_end = file_field->field_offset + file_field->field_size;
+        field_end = file_fields->offsets[i] + file_fields->sizes[i];
 
         if (tagged_up_to < field_end)
             tagged_up_to = field_end;
@@ -749,37 +665,210 @@ processor_utils_sort_find_unused (const FormatDefinition *format_definition,
 
     if (tagged_up_to < file->file_size)
     {
-        unused_data = g_slice_new (FileField);
+        field_table_append (file_fields,
+                            tagged_up_to,
+                            file->file_size - tagged_up_to,
+                            unused_data,
+                            NULL,
+                            format_color->color_index,
+                            format_color->background,
+                            G_MAXUINT);
+    }
 
-        unused_data->field_name = g_strdup (field_def->tag ? field_def->tag : field_def->name);
-        unused_data->field_offset = tagged_up_to;
-        unused_data->field_size = file->file_size - tagged_up_to;
-        unused_data->color_index = format_color->color_index;
-        unused_data->background = format_color->background;
-        unused_data->navigation_label = NULL;
-        unused_data->additional_color_index = -1;
+    field_table_sort (file_fields);
+}
 
-        new_fields = g_slist_prepend (new_fields, unused_data);
+/*
+ * Records that the analysis read the file contents from start up to (not including) end
+ * Checkpoints taken before a read remain valid for edits past it
+ */
+void
+processor_utils_depend (ProcessorFile *file,
+                        gsize          start,
+                        gsize          end)
+{
+    if (end > file->file_size)
+    {
+        end = file->file_size;
+        file->size_read = TRUE;
     }
 
-    if (new_fields)
-        file->file_fields = g_slist_sort (g_slist_concat (file->file_fields, new_fields), sort_file_fields);
+    if (start < file->read_start)
+        file->read_start = start;
+    if (end > file->read_end)
+        file->read_end = end;
 }
 
-void
-selection_scope_destroy (gpointer data)
+/*
+ * Checks if there are count bytes from the file contents index on
+ * A failed check depends on the file size
+ */
+gboolean
+processor_utils_has_data (ProcessorFile *file,
+                          gsize          count)
+{
+    if (file->file_contents_index <= file->file_size &&
+        count <= file->file_size - file->file_contents_index)
+    {
+        if (file->file_contents_index + count > file->read_end)
+            file->read_end = file->file_contents_index + count;
+
+        return TRUE;
+    }
+
+    file->size_read = TRUE;
+
+    return FALSE;
+}
+
+/*
+ * Returns the data available from the file contents index on, up to wanted bytes
+ */
+gsize
+processor_utils_available_data (ProcessorFile *file,
+                                gsize          wanted)
 {
-    g_slice_free (SelectionScope, data);
+    if (FILE_HAS_DATA_N (file, wanted))
+        return wanted;
+
+    return FILE_HAS_DATA (file) ? file->file_size - file->file_contents_index : 0;
 }
 
-void
-processor_variable_destroy (gpointer data)
+/*
+ * Returns the contents at offset, and in length the number of bytes contiguous
+ * to them, up to the end of their chunk
+ * The length is 0 past the end of the contents
+ */
+const guchar *
+processor_utils_get_chunk (ProcessorFile *file,
+                           gsize          offset,
+                           gsize         *length)
+{
+    const ProcessorChunk *chunks, *chunk;
+    gsize position;
+    guint low, high, middle;
+
+    if (offset >= file->file_size)
+    {
+        *length = 0;
+        return NULL;
+    }
+
+    if (!file->chunks)
+    {
+        *length = file->file_size - offset;
+        return (const guchar *) file->file_contents + offset;
+    }
+
+    chunks = (const ProcessorChunk *) file->chunks->data;
+    position = file->chunks_origin + offset;
+    chunk = &chunks[file->last_chunk];
+
+    if (position < chunk->offset || position - chunk->offset >= chunk->size)
+    {
+        /* Last chunk starting at or before position */
+        low = 0;
+        high = file->chunks->len;
+
+        while (high - low > 1)
+        {
+            middle = low + (high - low) / 2;
+
+            if (chunks[middle].offset <= position)
+                low = middle;
+            else
+                high = middle;
+        }
+
+        file->last_chunk = low;
+        chunk = &chunks[low];
+    }
+
+    *length = MIN (chunk->size - (position - chunk->offset), file->file_size - offset);
+
+    return chunk->data + (position - chunk->offset);
+}
+
+/*
+ * Returns size contiguous bytes of the contents at offset: in place, or copied
+ * if they span several chunks, the copy is valid until the next call
+ * Bytes past the end of the contents read as 0
+ */
+const guchar *
+processor_utils_get_contents (ProcessorFile *file,
+                              gsize          offset,
+                              gsize          size)
+{
+    const guchar *chunk;
+    gsize chunk_length, copied;
+
+    chunk = processor_utils_get_chunk (file, offset, &chunk_length);
+
+    if (chunk_length >= size)
+        return chunk;
+
+    if (file->chunk_buffer_size < size)
+    {
+        g_free (file->chunk_buffer);
+        file->chunk_buffer = g_malloc (size);
+        file->chunk_buffer_size = size;
+    }
+
+    for (copied = 0; copied < size; copied += chunk_length)
+    {
+        if (copied)
+            chunk = processor_utils_get_chunk (file, offset + copied, &chunk_length);
+
+        if (!chunk_length)
+        {
+            memset (file->chunk_buffer + copied, 0, size - copied);
+            break;
+        }
+
+        chunk_length = MIN (chunk_length, size - copied);
+        memcpy (file->chunk_buffer + copied, chunk, chunk_length);
+    }
+
+    return file->chunk_buffer;
+}
+
+/*
+ * Returns the number of bytes from offset up to the first byte equal to value,
+ * searching up to size bytes, size if not found
+ */
+gsize
+processor_utils_find_byte (ProcessorFile *file,
+                           gsize          offset,
+                           gsize          size,
+                           guchar         value)
 {
-    g_slice_free (ProcessorVariable, data);
+    const guchar *chunk, *found;
+    gsize chunk_length, searched;
+
+    for (searched = 0; searched < size; searched += chunk_length)
+    {
+        chunk = processor_utils_get_chunk (file, offset + searched, &chunk_length);
+
+        if (!chunk_length)
+            break;
+
+        chunk_length = MIN (chunk_length, size - searched);
+
+        found = memchr (chunk, value, chunk_length);
+        if (found)
+            return searched + (found - chunk);
+    }
+
+    return size;
 }
 
 void
 description_tab_destroy (gpointer data)
 {
-    g_slice_free (DescriptionTab, data);
+    DescriptionTab *tab;
+
+    tab = data;
+
+    if (tab && tab->records)
+        g_array_unref (tab->records);
 }
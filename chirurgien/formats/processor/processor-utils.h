@@ -27,12 +27,15 @@ G_BEGIN_DECLS
 
 typedef struct
 {
-    /* The description tab */
-    GtkBox         *contents;
+    /* The description tab's records */
+    GArray         *records;
+    /* Storage of the record strings, shared with the file description */
+    ProcessorArena *arena;
+    /* A description section has been started in the tab */
+    gboolean        section_started;
 
-    /* Current description section grid and lines count */
-    GtkGrid        *section;
-    guint           description_lines_count;
+    /* The tab's name, set when the tab is inserted */
+    const gchar    *name;
 
     /* If the tab has had items added since it was initialized */
     gboolean        used;
@@ -46,14 +49,12 @@ typedef enum
 
 } ReadValueType;
 
-/* File macros */
+/* File macros, the checks are recorded as dependencies of the analysis */
 
-#define FILE_HAS_DATA(file) (file->file_contents_index < file->file_size)
-#define FILE_HAS_DATA_N(file, count) ((file->file_contents_index + count) <= file->file_size)
+#define FILE_HAS_DATA(file) processor_utils_has_data (file, 1)
+#define FILE_HAS_DATA_N(file, count) processor_utils_has_data (file, count)
 
-#define FILE_AVAILABLE_DATA(file) (FILE_HAS_DATA(file) ? file->file_size - file->file_contents_index : 0)
-
-#define GET_CONTENT_POINTER(file) (file->file_contents + file->file_contents_index)
+#define GET_CONTENT_POINTER(file, size) ((gconstpointer) processor_utils_get_contents (file, file->file_contents_index, size))
 
 /* Description panel functions */
 
@@ -70,7 +71,8 @@ void                processor_utils_add_line              (ProcessorFile *,
 
 /* Description panel tab functions */
 
-DescriptionTab *    processor_utils_new_tab               (const gchar *);
+DescriptionTab *    processor_utils_new_tab               (ProcessorFile *,
+                                                           const gchar *);
 void                processor_utils_start_section_tab     (DescriptionTab *,
                                                            const char *);
 void                processor_utils_add_line_tab          (DescriptionTab *,
@@ -86,10 +88,16 @@ void                processor_utils_add_text_tab          (DescriptionTab *,
                                                            const gchar *,
                                                            gsize,
                                                            TextEncoding);
+void                processor_utils_copy_records          (GArray *,
+                                                           ProcessorArena *,
+                                                           const GArray *,
+                                                           guint,
+                                                           guint);
 
 void                processor_utils_insert_tab            (ProcessorFile *,
                                                            DescriptionTab *,
                                                            const gchar *);
+void                processor_utils_finish_description    (ProcessorFile *);
 
 /* Processor execution helper functions */
 
@@ -102,30 +110,49 @@ void                processor_utils_add_field             (ProcessorFile *,
                                                            guint);
 gboolean            processor_utils_read                  (const FormatDefinition *,
                                                            const ProcessorState *,
-                                                           const ProcessorFile *,
+                                                           ProcessorFile *,
                                                            const FieldDefinition *,
+                                                           gsize,
                                                            gboolean,
                                                            gpointer);
 void                processor_utils_format_byte_order     (const FormatDefinition *,
                                                            const ProcessorState *,
                                                            gpointer,
                                                            gsize);
-void                processor_utils_read_value            (const ProcessorState *,
-                                                           const gchar *,
+void                processor_utils_read_operand          (const ProcessorState *,
+                                                           const Operand *,
                                                            ReadValueType,
                                                            ProcessorVariable **,
                                                            gpointer,
                                                            gboolean);
-GSList *            processor_utils_skip_steps            (GSList *,
-                                                           RunStepType,
-                                                           RunStepType);
 void                processor_utils_sort_find_unused      (const FormatDefinition *,
                                                            ProcessorFile *);
 
+/* File contents dependency functions */
+
+void                processor_utils_depend                (ProcessorFile *,
+                                                           gsize,
+                                                           gsize);
+gboolean            processor_utils_has_data              (ProcessorFile *,
+                                                           gsize);
+gsize               processor_utils_available_data        (ProcessorFile *,
+                                                           gsize);
+
+/* File contents access functions */
+
+const guchar *      processor_utils_get_chunk             (ProcessorFile *,
+                                                           gsize,
+                                                           gsize *);
+const guchar *      processor_utils_get_contents          (ProcessorFile *,
+                                                           gsize,
+                                                           gsize);
+gsize               processor_utils_find_byte             (ProcessorFile *,
+                                                           gsize,
+                                                           gsize,
+                                                           guchar);
+
 /* Destroy functions */
 
-void                selection_scope_destroy               (gpointer);
-void                processor_variable_destroy            (gpointer);
 void                description_tab_destroy               (gpointer);
 
 G_END_DECLS
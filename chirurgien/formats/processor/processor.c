@@ -17,9 +17,13 @@
  */
 
 #include "processor.h"
+#include "processor-checkpoint.h"
 
 #define MAX_STEPS 50000000
 
+/* Steps between progress updates and cancellation checks */
+#define PROGRESS_STEPS 4096
+
 
 gboolean
 format_identify (const FormatDefinition *format_definition,
@@ -29,20 +33,33 @@ format_identify (const FormatDefinition *format_definition,
     FieldDefinition dummy_field_def = { 0 };
 
     const MagicStep *magic_step;
-    ProcessorVariable *processor_var;
+    ProcessorVariable processor_var;
 
     gsize step_offset;
+    guint variables_count;
     gboolean magic_failed, format_found;
 
     format_found = FALSE;
 
+    /* Not the complete definition's counts, format_complete may be running */
+    variables_count = format_definition->magic_variables_count;
+    state.endianness_slot = format_definition->magic_endianness_slot;
+
+    /* Not allocated in the file arena, carving identifies a file from many offsets */
+    if (file->identify_variables_count < variables_count)
+    {
+        g_free (file->identify_variables);
+        file->identify_variables = g_new (ProcessorVariable, variables_count);
+        file->identify_variables_count = variables_count;
+    }
+    state.variables = file->identify_variables;
+
     for (GSList *magic = format_definition->magic;
          magic && !format_found;
          magic = magic->next)
     {
         magic_failed = FALSE;
-        state.variables = g_hash_table_new_full (g_str_hash, g_str_equal,
-                                                 NULL, processor_variable_destroy);
+        memset (state.variables, 0, variables_count * sizeof (ProcessorVariable));
 
         for (GSList *magic_iter = magic->data;
              magic_iter;
@@ -54,12 +71,12 @@ format_identify (const FormatDefinition *format_definition,
             {
                 if (magic_step->match.offset)
                 {
-                    processor_utils_read_value (&state,
-                                                magic_step->match.offset,
-                                                READ_VARIABLE | READ_NUMERIC,
-                                                NULL,
-                                                &step_offset,
-                                                FALSE);
+                    processor_utils_read_operand (&state,
+                                                  &magic_step->match.offset_op,
+                                                  READ_VARIABLE | READ_NUMERIC,
+                                                  NULL,
+                                                  &step_offset,
+                                                  FALSE);
                 }
                 else
                 {
@@ -70,7 +87,9 @@ format_identify (const FormatDefinition *format_definition,
                 {
                     if (!magic_step->match.value ||
                         !magic_step->match.value_size ||
-                        memcmp (file->file_contents + step_offset,
+                        memcmp (processor_utils_get_contents (file,
+                                                              step_offset,
+                                                              magic_step->match.value_size),
                                 magic_step->match.value,
                                 magic_step->match.value_size))
                     {
@@ -88,12 +107,12 @@ format_identify (const FormatDefinition *format_definition,
             {
                 if (magic_step->read.offset)
                 {
-                    processor_utils_read_value (&state,
-                                                magic_step->match.offset,
-                                                READ_VARIABLE | READ_NUMERIC,
-                                                NULL,
-                                                &step_offset,
-                                                FALSE);
+                    processor_utils_read_operand (&state,
+                                                  &magic_step->match.offset_op,
+                                                  READ_VARIABLE | READ_NUMERIC,
+                                                  NULL,
+                                                  &step_offset,
+                                                  FALSE);
                 }
                 else
                 {
@@ -104,24 +123,20 @@ format_identify (const FormatDefinition *format_definition,
 
                 if (magic_step->read.var_id && magic_step->read.size <= 8)
                 {
-                    processor_var = g_slice_new0 (ProcessorVariable);
+                    processor_var = (ProcessorVariable) { 0 };
 
-                    dummy_field_def.size = processor_var->size = magic_step->read.size;
+                    processor_var.size = magic_step->read.size;
 
                     if (processor_utils_read (format_definition,
                                               &state,
                                               file,
                                               &dummy_field_def,
+                                              magic_step->read.size,
                                               TRUE,
-                                              processor_var->value))
-                    {
-                        g_hash_table_insert (state.variables,
-                                             magic_step->read.var_id,
-                                             processor_var);
-                    }
-                    else
+                                              processor_var.value))
                     {
-                        g_slice_free (ProcessorVariable, processor_var);
+                        processor_var.defined = TRUE;
+                        state.variables[magic_step->read.var_slot] = processor_var;
                     }
                 }
 
@@ -129,8 +144,6 @@ format_identify (const FormatDefinition *format_definition,
             }
         }
 
-        g_hash_table_destroy (state.variables);
-
         if (!magic_failed)
             format_found = TRUE;
     }
@@ -142,11 +155,12 @@ void
 format_process (const FormatDefinition *format_definition,
                 ProcessorFile          *file)
 {
-    ProcessorState state = { 0 };
-    RunStep *run_step;
+    ProcessorState state;
+    const RunStep *run_step;
+
+    guint step_index, run_steps_executed;
 
-    GSList *run_iter;
-    guint run_steps_executed;
+    processor_file_set_format (file, format_definition);
 
     if (!format_definition)
     {
@@ -154,88 +168,123 @@ format_process (const FormatDefinition *format_definition,
         return;
     }
 
-    state.variables = g_hash_table_new_full (g_str_hash, g_str_equal,
-                                             NULL, processor_variable_destroy);
-    state.tabs = g_hash_table_new_full (g_str_hash, g_str_equal,
-                                        NULL, description_tab_destroy);
+    /* The containers of the file's state are reused, empty */
+    state = file->state;
 
-    /* Process the format */
-    processor_utils_set_title (file, format_definition->format_name);
+    state.variables = processor_arena_new0 (file->arena, ProcessorVariable,
+                                            format_definition->variables_count);
+    state.endianness_slot = format_definition->endianness_slot;
 
-    run_steps_executed = 0;
-    run_iter = format_definition->run;
+    /* Process the format, from the first step or from a checkpoint of the previous analysis */
+    if (!file->checkpointed ||
+        !processor_checkpoint_resume (format_definition, file, &state, &step_index, &run_steps_executed))
+    {
+        processor_utils_set_title (file, format_definition->format_name);
+
+        run_steps_executed = 0;
+        step_index = 0;
+    }
 
-    while (run_steps_executed < MAX_STEPS)
+    while (step_index < format_definition->run_length &&
+           run_steps_executed < MAX_STEPS)
     {
-        if (state.block_stack.length)
-            run_iter = g_queue_pop_tail (&state.block_stack);
-        else if (run_steps_executed)
-            break;
+        if (file->checkpointed && !(run_steps_executed % CHECKPOINT_STEPS))
+        {
+            if (processor_checkpoint_converge (file, &state, step_index, &run_steps_executed))
+                break;
+
+            processor_checkpoint_save (file, &state, step_index, run_steps_executed);
+        }
+
+        run_step = &format_definition->run[step_index];
 
-        while (run_iter && run_steps_executed < MAX_STEPS)
+        /* RunStep type switch */
+        switch (run_step->step_type)
         {
-            run_step = run_iter->data;
+            case FIELD_STEP:
+            process_field_step (format_definition, file, run_step, &state);
+            step_index++;
 
-            /* RunStep type switch */
-            switch (run_step->step_type)
-            {
-                case FIELD_STEP:
-                process_field_step (format_definition, file, run_step, &state);
-                run_iter = run_iter->next;
+            break;
+            case MATCH_START_STEP:
+            step_index = process_match_start_step (format_definition, file, run_step, &state, step_index);
 
-                break;
-                case MATCH_START_STEP:
-                run_iter = process_match_start_step (format_definition, file, run_step, &state, run_iter);
+            break;
+            case MATCH_END_STEP:
+            step_index = process_match_end_step (run_step, &state, step_index);
 
-                break;
-                case MATCH_END_STEP:
-                run_iter = process_match_end_step (&state, run_iter);
+            break;
+            case LOOP_START_STEP:
+            step_index = process_loop_start_step (file, run_step, &state, step_index);
 
-                break;
-                case LOOP_START_STEP:
-                run_iter = process_loop_start_step (file, run_step, &state, run_iter);
+            break;
+            case LOOP_END_STEP:
+            step_index = process_loop_end_step (&state, step_index);
 
-                break;
-                case LOOP_END_STEP:
-                run_iter = process_loop_end_step (&state, run_iter);
+            break;
+            case SELECTION_START_STEP:
+            process_selection_start_step (&state);
+            step_index++;
 
-                break;
-                case SELECTION_START_STEP:
-                process_selection_start_step (&state);
-                run_iter = run_iter->next;
+            break;
+            case SELECTION_END_STEP:
+            process_selection_end_step (&state);
+            step_index++;
 
-                break;
-                case SELECTION_END_STEP:
-                process_selection_end_step (&state);
-                run_iter = run_iter->next;
+            break;
+            case PRINT_STEP:
+            process_print_step (file, run_step, &state);
+            step_index++;
 
-                break;
-                case PRINT_STEP:
-                process_print_step (file, run_step, &state);
-                run_iter = run_iter->next;
+            break;
+            case EXEC_STEP:
+            process_exec_step (file, run_step, &state);
+            step_index++;
 
-                break;
-                case EXEC_STEP:
-                process_exec_step (file, run_step, &state);
-                run_iter = run_iter->next;
+            break;
+            case BLOCK_STEP:
+            step_index = process_block_step (run_step, &state, step_index);
 
-                break;
-                case BLOCK_STEP:
-                run_iter = process_block_step (format_definition, run_step, &state, run_iter);
+            break;
+            case END_STEP:
+            /* Return from a block, or finish */
+            if (state.block_stack->len)
+            {
+                step_index = g_array_index (state.block_stack, guint, state.block_stack->len - 1);
+                g_array_set_size (state.block_stack, state.block_stack->len - 1);
+            }
+            else
+                step_index = format_definition->run_length;
+
+            break;
+        }
+        run_steps_executed++;
 
+        if (!(run_steps_executed % PROGRESS_STEPS))
+        {
+            g_atomic_int_set (&file->steps_executed, run_steps_executed);
+            g_atomic_pointer_set (&file->bytes_covered, file->file_fields_size);
+
+            if (g_cancellable_is_cancelled (file->cancellable))
                 break;
-            }
-            run_steps_executed++;
         }
     }
 
+    g_atomic_int_set (&file->steps_executed, run_steps_executed);
+    g_atomic_pointer_set (&file->bytes_covered, file->file_fields_size);
+
+    if (file->checkpointed)
+        processor_checkpoint_finish (file, run_steps_executed, run_steps_executed >= MAX_STEPS);
+
     processor_utils_sort_find_unused (format_definition,
                                       file);
-
-    /* Clear state */
-    g_queue_clear (&state.loop_stack);
-    g_queue_clear_full (&state.selection_stack, selection_scope_destroy);
-    g_queue_clear (&state.block_stack);
-    g_hash_table_destroy (state.variables);
-    g_hash_table_destroy (state.tabs);
+    processor_utils_finish_description (file);
+
+    /* Empty the state for the next analysis, the variables belong to the arena */
+    g_array_set_size (state.loop_stack, 0);
+    g_array_set_size (state.selection_stack, 0);
+    g_array_set_size (state.block_stack, 0);
+    g_string_truncate (state.tooltip_buffer, 0);
+    g_string_truncate (state.text_buffer, 0);
+    g_hash_table_remove_all (state.tabs);
 }
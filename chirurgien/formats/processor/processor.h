@@ -24,38 +24,38 @@ G_BEGIN_DECLS
 
 void        process_field_step              (const FormatDefinition *,
                                              ProcessorFile *,
-                                             RunStep *,
+                                             const RunStep *,
                                              ProcessorState *);
 
-GSList *    process_match_start_step        (const FormatDefinition *,
+guint       process_match_start_step        (const FormatDefinition *,
                                              ProcessorFile *,
-                                             RunStep *,
+                                             const RunStep *,
                                              ProcessorState *,
-                                             GSList *);
-GSList *    process_match_end_step          (ProcessorState *,
-                                             GSList *);
+                                             guint);
+guint       process_match_end_step          (const RunStep *,
+                                             ProcessorState *,
+                                             guint);
 
-GSList *    process_loop_start_step         (ProcessorFile *,
-                                             RunStep *,
+guint       process_loop_start_step         (ProcessorFile *,
+                                             const RunStep *,
                                              ProcessorState *,
-                                             GSList *);
-GSList *    process_loop_end_step           (ProcessorState *,
-                                             GSList *);
+                                             guint);
+guint       process_loop_end_step           (ProcessorState *,
+                                             guint);
 
 void        process_selection_start_step    (ProcessorState *);
 void        process_selection_end_step      (ProcessorState *);
 
 void        process_print_step              (ProcessorFile *,
-                                             RunStep *,
+                                             const RunStep *,
                                              ProcessorState *);
 
 void        process_exec_step               (ProcessorFile *,
-                                             RunStep *,
+                                             const RunStep *,
                                              ProcessorState *);
 
-GSList *    process_block_step              (const FormatDefinition *,
-                                             RunStep *,
+guint       process_block_step              (const RunStep *,
                                              ProcessorState *,
-                                             GSList *);
+                                             guint);
 
 G_END_DECLS
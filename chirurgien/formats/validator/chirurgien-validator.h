@@ -24,8 +24,15 @@ G_BEGIN_DECLS
 
 /*** Public API ***/
 
-FormatDefinition * format_validate (const gchar *,
-                                    gsize,
-                                    GError **);
+FormatDefinition *    format_validate           (const gchar *,
+                                                 gsize,
+                                                 GError **);
+
+FormatDefinition *    format_validate_header    (GBytes *,
+                                                 GError **);
+void                  format_complete           (FormatDefinition *);
+
+FormatDefinition *    format_definition_ref     (FormatDefinition *);
+void                  format_definition_unref   (FormatDefinition *);
 
 G_END_DECLS
@@ -76,7 +76,7 @@ run_blocks_end (GMarkupParseContext *context,
     if (!g_strcmp0 (element_name, "block-def") &&
         parser_control->current_block_id)
     {
-        g_hash_table_insert (parser_control->definition->blocks,
+        g_hash_table_insert (parser_control->blocks,
                              parser_control->current_block_id,
                              parser_control->run_steps);
         g_markup_parse_context_pop (context);
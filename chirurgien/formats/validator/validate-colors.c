@@ -18,7 +18,7 @@
 
 #include "validator.h"
 
-#include <chirurgien-globals.h>
+#include <chirurgien-formats-globals.h>
 
 
 static void
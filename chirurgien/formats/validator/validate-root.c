@@ -107,7 +107,7 @@ root_start (GMarkupParseContext *context,
     {
         parser_control->colors_state = PARSER_EXECUTING;
         g_markup_parse_context_push (context,
-                                     &colors_parser,
+                                     parser_control->header_only ? &skip_parser : &colors_parser,
                                      parser_control);
     }
     else if (parser_control->format_root_found &&
@@ -117,7 +117,7 @@ root_start (GMarkupParseContext *context,
     {
         parser_control->run_state = PARSER_EXECUTING;
         g_markup_parse_context_push (context,
-                                     &run_parser,
+                                     parser_control->header_only ? &skip_parser : &run_parser,
                                      parser_control);
     }
     else if (parser_control->format_root_found &&
@@ -127,7 +127,7 @@ root_start (GMarkupParseContext *context,
     {
         parser_control->block_defs_state = PARSER_EXECUTING;
         g_markup_parse_context_push (context,
-                                     &run_blocks_parser,
+                                     parser_control->header_only ? &skip_parser : &run_blocks_parser,
                                      parser_control);
     }
     else if (parser_control->format_root_found &&
@@ -137,7 +137,7 @@ root_start (GMarkupParseContext *context,
     {
         parser_control->field_defs_state = PARSER_EXECUTING;
         g_markup_parse_context_push (context,
-                                     &field_defs_parser,
+                                     parser_control->header_only ? &skip_parser : &field_defs_parser,
                                      parser_control);
     }
     else if (parser_control->format_root_found &&
@@ -199,7 +199,7 @@ root_end (GMarkupParseContext *context,
         parser_control->run_state = PARSER_DONE;
         g_markup_parse_context_pop (context);
 
-        parser_control->definition->run = parser_control->run_steps;
+        parser_control->run = parser_control->run_steps;
         parser_control->run_steps = NULL;
     }
     else if (!g_strcmp0 (element_name, "block-defs") &&
@@ -283,6 +283,16 @@ root_text (GMarkupParseContext *context,
     }
 }
 
+/* Ignores a section, for definitions that validate only their header */
+GMarkupParser skip_parser =
+{
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    NULL
+};
+
 GMarkupParser root_parser =
 {
     root_start,
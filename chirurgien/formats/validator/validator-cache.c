@@ -0,0 +1,816 @@
+/* validator-cache.c
+ *
+ * Copyright (C) 2021 - Daniel Léonard Schardijn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+
+#include <string.h>
+
+#include "validator.h"
+
+#include <chirurgien-formats-globals.h>
+
+
+/* Identifies a cached format definition */
+#define CACHE_MAGIC "CHIRFMT"
+
+/* Must be increased whenever the FormatDefinition structures change */
+#define CACHE_VERSION 3
+
+/*
+ * A cached definition is a sequence of little-endian 64-bit values,
+ * strings and values are prefixed by their size plus one (0 is NULL)
+ * The same walk over a definition writes it (output) or reads it (input)
+ */
+typedef struct
+{
+    /* Writing */
+    GByteArray      *output;
+
+    /* Reading */
+    const guchar    *input;
+    gsize            input_size;
+    gsize            position;
+
+    /* The input is truncated or malformed */
+    gboolean         failed;
+
+} CacheStream;
+
+
+static guint64
+cache_uint (CacheStream *stream,
+            guint64      value)
+{
+    guint64 le_value;
+
+    if (stream->output)
+    {
+        le_value = GUINT64_TO_LE (value);
+        g_byte_array_append (stream->output, (const guint8 *) &le_value, sizeof (guint64));
+
+        return value;
+    }
+
+    if (stream->failed || stream->input_size - stream->position < sizeof (guint64))
+    {
+        stream->failed = TRUE;
+        return 0;
+    }
+
+    memcpy (&le_value, stream->input + stream->position, sizeof (guint64));
+    stream->position += sizeof (guint64);
+
+    return GUINT64_FROM_LE (le_value);
+}
+
+/* Reads or writes size bytes of data, returns the data read */
+static gpointer
+cache_bytes (CacheStream   *stream,
+             gconstpointer  data,
+             gsize          size,
+             gboolean       terminate)
+{
+    gpointer read_data;
+
+    if (stream->output)
+    {
+        g_byte_array_append (stream->output, data, size);
+
+        return (gpointer) data;
+    }
+
+    if (stream->failed || stream->input_size - stream->position < size)
+    {
+        stream->failed = TRUE;
+        return NULL;
+    }
+
+    /* Strings and option values are terminated like the XML parser leaves them */
+    read_data = g_malloc0 (terminate ? size + 1 : MAX (size, 1));
+    memcpy (read_data, stream->input + stream->position, size);
+    stream->position += size;
+
+    return read_data;
+}
+
+static gchar *
+cache_string (CacheStream *stream,
+              gchar       *string)
+{
+    gsize length;
+
+    length = cache_uint (stream, string ? strlen (string) + 1 : 0);
+
+    if (!length || stream->failed)
+        return NULL;
+
+    return cache_bytes (stream, string, length - 1, TRUE);
+}
+
+static gpointer
+cache_data (CacheStream *stream,
+            gpointer     data,
+            gsize       *size)
+{
+    gsize stored_size;
+
+    stored_size = cache_uint (stream, data ? *size + 1 : 0);
+
+    if (!stored_size || stream->failed)
+        return NULL;
+
+    *size = stored_size - 1;
+
+    return cache_bytes (stream, data, *size, FALSE);
+}
+
+static void
+cache_operand (CacheStream *stream,
+               Operand     *operand)
+{
+    operand->type = cache_uint (stream, operand->type);
+    operand->slot = cache_uint (stream, operand->slot);
+    operand->immediate = cache_uint (stream, operand->immediate);
+}
+
+static void
+cache_magic_step (CacheStream *stream,
+                  MagicStep   *magic_step)
+{
+    magic_step->step_type = cache_uint (stream, magic_step->step_type);
+
+    if (magic_step->step_type == MATCH_STEP)
+    {
+        magic_step->match.value = cache_data (stream, magic_step->match.value,
+                                              &magic_step->match.value_size);
+        magic_step->match.offset = cache_string (stream, magic_step->match.offset);
+        cache_operand (stream, &magic_step->match.offset_op);
+    }
+    else if (magic_step->step_type == READ_STEP)
+    {
+        magic_step->read.var_id = cache_string (stream, magic_step->read.var_id);
+        magic_step->read.size = cache_uint (stream, magic_step->read.size);
+        magic_step->read.offset = cache_string (stream, magic_step->read.offset);
+        cache_operand (stream, &magic_step->read.offset_op);
+        magic_step->read.var_slot = cache_uint (stream, magic_step->read.var_slot);
+    }
+}
+
+static void
+cache_magic (CacheStream      *stream,
+             FormatDefinition *format_definition)
+{
+    GSList *magic_steps;
+    MagicStep *magic_step;
+
+    guint alternatives, steps;
+
+    alternatives = cache_uint (stream, g_slist_length (format_definition->magic));
+
+    if (stream->output)
+    {
+        for (GSList *magic = format_definition->magic;
+             magic;
+             magic = magic->next)
+        {
+            cache_uint (stream, g_slist_length (magic->data));
+
+            for (GSList *magic_iter = magic->data;
+                 magic_iter;
+                 magic_iter = magic_iter->next)
+            {
+                cache_magic_step (stream, magic_iter->data);
+            }
+        }
+
+        return;
+    }
+
+    for (guint i = 0; i < alternatives && !stream->failed; i++)
+    {
+        magic_steps = NULL;
+        steps = cache_uint (stream, 0);
+
+        for (guint j = 0; j < steps && !stream->failed; j++)
+        {
+            magic_step = g_slice_new0 (MagicStep);
+            cache_magic_step (stream, magic_step);
+
+            magic_steps = g_slist_prepend (magic_steps, magic_step);
+        }
+
+        format_definition->magic = g_slist_prepend (format_definition->magic,
+                                                    g_slist_reverse (magic_steps));
+    }
+
+    format_definition->magic = g_slist_reverse (format_definition->magic);
+}
+
+static void
+cache_color (CacheStream *stream,
+             FormatColor *color)
+{
+    color->color_name = cache_string (stream, color->color_name);
+    color->color_index = cache_uint (stream, color->color_index);
+    color->background = cache_uint (stream, color->background);
+}
+
+static void
+cache_field_def (CacheStream     *stream,
+                 FieldDefinition *field_def)
+{
+    FieldDefinitionOption *option;
+    FieldDefinitionFlag *flag;
+    gsize option_size;
+
+    guint values;
+
+    field_def->name = cache_string (stream, field_def->name);
+    field_def->tag = cache_string (stream, field_def->tag);
+    field_def->tooltip = cache_string (stream, field_def->tooltip);
+    field_def->auto_tooltip = cache_uint (stream, field_def->auto_tooltip);
+    field_def->color = cache_string (stream, field_def->color);
+    field_def->size_type = cache_uint (stream, field_def->size_type);
+    field_def->size = cache_uint (stream, field_def->size);
+    field_def->value = cache_uint (stream, field_def->value);
+    field_def->mask = cache_uint (stream, field_def->mask);
+    field_def->shift = cache_uint (stream, field_def->shift);
+    field_def->print = cache_uint (stream, field_def->print);
+    field_def->print_literal = cache_string (stream, field_def->print_literal);
+    field_def->encoding = cache_uint (stream, field_def->encoding);
+    field_def->convert_endianness = cache_uint (stream, field_def->convert_endianness);
+
+    if (field_def->print != PRINT_OPTION && field_def->print != PRINT_FLAGS)
+        return;
+
+    values = cache_uint (stream, g_slist_length (field_def->value_collection));
+
+    if (stream->output)
+    {
+        for (GSList *value_iter = field_def->value_collection;
+             value_iter;
+             value_iter = value_iter->next)
+        {
+            if (field_def->print == PRINT_OPTION)
+            {
+                option = value_iter->data;
+
+                cache_string (stream, option->name);
+                cache_bytes (stream, option->value, field_def->size, TRUE);
+            }
+            else
+            {
+                flag = value_iter->data;
+
+                cache_string (stream, flag->name);
+                cache_uint (stream, flag->mask);
+                cache_string (stream, flag->meaning);
+            }
+        }
+
+        return;
+    }
+
+    /* Option values have the field's size */
+    option_size = field_def->size;
+
+    for (guint i = 0; i < values && !stream->failed; i++)
+    {
+        if (field_def->print == PRINT_OPTION)
+        {
+            option = g_slice_new0 (FieldDefinitionOption);
+            option->name = cache_string (stream, NULL);
+            option->value = cache_bytes (stream, NULL, option_size, TRUE);
+
+            field_def->value_collection = g_slist_prepend (field_def->value_collection, option);
+        }
+        else
+        {
+            flag = g_slice_new0 (FieldDefinitionFlag);
+            flag->name = cache_string (stream, NULL);
+            flag->mask = cache_uint (stream, 0);
+            flag->meaning = cache_string (stream, NULL);
+
+            field_def->value_collection = g_slist_prepend (field_def->value_collection, flag);
+        }
+    }
+
+    field_def->value_collection = g_slist_reverse (field_def->value_collection);
+}
+
+/* Colors and field definitions, associative arrays keyed by their ID */
+static void
+cache_hash_table (CacheStream  *stream,
+                  GHashTable   *table,
+                  gsize         value_size,
+                  void        (*cache_value) (CacheStream *, gpointer))
+{
+    GHashTableIter iter;
+    gpointer key, value;
+
+    guint values;
+
+    values = cache_uint (stream, g_hash_table_size (table));
+
+    if (stream->output)
+    {
+        g_hash_table_iter_init (&iter, table);
+        while (g_hash_table_iter_next (&iter, &key, &value))
+        {
+            cache_string (stream, key);
+            cache_value (stream, value);
+        }
+
+        return;
+    }
+
+    for (guint i = 0; i < values && !stream->failed; i++)
+    {
+        key = cache_string (stream, NULL);
+        value = g_slice_alloc0 (value_size);
+        cache_value (stream, value);
+
+        g_hash_table_insert (table, key ? key : g_strdup (""), value);
+    }
+}
+
+static void
+cache_run_step (CacheStream *stream,
+                RunStep     *run_step)
+{
+    run_step->step_type = cache_uint (stream, run_step->step_type);
+    run_step->jump = cache_uint (stream, run_step->jump);
+
+    switch (run_step->step_type)
+    {
+        case FIELD_STEP:
+        run_step->field.field_id = cache_string (stream, run_step->field.field_id);
+        run_step->field.store_var = cache_string (stream, run_step->field.store_var);
+        run_step->field.store_var_slot = cache_uint (stream, run_step->field.store_var_slot);
+        run_step->field.convert_endianness = cache_uint (stream, run_step->field.convert_endianness);
+        run_step->field.ascii_base = cache_uint (stream, run_step->field.ascii_base);
+        run_step->field.navigation = cache_string (stream, run_step->field.navigation);
+        cache_operand (stream, &run_step->field.navigation_op);
+        run_step->field.navigation_limit = cache_uint (stream, run_step->field.navigation_limit);
+        run_step->field.offset = cache_string (stream, run_step->field.offset);
+        cache_operand (stream, &run_step->field.offset_op);
+        run_step->field.additional_color = cache_string (stream, run_step->field.additional_color);
+        run_step->field.tab = cache_string (stream, run_step->field.tab);
+        run_step->field.insert_tab = cache_uint (stream, run_step->field.insert_tab);
+        run_step->field.section = cache_string (stream, run_step->field.section);
+        run_step->field.limit = cache_string (stream, run_step->field.limit);
+        cache_operand (stream, &run_step->field.limit_op);
+        run_step->field.limit_failed = cache_uint (stream, run_step->field.limit_failed);
+        run_step->field.margin_top = (gint) cache_uint (stream, run_step->field.margin_top);
+        run_step->field.margin_bottom = (gint) cache_uint (stream, run_step->field.margin_bottom);
+        run_step->field.suppress_print = cache_uint (stream, run_step->field.suppress_print);
+
+        break;
+        case MATCH_START_STEP:
+        run_step->match.var_id = cache_string (stream, run_step->match.var_id);
+        cache_operand (stream, &run_step->match.var_op);
+        run_step->match.op = cache_uint (stream, run_step->match.op);
+        run_step->match.num_value = cache_uint (stream, run_step->match.num_value);
+        run_step->match.value = cache_data (stream, run_step->match.value,
+                                            &run_step->match.value_size);
+        run_step->match.convert_endianness = cache_uint (stream, run_step->match.convert_endianness);
+
+        break;
+        case LOOP_START_STEP:
+        run_step->loop.until_set = cache_string (stream, run_step->loop.until_set);
+        cache_operand (stream, &run_step->loop.until_set_op);
+        run_step->loop.var_value = cache_string (stream, run_step->loop.var_value);
+        cache_operand (stream, &run_step->loop.var_value_op);
+        run_step->loop.num_value = cache_uint (stream, run_step->loop.num_value);
+        run_step->loop.num_value_used = cache_uint (stream, run_step->loop.num_value_used);
+        run_step->loop.limit = cache_string (stream, run_step->loop.limit);
+        cache_operand (stream, &run_step->loop.limit_op);
+
+        break;
+        case PRINT_STEP:
+        run_step->print.line = cache_string (stream, run_step->print.line);
+        run_step->print.tooltip = cache_string (stream, run_step->print.tooltip);
+        run_step->print.margin_top = (gint) cache_uint (stream, run_step->print.margin_top);
+        run_step->print.margin_bottom = (gint) cache_uint (stream, run_step->print.margin_bottom);
+        run_step->print.var_id = cache_string (stream, run_step->print.var_id);
+        cache_operand (stream, &run_step->print.var_op);
+        run_step->print.signed_val = cache_uint (stream, run_step->print.signed_val);
+        run_step->print.omit_undefined = cache_uint (stream, run_step->print.omit_undefined);
+        run_step->print.no_section = cache_uint (stream, run_step->print.no_section);
+        run_step->print.section = cache_string (stream, run_step->print.section);
+        run_step->print.tab = cache_string (stream, run_step->print.tab);
+        run_step->print.insert_tab = cache_uint (stream, run_step->print.insert_tab);
+
+        break;
+        case EXEC_STEP:
+        run_step->exec.var_id = cache_string (stream, run_step->exec.var_id);
+        cache_operand (stream, &run_step->exec.var_op);
+        run_step->exec.set = cache_string (stream, run_step->exec.set);
+        cache_operand (stream, &run_step->exec.set_op);
+        run_step->exec.modulo = cache_string (stream, run_step->exec.modulo);
+        cache_operand (stream, &run_step->exec.modulo_op);
+        run_step->exec.add = cache_string (stream, run_step->exec.add);
+        cache_operand (stream, &run_step->exec.add_op);
+        run_step->exec.substract = cache_string (stream, run_step->exec.substract);
+        cache_operand (stream, &run_step->exec.substract_op);
+        run_step->exec.multiply = cache_string (stream, run_step->exec.multiply);
+        cache_operand (stream, &run_step->exec.multiply_op);
+        run_step->exec.divide = cache_string (stream, run_step->exec.divide);
+        cache_operand (stream, &run_step->exec.divide_op);
+        run_step->exec.signed_op = cache_uint (stream, run_step->exec.signed_op);
+
+        break;
+        case BLOCK_STEP:
+        run_step->block.block_id = cache_string (stream, run_step->block.block_id);
+
+        break;
+        default:
+        break;
+    }
+}
+
+/*
+ * Walks a format definition
+ * When writing, the definition is only read: every value is assigned back unchanged
+ */
+static void
+cache_definition (CacheStream      *stream,
+                  FormatDefinition *format_definition)
+{
+    guint run_length;
+
+    format_definition->format_name = cache_string (stream, format_definition->format_name);
+    format_definition->short_format_name = cache_string (stream, format_definition->short_format_name);
+    format_definition->details = cache_string (stream, format_definition->details);
+
+    format_definition->endianness = cache_uint (stream, format_definition->endianness);
+    format_definition->endianness_var = cache_string (stream, format_definition->endianness_var);
+    format_definition->endianness_slot = cache_uint (stream, format_definition->endianness_slot);
+    format_definition->be_value = cache_data (stream, format_definition->be_value,
+                                              &format_definition->be_value_size);
+    format_definition->le_value = cache_data (stream, format_definition->le_value,
+                                              &format_definition->le_value_size);
+
+    cache_magic (stream, format_definition);
+
+    cache_hash_table (stream, format_definition->colors, sizeof (FormatColor),
+                      (void (*) (CacheStream *, gpointer)) cache_color);
+    cache_hash_table (stream, format_definition->fields, sizeof (FieldDefinition),
+                      (void (*) (CacheStream *, gpointer)) cache_field_def);
+
+    format_definition->variables_count = cache_uint (stream, format_definition->variables_count);
+    format_definition->magic_variables_count = cache_uint (stream, format_definition->magic_variables_count);
+    format_definition->magic_endianness_slot = cache_uint (stream, format_definition->magic_endianness_slot);
+
+    run_length = cache_uint (stream, format_definition->run_length);
+
+    /* Every step takes more than a byte, a larger length is malformed */
+    if (!stream->output)
+    {
+        if (stream->failed || run_length > stream->input_size - stream->position)
+        {
+            stream->failed = TRUE;
+            return;
+        }
+
+        format_definition->run = g_new0 (RunStep, run_length);
+        format_definition->run_length = run_length;
+    }
+
+    for (guint i = 0; i < run_length && !stream->failed; i++)
+        cache_run_step (stream, &format_definition->run[i]);
+}
+
+/* A variable slot below count, G_MAXUINT when unused */
+static gboolean
+cache_valid_slot (guint    count,
+                  guint    slot,
+                  gboolean used)
+{
+    return slot < count || (!used && slot == G_MAXUINT);
+}
+
+static gboolean
+cache_valid_operand (guint          count,
+                     const Operand *operand)
+{
+    return operand->type <= OPERAND_INDEX &&
+           cache_valid_slot (count, operand->slot, operand->type == OPERAND_VARIABLE);
+}
+
+/* Identification only allocates the magic's slots */
+static gboolean
+cache_valid_magic (const FormatDefinition *format_definition)
+{
+    MagicStep *magic_step;
+    guint count;
+
+    count = format_definition->magic_variables_count;
+
+    if (count > format_definition->variables_count ||
+        !cache_valid_slot (count, format_definition->magic_endianness_slot, FALSE))
+        return FALSE;
+
+    for (GSList *magic = format_definition->magic;
+         magic;
+         magic = magic->next)
+    {
+        for (GSList *magic_iter = magic->data;
+             magic_iter;
+             magic_iter = magic_iter->next)
+        {
+            magic_step = magic_iter->data;
+
+            if (magic_step->step_type == MATCH_STEP)
+            {
+                if (!cache_valid_operand (count, &magic_step->match.offset_op))
+                    return FALSE;
+            }
+            else if (magic_step->step_type == READ_STEP)
+            {
+                if (!cache_valid_operand (count, &magic_step->read.offset_op) ||
+                    !cache_valid_slot (count, magic_step->read.var_slot,
+                                       magic_step->read.var_id != NULL))
+                    return FALSE;
+            }
+            else
+            {
+                return FALSE;
+            }
+        }
+    }
+
+    return TRUE;
+}
+
+static gboolean
+cache_valid_field_defs (const FormatDefinition *format_definition)
+{
+    FormatColor *color;
+    FieldDefinition *field_def;
+
+    GHashTableIter iter;
+
+    g_hash_table_iter_init (&iter, format_definition->colors);
+    while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &color))
+    {
+        if (color->color_index >= CHIRURGIEN_TOTAL_COLORS)
+            return FALSE;
+    }
+
+    g_hash_table_iter_init (&iter, format_definition->fields);
+    while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &field_def))
+    {
+        if (field_def->size_type > VALUE_SIZE ||
+            field_def->print > PRINT_LITERAL ||
+            field_def->encoding > ENCODING_ISO_8859_1)
+            return FALSE;
+    }
+
+    return TRUE;
+}
+
+static gboolean
+cache_valid_run_step (guint          count,
+                      const RunStep *run_step)
+{
+    switch (run_step->step_type)
+    {
+        case FIELD_STEP:
+        return run_step->field.field_def &&
+               cache_valid_slot (count, run_step->field.store_var_slot,
+                                 run_step->field.store_var != NULL) &&
+               cache_valid_operand (count, &run_step->field.navigation_op) &&
+               cache_valid_operand (count, &run_step->field.offset_op) &&
+               cache_valid_operand (count, &run_step->field.limit_op);
+        case MATCH_START_STEP:
+        return run_step->match.op <= OP_BIT &&
+               cache_valid_operand (count, &run_step->match.var_op);
+        case LOOP_START_STEP:
+        return cache_valid_operand (count, &run_step->loop.until_set_op) &&
+               cache_valid_operand (count, &run_step->loop.var_value_op) &&
+               cache_valid_operand (count, &run_step->loop.limit_op);
+        case PRINT_STEP:
+        return cache_valid_operand (count, &run_step->print.var_op);
+        case EXEC_STEP:
+        /* The executed variable is created in its slot when undefined */
+        return (run_step->exec.var_op.type == OPERAND_INDEX ||
+                (run_step->exec.var_op.type == OPERAND_VARIABLE &&
+                 cache_valid_slot (count, run_step->exec.var_op.slot, TRUE))) &&
+               cache_valid_operand (count, &run_step->exec.set_op) &&
+               cache_valid_operand (count, &run_step->exec.modulo_op) &&
+               cache_valid_operand (count, &run_step->exec.add_op) &&
+               cache_valid_operand (count, &run_step->exec.substract_op) &&
+               cache_valid_operand (count, &run_step->exec.multiply_op) &&
+               cache_valid_operand (count, &run_step->exec.divide_op);
+        case MATCH_END_STEP:
+        case SELECTION_START_STEP:
+        case SELECTION_END_STEP:
+        case LOOP_END_STEP:
+        case BLOCK_STEP:
+        case END_STEP:
+        return TRUE;
+        default:
+        return FALSE;
+    }
+}
+
+/*
+ * The processor trusts a definition the validator built, a cached definition
+ * must not index outside its run or its variables: checked after binding
+ */
+static gboolean
+cache_valid_definition (const FormatDefinition *format_definition)
+{
+    const RunStep *run_step;
+
+    if (format_definition->endianness > VARIABLE_ENDIANNESS ||
+        !cache_valid_slot (format_definition->variables_count,
+                           format_definition->endianness_slot, FALSE) ||
+        !cache_valid_magic (format_definition) ||
+        !cache_valid_field_defs (format_definition))
+        return FALSE;
+
+    /* Every sequence ends with an END_STEP, the last one too */
+    if (!format_definition->run_length ||
+        format_definition->run[format_definition->run_length - 1].step_type != END_STEP)
+        return FALSE;
+
+    for (guint i = 0; i < format_definition->run_length; i++)
+    {
+        run_step = &format_definition->run[i];
+
+        if (!cache_valid_run_step (format_definition->variables_count, run_step))
+            return FALSE;
+
+        /* A block without steps has no jump */
+        if (run_step->jump >= format_definition->run_length &&
+            !(run_step->step_type == BLOCK_STEP && run_step->jump == G_MAXUINT))
+            return FALSE;
+    }
+
+    return TRUE;
+}
+
+/* Identifies the build that wrote a cache, a cache from another build is not loaded */
+static gboolean
+cache_build_identity (CacheStream *stream)
+{
+    g_autofree gchar *version = NULL;
+
+    if (stream->output)
+    {
+        cache_string (stream, (gchar *) VERSION);
+        cache_uint (stream, sizeof (RunStep));
+        cache_uint (stream, sizeof (MagicStep));
+        cache_uint (stream, sizeof (FieldDefinition));
+        cache_uint (stream, sizeof (FormatDefinition));
+
+        return TRUE;
+    }
+
+    version = cache_string (stream, NULL);
+
+    return !g_strcmp0 (version, VERSION) &&
+           cache_uint (stream, 0) == sizeof (RunStep) &&
+           cache_uint (stream, 0) == sizeof (MagicStep) &&
+           cache_uint (stream, 0) == sizeof (FieldDefinition) &&
+           cache_uint (stream, 0) == sizeof (FormatDefinition) &&
+           !stream->failed;
+}
+
+/* The cached definition of a text is named after the text's checksum */
+static gchar *
+cache_get_path (const gchar *checksum)
+{
+    g_autofree gchar *file_name = NULL;
+
+    file_name = g_strdup_printf ("%s.bin", checksum);
+
+    return g_build_filename (g_get_user_cache_dir (), "chirurgien", "formats", file_name, NULL);
+}
+
+/*
+ * Loads the cached definition of a format definition text
+ * Returns NULL if there is no valid cached definition
+ */
+FormatDefinition *
+validator_cache_load (const gchar *format_definition_text,
+                      gsize        format_definition_size)
+{
+    FormatDefinition *format_definition;
+    CacheStream stream = { 0 };
+
+    g_autoptr (GMappedFile) cache_file = NULL;
+    g_autofree gchar *checksum = NULL;
+    g_autofree gchar *cache_path = NULL;
+    g_autofree gchar *cached_checksum = NULL;
+
+    checksum = g_compute_checksum_for_data (G_CHECKSUM_SHA256,
+                                            (const guchar *) format_definition_text,
+                                            format_definition_size);
+    cache_path = cache_get_path (checksum);
+
+    if (!(cache_file = g_mapped_file_new (cache_path, FALSE, NULL)))
+        return NULL;
+
+    stream.input = (const guchar *) g_mapped_file_get_contents (cache_file);
+    stream.input_size = g_mapped_file_get_length (cache_file);
+
+    /* Header: magic, version, build and the checksum of the text */
+    if (stream.input_size < sizeof (CACHE_MAGIC) ||
+        memcmp (stream.input, CACHE_MAGIC, sizeof (CACHE_MAGIC)))
+        return NULL;
+
+    stream.position = sizeof (CACHE_MAGIC);
+
+    if (cache_uint (&stream, 0) != CACHE_VERSION ||
+        !cache_build_identity (&stream))
+        return NULL;
+
+    cached_checksum = cache_string (&stream, NULL);
+
+    if (g_strcmp0 (cached_checksum, checksum))
+        return NULL;
+
+    format_definition = format_definition_create ();
+
+    cache_definition (&stream, format_definition);
+
+    if (stream.failed || stream.position != stream.input_size)
+    {
+        format_definition_destroy (format_definition);
+        return NULL;
+    }
+
+    validator_program_bind (format_definition);
+
+    if (!cache_valid_definition (format_definition))
+    {
+        format_definition_destroy (format_definition);
+        return NULL;
+    }
+
+    return format_definition;
+}
+
+/*
+ * Caches a validated format definition, under the checksum of its text
+ * Failing to write the cache is not an error
+ */
+void
+validator_cache_store (const gchar            *format_definition_text,
+                       gsize                   format_definition_size,
+                       const FormatDefinition *format_definition)
+{
+    CacheStream stream = { 0 };
+
+    g_autofree gchar *checksum = NULL;
+    g_autofree gchar *cache_path = NULL;
+    g_autofree gchar *cache_dir = NULL;
+
+    /* Would be rejected when loaded, e.g. a field step without a field definition */
+    if (!cache_valid_definition (format_definition))
+        return;
+
+    checksum = g_compute_checksum_for_data (G_CHECKSUM_SHA256,
+                                            (const guchar *) format_definition_text,
+                                            format_definition_size);
+    cache_path = cache_get_path (checksum);
+    cache_dir = g_path_get_dirname (cache_path);
+
+    if (g_mkdir_with_parents (cache_dir, 0700))
+        return;
+
+    stream.output = g_byte_array_new ();
+
+    g_byte_array_append (stream.output, (const guint8 *) CACHE_MAGIC, sizeof (CACHE_MAGIC));
+    cache_uint (&stream, CACHE_VERSION);
+    cache_build_identity (&stream);
+    cache_string (&stream, checksum);
+
+    cache_definition (&stream, (FormatDefinition *) format_definition);
+
+    /* Written to a temporary file and renamed, readers never see a partial cache */
+    g_file_set_contents (cache_path,
+                         (const gchar *) stream.output->data,
+                         stream.output->len,
+                         NULL);
+
+    g_byte_array_unref (stream.output);
+}
@@ -0,0 +1,398 @@
+/* validator-program.c
+ *
+ * Copyright (C) 2021 - Daniel Léonard Schardijn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "validator.h"
+
+
+/*
+ * Moves a list of RunSteps into the program array, starting at step_index,
+ * and terminates the sequence with an END_STEP
+ * The list is left holding NULL pointers
+ * Returns the index following the END_STEP
+ */
+static guint
+program_append_sequence (RunStep *program,
+                         guint    step_index,
+                         GSList  *run_steps)
+{
+    RunStep *run_step;
+
+    for (GSList *run_iter = run_steps;
+         run_iter;
+         run_iter = run_iter->next)
+    {
+        run_step = run_iter->data;
+
+        program[step_index++] = *run_step;
+
+        g_slice_free (RunStep, run_step);
+        run_iter->data = NULL;
+    }
+
+    program[step_index].step_type = END_STEP;
+
+    return step_index + 1;
+}
+
+/*
+ * Resolves the jumps of the sequence between first_step and end_step (its END_STEP)
+ */
+static void
+program_resolve_jumps (RunStep *program,
+                       guint    first_step,
+                       guint    end_step)
+{
+    RunStep *run_step;
+
+    GArray *start_steps, *selection_steps;
+    guint start_index;
+
+    start_steps = g_array_new (FALSE, FALSE, sizeof (guint));
+    selection_steps = g_array_new (FALSE, FALSE, sizeof (guint));
+
+    for (guint i = first_step; i < end_step; i++)
+    {
+        run_step = &program[i];
+
+        switch (run_step->step_type)
+        {
+            case MATCH_START_STEP:
+            case LOOP_START_STEP:
+            g_array_append_val (start_steps, i);
+
+            break;
+            case SELECTION_START_STEP:
+            g_array_append_val (start_steps, i);
+            g_array_append_val (selection_steps, i);
+
+            break;
+            case SELECTION_END_STEP:
+            g_array_set_size (selection_steps, selection_steps->len - 1);
+            /* Fall through */
+            case MATCH_END_STEP:
+            case LOOP_END_STEP:
+            start_index = g_array_index (start_steps, guint, start_steps->len - 1);
+            g_array_set_size (start_steps, start_steps->len - 1);
+
+            program[start_index].jump = i;
+            run_step->jump = start_index;
+
+            /* Temporarily point to the enclosing selection start, resolved below */
+            if (run_step->step_type == MATCH_END_STEP)
+            {
+                if (selection_steps->len)
+                    run_step->jump = g_array_index (selection_steps, guint, selection_steps->len - 1);
+                else
+                    run_step->jump = end_step;
+            }
+
+            break;
+            default:
+            break;
+        }
+    }
+
+    /* The selection start steps now know their end step */
+    for (guint i = first_step; i < end_step; i++)
+    {
+        run_step = &program[i];
+
+        if (run_step->step_type == MATCH_END_STEP &&
+            run_step->jump != end_step)
+        {
+            run_step->jump = program[run_step->jump].jump;
+        }
+    }
+
+    g_array_free (start_steps, TRUE);
+    g_array_free (selection_steps, TRUE);
+}
+
+/*
+ * Returns the slot of a variable name, G_MAXUINT if the name is never stored
+ */
+static guint
+program_variable_slot (GHashTable  *slots,
+                       const gchar *name)
+{
+    gpointer slot;
+
+    if (name && g_hash_table_lookup_extended (slots, name, NULL, &slot))
+        return GPOINTER_TO_UINT (slot);
+
+    return G_MAXUINT;
+}
+
+/*
+ * Resolves a step attribute into an operand
+ * index_allowed: the special "index" value refers to the file index
+ */
+static void
+program_resolve_operand (GHashTable  *slots,
+                         const gchar *name,
+                         gboolean     index_allowed,
+                         Operand     *operand)
+{
+    *operand = (Operand) { 0 };
+
+    if (!name)
+        return;
+
+    if (index_allowed && !g_strcmp0 (name, "index"))
+    {
+        operand->type = OPERAND_INDEX;
+        return;
+    }
+
+    /* A variable that is undefined is read as a number */
+    operand->slot = program_variable_slot (slots, name);
+    operand->immediate = g_ascii_strtoull (name, NULL, 10);
+
+    if (operand->slot != G_MAXUINT)
+        operand->type = OPERAND_VARIABLE;
+    else
+        operand->type = OPERAND_IMMEDIATE;
+}
+
+static void
+program_intern_name (GHashTable       *slots,
+                     FormatDefinition *format_definition,
+                     const gchar      *name)
+{
+    if (name && !g_hash_table_contains (slots, name))
+    {
+        g_hash_table_insert (slots,
+                             (gpointer) name,
+                             GUINT_TO_POINTER (format_definition->variables_count));
+        format_definition->variables_count++;
+    }
+}
+
+/*
+ * Interns every stored variable name into a dense slot number
+ * and resolves all variable references to their slots
+ */
+static void
+program_intern_variables (FormatDefinition *format_definition)
+{
+    GHashTable *slots;
+    MagicStep *magic_step;
+    RunStep *run_step;
+
+    slots = g_hash_table_new (g_str_hash, g_str_equal);
+
+    /* Only stored variables get a slot, any other name is never defined */
+    for (GSList *magic = format_definition->magic;
+         magic;
+         magic = magic->next)
+    {
+        for (GSList *magic_iter = magic->data;
+             magic_iter;
+             magic_iter = magic_iter->next)
+        {
+            magic_step = magic_iter->data;
+
+            if (magic_step->step_type == READ_STEP)
+                program_intern_name (slots, format_definition, magic_step->read.var_id);
+        }
+    }
+
+    /* Resolved before the run's variables are interned, identification only has the magic's slots */
+    for (GSList *magic = format_definition->magic;
+         magic;
+         magic = magic->next)
+    {
+        for (GSList *magic_iter = magic->data;
+             magic_iter;
+             magic_iter = magic_iter->next)
+        {
+            magic_step = magic_iter->data;
+
+            if (magic_step->step_type == MATCH_STEP)
+            {
+                program_resolve_operand (slots, magic_step->match.offset, FALSE, &magic_step->match.offset_op);
+            }
+            else if (magic_step->step_type == READ_STEP)
+            {
+                program_resolve_operand (slots, magic_step->read.offset, FALSE, &magic_step->read.offset_op);
+                magic_step->read.var_slot = program_variable_slot (slots, magic_step->read.var_id);
+            }
+        }
+    }
+
+    format_definition->magic_variables_count = format_definition->variables_count;
+    format_definition->magic_endianness_slot = program_variable_slot (slots,
+                                                                      format_definition->endianness_var);
+
+    for (guint i = 0; i < format_definition->run_length; i++)
+    {
+        run_step = &format_definition->run[i];
+
+        if (run_step->step_type == FIELD_STEP)
+            program_intern_name (slots, format_definition, run_step->field.store_var);
+        else if (run_step->step_type == EXEC_STEP &&
+                 g_strcmp0 (run_step->exec.var_id, "index"))
+            program_intern_name (slots, format_definition, run_step->exec.var_id);
+    }
+
+    format_definition->endianness_slot = program_variable_slot (slots,
+                                                                format_definition->endianness_var);
+
+    for (guint i = 0; i < format_definition->run_length; i++)
+    {
+        run_step = &format_definition->run[i];
+
+        switch (run_step->step_type)
+        {
+            case FIELD_STEP:
+            run_step->field.store_var_slot = program_variable_slot (slots, run_step->field.store_var);
+            program_resolve_operand (slots, run_step->field.navigation, FALSE, &run_step->field.navigation_op);
+            program_resolve_operand (slots, run_step->field.offset, FALSE, &run_step->field.offset_op);
+            program_resolve_operand (slots, run_step->field.limit, FALSE, &run_step->field.limit_op);
+
+            break;
+            case MATCH_START_STEP:
+            program_resolve_operand (slots, run_step->match.var_id, FALSE, &run_step->match.var_op);
+
+            break;
+            case LOOP_START_STEP:
+            program_resolve_operand (slots, run_step->loop.until_set, FALSE, &run_step->loop.until_set_op);
+            program_resolve_operand (slots, run_step->loop.var_value, FALSE, &run_step->loop.var_value_op);
+            program_resolve_operand (slots, run_step->loop.limit, FALSE, &run_step->loop.limit_op);
+
+            break;
+            case PRINT_STEP:
+            program_resolve_operand (slots, run_step->print.var_id, FALSE, &run_step->print.var_op);
+
+            break;
+            case EXEC_STEP:
+            program_resolve_operand (slots, run_step->exec.var_id, TRUE, &run_step->exec.var_op);
+            program_resolve_operand (slots, run_step->exec.set, TRUE, &run_step->exec.set_op);
+            program_resolve_operand (slots, run_step->exec.modulo, FALSE, &run_step->exec.modulo_op);
+            program_resolve_operand (slots, run_step->exec.add, FALSE, &run_step->exec.add_op);
+            program_resolve_operand (slots, run_step->exec.substract, FALSE, &run_step->exec.substract_op);
+            program_resolve_operand (slots, run_step->exec.multiply, FALSE, &run_step->exec.multiply_op);
+            program_resolve_operand (slots, run_step->exec.divide, FALSE, &run_step->exec.divide_op);
+
+            break;
+            default:
+            break;
+        }
+    }
+
+    g_hash_table_destroy (slots);
+}
+
+/*
+ * Binds field steps to their field definitions, and field definitions to their colors
+ */
+void
+validator_program_bind (FormatDefinition *format_definition)
+{
+    FieldDefinition *field_def;
+    RunStep *run_step;
+
+    GHashTableIter iter;
+
+    g_hash_table_iter_init (&iter, format_definition->fields);
+    while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &field_def))
+    {
+        field_def->color_def = field_def->color ?
+                               g_hash_table_lookup (format_definition->colors,
+                                                    field_def->color) :
+                               NULL;
+    }
+
+    for (guint i = 0; i < format_definition->run_length; i++)
+    {
+        run_step = &format_definition->run[i];
+
+        if (run_step->step_type == FIELD_STEP)
+        {
+            run_step->field.field_def = g_hash_table_lookup (format_definition->fields,
+                                                             run_step->field.field_id);
+            run_step->field.additional_color_def = run_step->field.additional_color ?
+                                                   g_hash_table_lookup (format_definition->colors,
+                                                                        run_step->field.additional_color) :
+                                                   NULL;
+        }
+    }
+}
+
+/*
+ * Compiles the run section and the blocks into the format definition's
+ * flat RunStep array, resolving all step jumps
+ */
+void
+validator_program_build (ParserControl *parser_control)
+{
+    FormatDefinition *format_definition;
+    RunStep *program;
+
+    GHashTable *block_starts;
+    GHashTableIter iter;
+    gpointer block_id, block_steps;
+
+    guint program_length, step_index, first_step, block_start;
+
+    format_definition = parser_control->definition;
+
+    /* The run section and each block are followed by an END_STEP */
+    program_length = g_slist_length (parser_control->run) + 1;
+
+    g_hash_table_iter_init (&iter, parser_control->blocks);
+    while (g_hash_table_iter_next (&iter, NULL, &block_steps))
+        program_length += g_slist_length (block_steps) + 1;
+
+    program = g_new0 (RunStep, program_length);
+    block_starts = g_hash_table_new (g_str_hash, g_str_equal);
+
+    step_index = program_append_sequence (program, 0, parser_control->run);
+    program_resolve_jumps (program, 0, step_index - 1);
+
+    /* Index 0 is always the run section, a block never starts at 0 */
+    g_hash_table_iter_init (&iter, parser_control->blocks);
+    while (g_hash_table_iter_next (&iter, &block_id, &block_steps))
+    {
+        first_step = step_index;
+
+        g_hash_table_insert (block_starts, block_id, GUINT_TO_POINTER (first_step));
+
+        step_index = program_append_sequence (program, step_index, block_steps);
+        program_resolve_jumps (program, first_step, step_index - 1);
+    }
+
+    /* Resolve block steps */
+    for (guint i = 0; i < program_length; i++)
+    {
+        if (program[i].step_type == BLOCK_STEP)
+        {
+            block_start = GPOINTER_TO_UINT (g_hash_table_lookup (block_starts,
+                                                                 program[i].block.block_id));
+            program[i].jump = block_start ? block_start : G_MAXUINT;
+        }
+    }
+
+    g_hash_table_destroy (block_starts);
+
+    format_definition->run = program;
+    format_definition->run_length = program_length;
+
+    program_intern_variables (format_definition);
+    validator_program_bind (format_definition);
+}
@@ -108,7 +108,7 @@ validator_utils_prefix_attr_error (GMarkupParseContext *context,
     g_prefix_error (error, "Error on line %d char %d: ", line, character);
 }
 
-static void
+void
 run_steps_destroy (gpointer data)
 {
     GSList *run_steps;
@@ -121,13 +121,15 @@ run_steps_destroy (gpointer data)
 FormatDefinition *
 format_definition_create (void)
 {
+    static gint serial = 0;
+
     FormatDefinition *format_definition;
 
     format_definition = g_slice_new0 (FormatDefinition);
+    format_definition->ref_count = 1;
+    format_definition->serial = (guint) g_atomic_int_add (&serial, 1);
     format_definition->colors = g_hash_table_new_full (g_str_hash, g_str_equal,
                                                        g_free, format_color_destroy);
-    format_definition->blocks = g_hash_table_new_full (g_str_hash, g_str_equal,
-                                                       g_free, run_steps_destroy);
     format_definition->fields = g_hash_table_new_full (g_str_hash, g_str_equal,
                                                        g_free, field_def_destroy);
 
@@ -152,13 +154,32 @@ format_definition_destroy (FormatDefinition *format_definition)
     }
     g_slist_free (format_definition->magic);
     g_hash_table_destroy (format_definition->colors);
-    g_slist_free_full (format_definition->run, run_step_destroy);
-    g_hash_table_destroy (format_definition->blocks);
+    for (guint i = 0; i < format_definition->run_length; i++)
+        run_step_clear (&format_definition->run[i]);
+    g_free (format_definition->run);
     g_hash_table_destroy (format_definition->fields);
+    if (format_definition->source)
+        g_bytes_unref (format_definition->source);
 
     g_slice_free (FormatDefinition, format_definition);
 }
 
+FormatDefinition *
+format_definition_ref (FormatDefinition *format_definition)
+{
+    g_atomic_int_inc (&format_definition->ref_count);
+
+    return format_definition;
+}
+
+/* A format removed from the format lists is destroyed once no analysis uses it */
+void
+format_definition_unref (FormatDefinition *format_definition)
+{
+    if (format_definition && g_atomic_int_dec_and_test (&format_definition->ref_count))
+        format_definition_destroy (format_definition);
+}
+
 void
 format_color_destroy (gpointer data)
 {
@@ -198,6 +219,55 @@ magic_step_destroy (gpointer data)
     }
 }
 
+void
+run_step_clear (RunStep *run_step)
+{
+    if (run_step->step_type == FIELD_STEP)
+    {
+        g_free (run_step->field.field_id);
+        g_free (run_step->field.store_var);
+        g_free (run_step->field.navigation);
+        g_free (run_step->field.offset);
+        g_free (run_step->field.additional_color);
+        g_free (run_step->field.tab);
+        g_free (run_step->field.section);
+        g_free (run_step->field.limit);
+    }
+    else if (run_step->step_type == MATCH_START_STEP)
+    {
+        g_free (run_step->match.var_id);
+        g_free (run_step->match.value);
+    }
+    else if (run_step->step_type == LOOP_START_STEP)
+    {
+        g_free (run_step->loop.until_set);
+        g_free (run_step->loop.var_value);
+        g_free (run_step->loop.limit);
+    }
+    else if (run_step->step_type == PRINT_STEP)
+    {
+        g_free (run_step->print.line);
+        g_free (run_step->print.tooltip);
+        g_free (run_step->print.var_id);
+        g_free (run_step->print.section);
+        g_free (run_step->print.tab);
+    }
+    else if (run_step->step_type == EXEC_STEP)
+    {
+        g_free (run_step->exec.var_id);
+        g_free (run_step->exec.set);
+        g_free (run_step->exec.modulo);
+        g_free (run_step->exec.add);
+        g_free (run_step->exec.substract);
+        g_free (run_step->exec.multiply);
+        g_free (run_step->exec.divide);
+    }
+    else if (run_step->step_type == BLOCK_STEP)
+    {
+        g_free (run_step->block.block_id);
+    }
+}
+
 void
 run_step_destroy (gpointer data)
 {
@@ -207,45 +277,7 @@ run_step_destroy (gpointer data)
 
     if (run_step)
     {
-        if (run_step->step_type == FIELD_STEP)
-        {
-            g_free (run_step->field.field_id);
-            g_free (run_step->field.store_var);
-            g_free (run_step->field.navigation);
-            g_free (run_step->field.offset);
-            g_free (run_step->field.additional_color);
-            g_free (run_step->field.tab);
-            g_free (run_step->field.section);
-            g_free (run_step->field.limit);
-        }
-        else if (run_step->step_type == MATCH_START_STEP)
-        {
-            g_free (run_step->match.var_id);
-            g_free (run_step->match.value);
-        }
-        else if (run_step->step_type == LOOP_START_STEP)
-        {
-            g_free (run_step->loop.until_set);
-            g_free (run_step->loop.var_value);
-            g_free (run_step->loop.limit);
-        }
-        else if (run_step->step_type == PRINT_STEP)
-        {
-            g_free (run_step->print.line);
-            g_free (run_step->print.tooltip);
-            g_free (run_step->print.var_id);
-            g_free (run_step->print.section);
-            g_free (run_step->print.tab);
-        }
-        else if (run_step->step_type == EXEC_STEP)
-        {
-            g_free (run_step->exec.var_id);
-            g_free (run_step->exec.set);
-            g_free (run_step->exec.add);
-            g_free (run_step->exec.substract);
-            g_free (run_step->exec.multiply);
-            g_free (run_step->exec.divide);
-        }
+        run_step_clear (run_step);
 
         g_slice_free (RunStep, run_step);
     }
@@ -46,7 +46,9 @@ void                  format_definition_destroy             (FormatDefinition *)
 
 void                  format_color_destroy                  (gpointer);
 void                  magic_step_destroy                    (gpointer);
+void                  run_step_clear                        (RunStep *);
 void                  run_step_destroy                      (gpointer);
+void                  run_steps_destroy                     (gpointer);
 void                  field_def_destroy                     (gpointer);
 
 G_END_DECLS
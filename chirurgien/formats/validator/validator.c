@@ -21,9 +21,15 @@
 #include "validator.h"
 
 
-FormatDefinition *
-format_validate (const gchar *format_definition_text,
+/*
+ * Parses and validates a format definition text
+ * header_only: only the header, endianness and magic are validated,
+ * the other sections are skipped
+ */
+static FormatDefinition *
+validator_parse (const gchar *format_definition_text,
                  gsize        format_definition_size,
+                 gboolean     header_only,
                  GError     **return_error)
 {
     FormatDefinition *format_definition;
@@ -36,6 +42,9 @@ format_validate (const gchar *format_definition_text,
     format_definition = format_definition_create ();
 
     parser_control.definition = format_definition;
+    parser_control.header_only = header_only;
+    parser_control.blocks = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                                   g_free, run_steps_destroy);
 
     parse_context = g_markup_parse_context_new (&root_parser,
                                                 G_MARKUP_IGNORE_QUALIFIED |
@@ -52,6 +61,9 @@ format_validate (const gchar *format_definition_text,
         g_markup_parse_context_end_parse (parse_context,
                                           &error);
 
+    if (!error)
+        validator_program_build (&parser_control);
+
     if (error)
     {
         format_definition_destroy (g_steal_pointer (&format_definition));
@@ -64,9 +76,148 @@ format_validate (const gchar *format_definition_text,
     /* Final clean-up */
     g_slist_free_full (parser_control.magic_steps, magic_step_destroy);
     g_slist_free_full (parser_control.run_steps, run_step_destroy);
+    g_slist_free_full (parser_control.run, run_step_destroy);
+    g_hash_table_destroy (parser_control.blocks);
     g_free (parser_control.current_block_id);
 
     g_markup_parse_context_free (parse_context);
 
     return format_definition;
 }
+
+FormatDefinition *
+format_validate (const gchar *format_definition_text,
+                 gsize        format_definition_size,
+                 GError     **return_error)
+{
+    FormatDefinition *format_definition;
+
+    /* Definitions validated by a previous run are cached */
+    format_definition = validator_cache_load (format_definition_text,
+                                              format_definition_size);
+
+    if (format_definition)
+        return format_definition;
+
+    format_definition = validator_parse (format_definition_text,
+                                         format_definition_size,
+                                         FALSE,
+                                         return_error);
+
+    if (format_definition)
+        validator_cache_store (format_definition_text,
+                               format_definition_size,
+                               format_definition);
+
+    return format_definition;
+}
+
+/*
+ * Validates the header, endianness and magic of a format definition,
+ * enough to identify files; the rest is validated by format_complete
+ * A cached definition is loaded complete
+ */
+FormatDefinition *
+format_validate_header (GBytes  *format_definition_bytes,
+                        GError **return_error)
+{
+    FormatDefinition *format_definition;
+
+    const gchar *format_definition_text;
+    gsize format_definition_size;
+
+    format_definition_text = g_bytes_get_data (format_definition_bytes,
+                                               &format_definition_size);
+
+    format_definition = validator_cache_load (format_definition_text,
+                                              format_definition_size);
+
+    if (format_definition)
+        return format_definition;
+
+    format_definition = validator_parse (format_definition_text,
+                                         format_definition_size,
+                                         TRUE,
+                                         return_error);
+
+    if (format_definition)
+        format_definition->source = g_bytes_ref (format_definition_bytes);
+
+    return format_definition;
+}
+
+/*
+ * Validates the rest of a format definition created by format_validate_header,
+ * once, the first time it is needed
+ * Only the sections that were skipped are replaced, the magic is kept as
+ * concurrent identifications may be using it: these only read the magic's
+ * slot count and endianness slot, which are the same in both definitions
+ */
+void
+format_complete (FormatDefinition *format_definition)
+{
+    static GMutex complete_lock;
+
+    FormatDefinition *complete_definition;
+    GBytes *source;
+
+    GHashTable *table;
+    RunStep *run;
+    guint run_length;
+
+    const gchar *format_definition_text;
+    gsize format_definition_size;
+
+    GError *error = NULL;
+
+    if (!g_atomic_pointer_get (&format_definition->source))
+        return;
+
+    g_mutex_lock (&complete_lock);
+
+    source = format_definition->source;
+
+    if (source)
+    {
+        format_definition_text = g_bytes_get_data (source, &format_definition_size);
+
+        complete_definition = format_validate (format_definition_text,
+                                               format_definition_size,
+                                               &error);
+
+        if (complete_definition)
+        {
+            format_definition->endianness_slot = complete_definition->endianness_slot;
+            format_definition->variables_count = complete_definition->variables_count;
+
+            /* The skipped sections are destroyed with the complete definition */
+            table = format_definition->colors;
+            format_definition->colors = complete_definition->colors;
+            complete_definition->colors = table;
+
+            table = format_definition->fields;
+            format_definition->fields = complete_definition->fields;
+            complete_definition->fields = table;
+
+            run = format_definition->run;
+            run_length = format_definition->run_length;
+            format_definition->run = complete_definition->run;
+            format_definition->run_length = complete_definition->run_length;
+            complete_definition->run = run;
+            complete_definition->run_length = run_length;
+
+            format_definition_destroy (complete_definition);
+        }
+        else
+        {
+            g_warning ("Format definition '%s' failed to validate: %s",
+                       format_definition->format_name, error->message);
+            g_error_free (error);
+        }
+
+        g_atomic_pointer_set (&format_definition->source, NULL);
+        g_bytes_unref (source);
+    }
+
+    g_mutex_unlock (&complete_lock);
+}
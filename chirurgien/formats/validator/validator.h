@@ -44,6 +44,11 @@ typedef struct
     /* Current run steps list being built */
     GSList              *run_steps;
 
+    /* The run section's list of RunSteps */
+    GSList              *run;
+    /* Associative array of reusable blocks of RunSteps */
+    GHashTable          *blocks;
+
     /* XML section flags */
     gboolean             format_root_found;
     SubparserState       endianness_state;
@@ -73,6 +78,9 @@ typedef struct
     /* If the field has a fixed set of possible values */
     gboolean             field_has_options;
 
+    /* Only the header, endianness and magic are validated */
+    gboolean             header_only;
+
 } ParserControl;
 
 /* Format definition parsers */
@@ -83,5 +91,17 @@ extern GMarkupParser colors_parser;
 extern GMarkupParser run_parser;
 extern GMarkupParser run_blocks_parser;
 extern GMarkupParser field_defs_parser;
+extern GMarkupParser skip_parser;
+
+/* Run steps compilation */
+void                  validator_program_build    (ParserControl *);
+void                  validator_program_bind     (FormatDefinition *);
+
+/* Binary cache of validated format definitions */
+FormatDefinition *    validator_cache_load       (const gchar *,
+                                                  gsize);
+void                  validator_cache_store      (const gchar *,
+                                                  gsize,
+                                                  const FormatDefinition *);
 
 G_END_DECLS
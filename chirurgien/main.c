@@ -17,10 +17,14 @@
  */
 
 #include "chirurgien-application.h"
+#include "chirurgien-cli.h"
 
 
 gint
 main (gint argc, gchar *argv[])
 {
+    if (chirurgien_cli_requested (argc, argv))
+        return chirurgien_cli_run (argc, argv);
+
     return g_application_run (G_APPLICATION (chirurgien_application_new ()), argc, argv);
 }